@@ -1,6 +1,7 @@
 #include "CameraMovementComponent.h"
 
 #include "ClimbComponent.h"
+#include "DeftBakedCurve.h"
 #include "DeftCharacterMovementComponent.h"
 #include "DeftPlayerCharacter.h"
 #include "DeftLocks.h"
@@ -33,6 +34,8 @@ UCameraMovementComponent::UCameraMovementComponent()
 	, DeftCharacter(nullptr)
 	, DeftMovementComponent(nullptr)
 	, CameraTarget(nullptr)
+	, WalkBobbleCurveBaked(nullptr)
+	, LandedFromAirDipCurveBaked(nullptr)
 	, PreviousInputVector(FVector2D::ZeroVector)
 	, WalkBobbleTime(0.f)
 	, WalkBobbleMaxTime(0.f)
@@ -93,10 +96,11 @@ void UCameraMovementComponent::BeginPlay()
 	}
 
 	// Bobble Setup
-	if (WalkBobbleCurve)
+	WalkBobbleCurveBaked = FDeftBakedCurve::FindOrBake(WalkBobbleCurve);
+	if (WalkBobbleCurveBaked.IsValid())
 	{
 		float unusedMin;
-		WalkBobbleCurve->GetTimeRange(unusedMin, WalkBobbleMaxTime);
+		WalkBobbleCurveBaked->GetTimeRange(unusedMin, WalkBobbleMaxTime);
 	}
 	else
 		UE_LOG(LogTemp, Error, TEXT("Walk Bobble curve is invalid"));
@@ -114,10 +118,11 @@ void UCameraMovementComponent::BeginPlay()
 	UnrollLerpTimeMax = 0.1f;
 
 	// Land Dip setup
-	if (LandedFromAirDipCuve)
+	LandedFromAirDipCurveBaked = FDeftBakedCurve::FindOrBake(LandedFromAirDipCuve);
+	if (LandedFromAirDipCurveBaked.IsValid())
 	{
 		float unusedMin;
-		LandedFromAirDipCuve->GetTimeRange(unusedMin, DipLerpTimeMax);
+		LandedFromAirDipCurveBaked->GetTimeRange(unusedMin, DipLerpTimeMax);
 	}
 	else
 		UE_LOG(LogTemp, Error, TEXT("Landed From Air Dip curve is invalid"));
@@ -170,7 +175,7 @@ void UCameraMovementComponent::TickComponent(float DeltaTime, ELevelTick TickTyp
 
 void UCameraMovementComponent::ProcessCameraBobble(float aDeltaTime)
 {
-	if (!WalkBobbleCurve)
+	if (!WalkBobbleCurveBaked.IsValid())
 		return;
 
 	if (!CameraTarget.IsValid())
@@ -205,7 +210,7 @@ void UCameraMovementComponent::ProcessCameraBobble(float aDeltaTime)
 	}
 
 	WalkBobbleTime += aDeltaTime;
-	const float bobbleCurveVal = WalkBobbleCurve->GetFloatValue(WalkBobbleTime);
+	const float bobbleCurveVal = WalkBobbleCurveBaked->Eval(WalkBobbleTime);
 	const float bobbleCurveValDelta = bobbleCurveVal - PrevWalkBobbleVal;
 
 	PrevWalkBobbleVal = bobbleCurveVal;
@@ -329,7 +334,7 @@ void UCameraMovementComponent::ProcessCameraDip(float aDeltaTime)
 	if (DeftLocks::IsCameraMovementDipLocked())
 		return;
 
-	if (!CameraTarget.IsValid())
+	if (!CameraTarget.IsValid() || !LandedFromAirDipCurveBaked.IsValid())
 		return;
 
 	const float prevDipLerpTime = DipLerpTime;
@@ -348,7 +353,7 @@ void UCameraMovementComponent::ProcessCameraDip(float aDeltaTime)
 		}
 	}
 
-	const float dipCurveVal = LandedFromAirDipCuve->GetFloatValue(DipLerpTime);
+	const float dipCurveVal = LandedFromAirDipCurveBaked->Eval(DipLerpTime);
 	const float dipCurveValDelta = dipCurveVal - PrevDipVal;
 
 	PrevDipVal = dipCurveVal;
@@ -60,6 +60,9 @@ private:
 	TWeakObjectPtr<class UDeftCharacterMovementComponent> DeftMovementComponent;
 	TWeakObjectPtr<class USceneComponent> CameraTarget;
 
+	TSharedPtr<const struct FDeftBakedCurve> WalkBobbleCurveBaked;
+	TSharedPtr<const struct FDeftBakedCurve> LandedFromAirDipCurveBaked;
+
 	FVector2D PreviousInputVector;
 
 	// Bobble
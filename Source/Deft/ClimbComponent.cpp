@@ -2,19 +2,21 @@
 
 #include "Components/CapsuleComponent.h"
 #include "Components/SceneComponent.h"
+#include "DeftBakedCurve.h"
 #include "DeftCharacterMovementComponent.h"
+#include "DeftLedgeGraph.h"
 #include "DeftPlayerCharacter.h"
 #include "DeftLocks.h"
+#include "DeftRootMotionSources.h"
 #include "GameFramework/SpringArmComponent.h"
-#include "Kismet/KismetSystemLibrary.h"
 
+TAutoConsoleVariable<bool> CVar_Feature_LedgeGraph(TEXT("deft.feature.ledgeGraph"), true, TEXT("ledge ups use the level's baked ledge graph when there is one"), ECVF_Cheat);
+TAutoConsoleVariable<bool> CVar_Feature_LedgeProbes(TEXT("deft.feature.ledgeProbes"), true, TEXT("probe for ledges with best effort scene queries while in the air so a ledge up doesn't have to query anything itself"), ECVF_Cheat);
 TAutoConsoleVariable<bool> CVar_DebugLedgeUp(TEXT("deft.debug.climb.ledgeup"), false, TEXT("draw debugging for ledgeup"), ECVF_Cheat);
 
 UClimbComponent::UClimbComponent()
 	: OnLedgeUpDelegate()
 	, LedgeUpHeightBoostCurve(nullptr)
-	, CollisionQueryParams()
-	, CapsuleCollisionShape()
 	, LedgeUpFinalLocation(FVector::ZeroVector)
 	, LedgeUpStartLocation(FVector::ZeroVector)
 	, DeftCharacter(nullptr)
@@ -28,18 +30,47 @@ UClimbComponent::UClimbComponent()
 	, LedgeUpHeightBoostMax(0.f)
 	, LedgeUpDipDelay(0.f)
 	, LedgeUpDipDelayMax(0.f)
+	, LedgeUpRootMotionID((uint16)ERootMotionSourceID::Invalid)
+	, LedgeUpHeightBoostCurveBaked(nullptr)
+	, LedgeProbeStage(ELedgeProbeStage::None)
+	, LedgeProbeQueryID(0)
+	, LedgeProbeSurfaceQueryID(0)
+	, LedgeProbeHeightResult()
+	, LedgeProbeSurfaceResult()
+	, LedgeProbeQueryPriority(0)
+	, LedgeProbeOrigin(FVector::ZeroVector)
+	, LedgeProbeForward(FVector::ZeroVector)
+	, LedgeProbeHeightEnd(FVector::ZeroVector)
+	, bHasLedgeProbeResult(false)
+	, bLedgeProbeFoundLedge(false)
+	, LedgeProbeResultTime(0.f)
+	, LedgeProbeResultOrigin(FVector::ZeroVector)
+	, LedgeProbeResultForward(FVector::ZeroVector)
+	, LedgeProbeResultDestination(FVector::ZeroVector)
+	, LedgeProbeResultSurfaceActor(nullptr)
+	, LedgeRoomQueryParams()
+	, LedgeRoomIgnoredActor(nullptr)
+	, LedgeProbeMaxAge(0.f)
+	, LedgeProbeMaxDrift(0.f)
+	, LedgeProbeMinFacing(0.f)
 	, bIsLedgeUpActive(false)
 {
 	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
 	// off to improve performance if you don't need them.
 	PrimaryComponentTick.bCanEverTick = true;
 
+#if !UE_BUILD_SHIPPING
+	FMemory::Memzero(Debug_LedgeStageRuns);
+	FMemory::Memzero(Debug_LedgeStageRejects);
+#endif //!UE_BUILD_SHIPPING
+
 }
 
 void UClimbComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
+	ProcessLedgeProbes();
 	ProcessLedgeUp(DeltaTime);
 	ProcessLedgeUpDipDelay(DeltaTime);
 
@@ -67,10 +98,6 @@ void UClimbComponent::BeginPlay()
 		return;
 	}
 
-	CollisionQueryParams.AddIgnoredActor(DeftCharacter.Get());
-	const UCapsuleComponent* capsulComponent = DeftCharacter->GetCapsuleComponent();
-	CapsuleCollisionShape = FCollisionShape::MakeCapsule(capsulComponent->GetUnscaledCapsuleRadius(), capsulComponent->GetUnscaledCapsuleHalfHeight());
-
 	// Ledge-up Setup
 	DeftCharacter->OnJumpInputPressed.AddUObject(this, &UClimbComponent::LedgeUp);
 
@@ -91,10 +118,18 @@ void UClimbComponent::BeginPlay()
 	LedgeReachDistance = 50.f;
 	LedgeUpDipDelayMax = 0.25f;
 
-	if (LedgeUpHeightBoostCurve)
+	// A full round of probes takes 3 frames when there's budget for it, anything older than a few rounds is from somewhere else
+	LedgeProbeMaxAge = 0.2f;
+	LedgeProbeMaxDrift = LedgeReachDistance * 0.5f;
+	LedgeProbeMinFacing = 0.95f;
+	// Ahead of cosmetic queries like the grapple aim preview, a stale probe means a slower ledge up
+	LedgeProbeQueryPriority = 1;
+
+	LedgeUpHeightBoostCurveBaked = FDeftBakedCurve::FindOrBake(LedgeUpHeightBoostCurve);
+	if (LedgeUpHeightBoostCurveBaked.IsValid())
 	{
 		float minUnused;
-		LedgeUpHeightBoostCurve->GetTimeRange(minUnused, LedgeUpLerpTimeMax);
+		LedgeUpHeightBoostCurveBaked->GetTimeRange(minUnused, LedgeUpLerpTimeMax);
 		LedgeUpHeightBoostMax = 75.f;
 	}
 	else
@@ -106,29 +141,22 @@ void UClimbComponent::ProcessLedgeUp(float aDeltaTime)
 	if (!bIsLedgeUpActive)
 		return;
 
-	if (LedgeUpLerpTime >= LedgeUpLerpTimeMax)
+	// The movement component moves us along the ledge up, we only need to know when it's done
+	TSharedPtr<FRootMotionSource> ledgeUpSource = DeftMovementComponent->GetRootMotionSourceByID(LedgeUpRootMotionID);
+	if (ledgeUpSource.IsValid())
 	{
-		// start delay and lock dip
-		LedgeUpDipDelay = 0.f;
-		DeftLocks::IncrementCameraMovementDipLockRef();
-
-		bIsLedgeUpActive = false;
-		OnLedgeUpDelegate.Broadcast(bIsLedgeUpActive);
-
+		LedgeUpLerpTime = ledgeUpSource->GetTime();
 		return;
 	}
 
-	LedgeUpLerpTime += aDeltaTime;
-	LedgeUpLerpTime = FMath::Clamp(LedgeUpLerpTime, 0.f, LedgeUpLerpTimeMax);
-
-	// lerp!
-	const float heightBoost = LedgeUpHeightBoostCurve->GetFloatValue(LedgeUpLerpTime) * LedgeUpHeightBoostMax;
-	const float percent = LedgeUpLerpTime / LedgeUpLerpTimeMax;
-	FVector ledgeUpLoc = FMath::Lerp(LedgeUpStartLocation, LedgeUpFinalLocation, percent) + (FVector::UpVector * heightBoost);
+	// start delay and lock dip
+	LedgeUpDipDelay = 0.f;
+	DeftLocks::IncrementCameraMovementDipLockRef();
 
-	FLatentActionInfo latentInfo;
-	latentInfo.CallbackTarget = this;
-	UKismetSystemLibrary::MoveComponentTo((USceneComponent*)DeftCharacter->GetCapsuleComponent(), ledgeUpLoc, DeftCharacter->GetActorRotation(), false, false, 0.f, true, EMoveComponentAction::Move, latentInfo);
+	LedgeUpLerpTime = LedgeUpLerpTimeMax;
+	LedgeUpRootMotionID = (uint16)ERootMotionSourceID::Invalid;
+	bIsLedgeUpActive = false;
+	OnLedgeUpDelegate.Broadcast(bIsLedgeUpActive);
 }
 
 void UClimbComponent::ProcessLedgeUpDipDelay(float aDeltaTime)
@@ -164,20 +192,37 @@ void UClimbComponent::LedgeUp()
 	if (!isInAir)
 		return;
 
-	FVector ledgeLocation;
-	if (!IsLedgeReachable(ledgeLocation))
-		return;
+	const ADeftLedgeGraph* ledgeGraph = CVar_Feature_LedgeGraph.GetValueOnGameThread() ? ADeftLedgeGraph::FindCovering(GetWorld(), DeftCharacter->GetActorLocation()) : nullptr;
+	if (ledgeGraph)
+	{
+		if (!FindBakedLedge(*ledgeGraph, LedgeUpFinalLocation))
+			return;
+	}
+	// Only a ledge the probes found is worth skipping the checks for. Not finding one could be from before the ledge came into reach
+	else if (CVar_Feature_LedgeProbes.GetValueOnGameThread() && bLedgeProbeFoundLedge && IsLedgeProbeResultFresh() && IsLedgeProbeDestinationClear())
+	{
+		LedgeUpFinalLocation = LedgeProbeResultDestination;
+	}
+	else
+	{
+		if (!RecordLedgeStage(ELedgeProbeStage::Overlap, IsAnythingInLedgeReach()))
+			return;
 
-	FVector heightDistanceTraceEnd;
-	if (!IsLedgeWithinHeightRange(ledgeLocation, heightDistanceTraceEnd))
-		return;
+		FVector ledgeLocation;
+		if (!RecordLedgeStage(ELedgeProbeStage::Reach, IsLedgeReachable(ledgeLocation)))
+			return;
 
-	FHitResult surfaceHit;
-	if (!IsLedgeSurfaceWalkable(heightDistanceTraceEnd, surfaceHit))
-		return;
+		FVector heightDistanceTraceEnd;
+		if (!RecordLedgeStage(ELedgeProbeStage::Height, IsLedgeWithinHeightRange(ledgeLocation, heightDistanceTraceEnd)))
+			return;
 
-	if (!IsEnoughRoomOnLedge(surfaceHit, LedgeUpFinalLocation))
-		return;
+		FHitResult surfaceHit;
+		if (!RecordLedgeStage(ELedgeProbeStage::Surface, IsLedgeSurfaceWalkable(heightDistanceTraceEnd, surfaceHit)))
+			return;
+
+		if (!RecordLedgeStage(ELedgeProbeStage::Room, IsEnoughRoomOnLedge(surfaceHit, LedgeUpFinalLocation)))
+			return;
+	}
 
 #if !UE_BUILD_SHIPPING
 	Debug_LedgeUpMessage = "Ledge has been detected!";
@@ -187,11 +232,62 @@ void UClimbComponent::LedgeUp()
 	LedgeUpStartLocation = DeftCharacter->GetActorLocation();
 
 	// enter ledge up state
+	TSharedPtr<FRootMotionSource_DeftLedgeUp> ledgeUpSource = MakeShared<FRootMotionSource_DeftLedgeUp>();
+	ledgeUpSource->InstanceName = TEXT("DeftLedgeUp");
+	ledgeUpSource->Duration = LedgeUpLerpTimeMax;
+	ledgeUpSource->StartLocation = LedgeUpStartLocation;
+	ledgeUpSource->TargetLocation = LedgeUpFinalLocation;
+	ledgeUpSource->HeightBoostCurve = LedgeUpHeightBoostCurve;
+	ledgeUpSource->HeightBoostCurveBaked = LedgeUpHeightBoostCurveBaked;
+	ledgeUpSource->HeightBoostMax = LedgeUpHeightBoostMax;
+	// Don't carry anything off the ledge, we should be standing on it once we're done
+	ledgeUpSource->FinishVelocityParams.Mode = ERootMotionFinishVelocityMode::SetVelocity;
+	ledgeUpSource->FinishVelocityParams.SetVelocity = FVector::ZeroVector;
+
 	LedgeUpLerpTime = 0.f;
+	LedgeUpRootMotionID = DeftMovementComponent->ApplyForcedMovement(ledgeUpSource);
 	bIsLedgeUpActive = true;
 	OnLedgeUpDelegate.Broadcast(bIsLedgeUpActive);
 }
 
+bool UClimbComponent::IsAnythingInLedgeReach()
+{
+	// Covers everything the reach sweep can hit, but only as high and low as a ledge top could be since the surface check wouldn't find one any further off
+	const FDeftCollisionContext& collisionContext = DeftCharacter->GetCollisionContext();
+	const float capsuleRadius = collisionContext.CapsuleShape.GetCapsuleRadius();
+	const float bandHalfHeight = FMath::Min(collisionContext.CapsuleShape.GetCapsuleHalfHeight(), LedgeHeightMin);
+	const FVector actorFwdNormal = DeftCharacter->GetActorForwardVector().GetSafeNormal2D();
+	const FVector bandCenter = DeftCharacter->GetActorLocation() + (actorFwdNormal * (LedgeReachDistance * 0.5f));
+	const FCollisionShape band = FCollisionShape::MakeBox(FVector(capsuleRadius + (LedgeReachDistance * 0.5f), capsuleRadius, bandHalfHeight));
+
+	const bool bIsAnythingInReach = GetWorld()->OverlapBlockingTestByProfile(bandCenter, actorFwdNormal.ToOrientationQuat(), collisionContext.CapsuleProfileName, band, collisionContext.QueryParams);
+#if !UE_BUILD_SHIPPING
+	Debug_LedgeUpMessage = !bIsAnythingInReach ? "Can't ledge up: nothing in reach" : "";
+#endif //!UE_BUILD_SHIPPING
+	return bIsAnythingInReach;
+}
+
+bool UClimbComponent::RecordLedgeStage(ELedgeProbeStage aStage, bool bPassed)
+{
+#if !UE_BUILD_SHIPPING
+	++Debug_LedgeStageRuns[(uint8)aStage];
+	if (!bPassed)
+		++Debug_LedgeStageRejects[(uint8)aStage];
+#endif //!UE_BUILD_SHIPPING
+	return bPassed;
+}
+
+const FCollisionQueryParams& UClimbComponent::GetLedgeRoomQueryParams(const AActor* aSurfaceActor)
+{
+	if (!LedgeRoomIgnoredActor.IsValid() || LedgeRoomIgnoredActor.Get() != aSurfaceActor)
+	{
+		LedgeRoomQueryParams = DeftCharacter->GetCollisionContext().QueryParams;
+		LedgeRoomQueryParams.AddIgnoredActor(aSurfaceActor);
+		LedgeRoomIgnoredActor = aSurfaceActor;
+	}
+	return LedgeRoomQueryParams;
+}
+
 bool UClimbComponent::IsLedgeReachable(FVector& outLedgeLocation)
 {
 #if !UE_BUILD_SHIPPING
@@ -203,7 +299,8 @@ bool UClimbComponent::IsLedgeReachable(FVector& outLedgeLocation)
 	const FVector ledgeReachEnd = ledgeReachStart + (DeftCharacter->GetActorForwardVector().GetSafeNormal() * LedgeReachDistance);
 	FHitResult reachHit;
 
-	const bool isBlockingHit = GetWorld()->SweepSingleByProfile(reachHit, ledgeReachStart, ledgeReachEnd, DeftCharacter->GetActorRotation().Quaternion(), DeftCharacter->GetCapsuleComponent()->GetCollisionProfileName(), CapsuleCollisionShape, CollisionQueryParams);
+	const FDeftCollisionContext& collisionContext = DeftCharacter->GetCollisionContext();
+	const bool isBlockingHit = QueryLedgeNow(FDeftSceneQuery::Sweep(ledgeReachStart, ledgeReachEnd, collisionContext.GetCapsuleRotation(), collisionContext.CapsuleProfileName, collisionContext.CapsuleShape, collisionContext.QueryParams), reachHit);
 	if (isBlockingHit)
 		outLedgeLocation = reachHit.Location;
 #if !UE_BUILD_SHIPPING
@@ -223,14 +320,11 @@ bool UClimbComponent::IsLedgeWithinHeightRange(const FVector& aLedgeLocation, FV
 
 	// check if a "ledge" exists i.e. open space above a surface wide enough to stand on
 	const FVector actorFwdNormal = DeftCharacter->GetActorForwardVector().GetSafeNormal();
-	const FVector actorLocation = DeftCharacter->GetActorLocation();
-	const FVector ledgeTraceStart = FVector(aLedgeLocation.X, aLedgeLocation.Y, actorLocation.Z) +	// push actor's loc to the wall
-									FVector(0.f, 0.f, LedgeHeightMin) +								// raise it up our minimum acceptable ledge height
-									(actorFwdNormal * CapsuleRadius);								// extend out by at least out capsul size 
+	const FVector ledgeTraceStart = GetLedgeHeightTraceStart(aLedgeLocation, DeftCharacter->GetActorLocation(), actorFwdNormal);
 	outHeightDistanceTraceEnd = ledgeTraceStart + (actorFwdNormal * LedgeWidthRequirement);
 
 	FHitResult ledgeHeightHit;
-	const bool isBlockingHit = GetWorld()->LineTraceSingleByChannel(ledgeHeightHit, ledgeTraceStart, outHeightDistanceTraceEnd, ECC_WorldStatic, CollisionQueryParams);
+	const bool isBlockingHit = QueryLedgeNow(FDeftSceneQuery::LineTrace(ledgeTraceStart, outHeightDistanceTraceEnd, ECC_WorldStatic, DeftCharacter->GetCollisionContext().QueryParams), ledgeHeightHit);
 	if (isBlockingHit)
 		outHeightDistanceTraceEnd = ledgeHeightHit.Location;
 
@@ -252,7 +346,7 @@ bool UClimbComponent::IsLedgeSurfaceWalkable(const FVector& aHeightDistanceTrace
 	// check that it's not a drop off and/or not walkable
 	const FVector surfaceTraceEnd = aHeightDistanceTraceEnd + (FVector::DownVector * LedgeHeightMin * 2.f);
 
-	const bool isBlockingHit = GetWorld()->LineTraceSingleByChannel(outSurfaceHit, aHeightDistanceTraceEnd, surfaceTraceEnd, ECC_WorldStatic, CollisionQueryParams);
+	const bool isBlockingHit = QueryLedgeNow(FDeftSceneQuery::LineTrace(aHeightDistanceTraceEnd, surfaceTraceEnd, ECC_WorldStatic, DeftCharacter->GetCollisionContext().QueryParams), outSurfaceHit);
 #if !UE_BUILD_SHIPPING
 	Debug_LedgeSurfaceStart = aHeightDistanceTraceEnd;
 	Debug_LedgeSurfaceEnd = isBlockingHit ? outSurfaceHit.Location : surfaceTraceEnd;
@@ -273,16 +367,12 @@ bool UClimbComponent::IsEnoughRoomOnLedge(const FHitResult& aSurfaceHit, FVector
 	outFinalDestination = FVector::ZeroVector;
 
 	// check that there is enough space on the ledge for the player's capsule component
-	const FVector widthStart = aSurfaceHit.Location								// Start at the surface collision 
-		+ (FVector::UpVector * CapsuleCollisionShape.GetCapsuleHalfHeight());	// raise it by half the height of the capsule since the origin is in the middle
+	const FDeftCollisionContext& collisionContext = DeftCharacter->GetCollisionContext();
+	const FVector widthStart = GetLedgeRoomLocation(aSurfaceHit.Location);
 
 	const FVector widthEnd = widthStart - DeftCharacter->GetActorForwardVector().GetSafeNormal(); // making the end a very small distance _closer_ to the player because of an issue with UE you can't sweep a shape literally in the exact same location
 	FHitResult ledgeWidthHit;
-	FCollisionQueryParams excludeSurfaceActor;
-	excludeSurfaceActor.AddIgnoredActor(DeftCharacter.Get());
-	excludeSurfaceActor.AddIgnoredActor(aSurfaceHit.GetActor());
-
-	const bool isBlockingHit = GetWorld()->SweepSingleByProfile(ledgeWidthHit, widthStart, widthEnd, DeftCharacter->GetActorRotation().Quaternion(), DeftCharacter->GetCapsuleComponent()->GetCollisionProfileName(), CapsuleCollisionShape, excludeSurfaceActor);
+	const bool isBlockingHit = QueryLedgeNow(FDeftSceneQuery::Sweep(widthStart, widthEnd, collisionContext.GetCapsuleRotation(), collisionContext.CapsuleProfileName, collisionContext.CapsuleShape, GetLedgeRoomQueryParams(aSurfaceHit.GetActor())), ledgeWidthHit);
 	outFinalDestination = isBlockingHit ? ledgeWidthHit.Location : widthStart;
 #if !UE_BUILD_SHIPPING
 	Debug_LedgeWidthLoc = isBlockingHit ? ledgeWidthHit.Location : widthStart;
@@ -292,6 +382,242 @@ bool UClimbComponent::IsEnoughRoomOnLedge(const FHitResult& aSurfaceHit, FVector
 	return !isBlockingHit;
 }
 
+FVector UClimbComponent::GetLedgeHeightTraceStart(const FVector& aLedgeLocation, const FVector& aActorLocation, const FVector& aForward) const
+{
+	return FVector(aLedgeLocation.X, aLedgeLocation.Y, aActorLocation.Z) +	// push actor's loc to the wall
+		FVector(0.f, 0.f, LedgeHeightMin) +									// raise it up our minimum acceptable ledge height
+		(aForward * CapsuleRadius);											// extend out by at least out capsul size
+}
+
+FVector UClimbComponent::GetLedgeRoomLocation(const FVector& aSurfaceLocation) const
+{
+	// Start at the surface collision, raised by half the height of the capsule since the origin is in the middle
+	return aSurfaceLocation + (FVector::UpVector * DeftCharacter->GetCollisionContext().CapsuleShape.GetCapsuleHalfHeight());
+}
+
+bool UClimbComponent::FindBakedLedge(const ADeftLedgeGraph& aLedgeGraph, FVector& outFinalDestination)
+{
+#if !UE_BUILD_SHIPPING
+	Debug_LedgeReach = true;
+#endif //!UE_BUILD_SHIPPING
+
+	const FDeftCollisionContext& collisionContext = DeftCharacter->GetCollisionContext();
+	const float capsuleHalfHeight = collisionContext.CapsuleShape.GetCapsuleHalfHeight();
+	const FVector actorLocation = DeftCharacter->GetActorLocation();
+
+	// Same limits the queries check: in reach, a top within LedgeHeightMin of us either way, room for the capsule on it.
+	// We stand LedgeWidthRequirement back from the lip so the capsule reaches a radius further than that
+	const float capsuleRadius = collisionContext.CapsuleShape.GetCapsuleRadius();
+	FDeftLedgeQuery ledgeQuery;
+	ledgeQuery.Location = actorLocation;
+	ledgeQuery.Forward = DeftCharacter->GetActorForwardVector();
+	ledgeQuery.Reach = capsuleRadius + LedgeReachDistance;
+	ledgeQuery.MinHeight = -LedgeHeightMin;
+	ledgeQuery.MaxHeight = LedgeHeightMin;
+	ledgeQuery.MinDepth = LedgeWidthRequirement + capsuleRadius;
+	ledgeQuery.MinClearance = capsuleHalfHeight * 2.f;
+
+	FDeftLedgeHit ledgeHit;
+	const bool bFoundLedge = aLedgeGraph.FindLedge(ledgeQuery, ledgeHit);
+#if !UE_BUILD_SHIPPING
+	Debug_LedgeUpAttemptLoc = actorLocation;
+	Debug_LedgeReachLoc = bFoundLedge ? ledgeHit.EdgePoint : actorLocation;
+	Debug_LedgeReachColor = bFoundLedge ? FColor::Green : FColor::Red;
+	Debug_LedgeUpMessage = !bFoundLedge ? "Can't ledge up: no baked ledge in reach" : "";
+#endif //!UE_BUILD_SHIPPING
+	if (!bFoundLedge)
+		return false;
+
+#if !UE_BUILD_SHIPPING
+	Debug_LedgeWidth = true;
+#endif //!UE_BUILD_SHIPPING
+
+	// Sat on the top where we'll stand, a sloped top is higher or lower there than at the lip and the bottom of the capsule has to clear it across its whole radius
+	const FVector standOffset = -ledgeHit.Outward * LedgeWidthRequirement;
+	const FVector& topNormal = ledgeHit.TopNormal;
+	const float topNormalZ = FMath::Max(topNormal.Z, UE_KINDA_SMALL_NUMBER);
+	const float topRise = -((topNormal.X * standOffset.X) + (topNormal.Y * standOffset.Y)) / topNormalZ;
+	const float capsuleBottomSphereHeight = (capsuleRadius / topNormalZ) + 1.f;
+	outFinalDestination = ledgeHit.EdgePoint + standOffset + (FVector::UpVector * (topRise + capsuleBottomSphereHeight + capsuleHalfHeight - capsuleRadius));
+
+	// The bake only probed depth and clearance along a couple of lines, an overhang or a wall further back can still be in the way, and anything that moves could be there now
+	const bool bIsBlocked = GetWorld()->OverlapBlockingTestByProfile(outFinalDestination, collisionContext.GetCapsuleRotation(), collisionContext.CapsuleProfileName, collisionContext.CapsuleShape, collisionContext.QueryParams);
+#if !UE_BUILD_SHIPPING
+	Debug_LedgeWidthLoc = outFinalDestination;
+	Debug_LedgeWidthColor = bIsBlocked ? FColor::Red : FColor::Green;
+	Debug_LedgeUpMessage = bIsBlocked ? "Can't ledge up: obstacles in the way on ledge" : "";
+#endif //!UE_BUILD_SHIPPING
+	return !bIsBlocked;
+}
+
+bool UClimbComponent::QueryLedgeNow(const FDeftSceneQuery& aQuery, FHitResult& outHit)
+{
+	UDeftSceneQuerySubsystem* sceneQuerySubsystem = GetWorld()->GetSubsystem<UDeftSceneQuerySubsystem>();
+	return sceneQuerySubsystem && sceneQuerySubsystem->QueryNow(aQuery, outHit);
+}
+
+void UClimbComponent::ProcessLedgeProbes()
+{
+	if (!DeftMovementComponent.IsValid())
+		return;
+
+	const bool bIsInAir = DeftMovementComponent->IsDeftJumping() || DeftMovementComponent->IsDeftFalling();
+	const bool bWantsProbes = CVar_Feature_LedgeProbes.GetValueOnGameThread() && bIsInAir && !bIsLedgeUpActive
+		&& !(CVar_Feature_LedgeGraph.GetValueOnGameThread() && ADeftLedgeGraph::FindCovering(GetWorld(), DeftCharacter->GetActorLocation()));
+	if (!bWantsProbes)
+	{
+		ResetLedgeProbes();
+		return;
+	}
+
+	// Once started every round keeps itself going from OnLedgeProbeDone
+	if (LedgeProbeStage == ELedgeProbeStage::None)
+		StartLedgeProbes();
+}
+
+void UClimbComponent::StartLedgeProbes()
+{
+	LedgeProbeOrigin = DeftCharacter->GetActorLocation();
+	LedgeProbeForward = DeftCharacter->GetActorForwardVector().GetSafeNormal();
+
+	const FDeftCollisionContext& collisionContext = DeftCharacter->GetCollisionContext();
+	LedgeProbeStage = ELedgeProbeStage::Reach;
+	LedgeProbeQueryID = SubmitLedgeProbe(FDeftSceneQuery::Sweep(LedgeProbeOrigin, LedgeProbeOrigin + (LedgeProbeForward * LedgeReachDistance), collisionContext.GetCapsuleRotation(), collisionContext.CapsuleProfileName, collisionContext.CapsuleShape, collisionContext.QueryParams), ELedgeProbeStage::Reach);
+}
+
+uint32 UClimbComponent::SubmitLedgeProbe(const FDeftSceneQuery& aQuery, ELedgeProbeStage aStage)
+{
+	UDeftSceneQuerySubsystem* sceneQuerySubsystem = GetWorld()->GetSubsystem<UDeftSceneQuerySubsystem>();
+	if (!sceneQuerySubsystem)
+		return 0;
+	return sceneQuerySubsystem->Submit(aQuery, EDeftSceneQueryLatency::BestEffort, LedgeProbeQueryPriority, FOnDeftSceneQueryDone::CreateUObject(this, &UClimbComponent::OnLedgeProbeDone, aStage));
+}
+
+void UClimbComponent::OnLedgeProbeDone(const FDeftSceneQueryResult& aResult, ELedgeProbeStage aStage)
+{
+	if (aStage == ELedgeProbeStage::Surface)
+		LedgeProbeSurfaceQueryID = 0;
+	else
+		LedgeProbeQueryID = 0;
+
+	if (!DeftCharacter.IsValid())
+		return;
+
+	// Held back too long for the budget, whatever's left of this round is from too long ago to be worth finishing. The last result stays until it goes stale
+	if (aResult.bDropped)
+	{
+		CancelLedgeProbes();
+		return;
+	}
+
+	// Each stage only goes out once the one before it passed, height and surface go out together since neither needs the other's hit
+	const FDeftCollisionContext& collisionContext = DeftCharacter->GetCollisionContext();
+	switch (aStage)
+	{
+	case ELedgeProbeStage::Reach:
+	{
+		if (!RecordLedgeStage(ELedgeProbeStage::Reach, aResult.bBlockingHit))
+		{
+			FinishLedgeProbes(false, FVector::ZeroVector);
+			return;
+		}
+
+		const FVector heightStart = GetLedgeHeightTraceStart(aResult.Hit.Location, LedgeProbeOrigin, LedgeProbeForward);
+		LedgeProbeHeightEnd = heightStart + (LedgeProbeForward * LedgeWidthRequirement);
+		const FVector surfaceEnd = LedgeProbeHeightEnd + (FVector::DownVector * LedgeHeightMin * 2.f);
+		LedgeProbeStage = ELedgeProbeStage::Height;
+		LedgeProbeQueryID = SubmitLedgeProbe(FDeftSceneQuery::LineTrace(heightStart, LedgeProbeHeightEnd, ECC_WorldStatic, collisionContext.QueryParams), ELedgeProbeStage::Height);
+		LedgeProbeSurfaceQueryID = SubmitLedgeProbe(FDeftSceneQuery::LineTrace(LedgeProbeHeightEnd, surfaceEnd, ECC_WorldStatic, collisionContext.QueryParams), ELedgeProbeStage::Surface);
+		break;
+	}
+	case ELedgeProbeStage::Height:
+	case ELedgeProbeStage::Surface:
+	{
+		if (aStage == ELedgeProbeStage::Height)
+			LedgeProbeHeightResult = aResult;
+		else
+			LedgeProbeSurfaceResult = aResult;
+
+		// The other one is still out
+		if (LedgeProbeQueryID != 0 || LedgeProbeSurfaceQueryID != 0)
+			return;
+
+		if (!RecordLedgeStage(ELedgeProbeStage::Height, !LedgeProbeHeightResult.bBlockingHit) || !RecordLedgeStage(ELedgeProbeStage::Surface, LedgeProbeSurfaceResult.bBlockingHit))
+		{
+			FinishLedgeProbes(false, FVector::ZeroVector);
+			return;
+		}
+
+		const FHitResult& surfaceHit = LedgeProbeSurfaceResult.Hit;
+		const FVector roomStart = GetLedgeRoomLocation(surfaceHit.Location);
+		LedgeProbeStage = ELedgeProbeStage::Room;
+		LedgeProbeQueryID = SubmitLedgeProbe(FDeftSceneQuery::Sweep(roomStart, roomStart - LedgeProbeForward, collisionContext.GetCapsuleRotation(), collisionContext.CapsuleProfileName, collisionContext.CapsuleShape, GetLedgeRoomQueryParams(surfaceHit.GetActor())), ELedgeProbeStage::Room);
+		break;
+	}
+	case ELedgeProbeStage::Room:
+		FinishLedgeProbes(RecordLedgeStage(ELedgeProbeStage::Room, !aResult.bBlockingHit), aResult.Start);
+		break;
+	default:
+		break;
+	}
+}
+
+void UClimbComponent::FinishLedgeProbes(bool bFoundLedge, const FVector& aFinalDestination)
+{
+	// A round that didn't find anything still replaces the last one, the ledge we saw then isn't in front of us anymore
+	bHasLedgeProbeResult = true;
+	bLedgeProbeFoundLedge = bFoundLedge;
+	LedgeProbeResultSurfaceActor = bFoundLedge ? LedgeProbeSurfaceResult.Hit.GetActor() : nullptr;
+	LedgeProbeResultTime = GetWorld()->GetTimeSeconds();
+	LedgeProbeResultOrigin = LedgeProbeOrigin;
+	LedgeProbeResultForward = LedgeProbeForward;
+	LedgeProbeResultDestination = aFinalDestination;
+
+	// Straight into the next round, the first probe goes out with this frame's batch
+	StartLedgeProbes();
+}
+
+void UClimbComponent::CancelLedgeProbes()
+{
+	if (UDeftSceneQuerySubsystem* sceneQuerySubsystem = GetWorld()->GetSubsystem<UDeftSceneQuerySubsystem>())
+	{
+		sceneQuerySubsystem->Cancel(LedgeProbeQueryID);
+		sceneQuerySubsystem->Cancel(LedgeProbeSurfaceQueryID);
+	}
+	LedgeProbeStage = ELedgeProbeStage::None;
+}
+
+void UClimbComponent::ResetLedgeProbes()
+{
+	CancelLedgeProbes();
+	bHasLedgeProbeResult = false;
+	bLedgeProbeFoundLedge = false;
+}
+
+bool UClimbComponent::IsLedgeProbeResultFresh() const
+{
+	if (!bHasLedgeProbeResult || GetWorld()->GetTimeSeconds() - LedgeProbeResultTime > LedgeProbeMaxAge)
+		return false;
+
+	const FVector actorLocation = DeftCharacter->GetActorLocation();
+	const FVector actorForward = DeftCharacter->GetActorForwardVector().GetSafeNormal();
+	return FVector::DistSquared(actorLocation, LedgeProbeResultOrigin) <= FMath::Square(LedgeProbeMaxDrift)
+		&& (actorForward | LedgeProbeResultForward) >= LedgeProbeMinFacing;
+}
+
+bool UClimbComponent::IsLedgeProbeDestinationClear()
+{
+	// Same room check the probes did, things can have moved into it since
+	const FDeftCollisionContext& collisionContext = DeftCharacter->GetCollisionContext();
+	const bool bIsBlocked = GetWorld()->OverlapBlockingTestByProfile(LedgeProbeResultDestination, collisionContext.GetCapsuleRotation(), collisionContext.CapsuleProfileName, collisionContext.CapsuleShape, GetLedgeRoomQueryParams(LedgeProbeResultSurfaceActor.Get()));
+#if !UE_BUILD_SHIPPING
+	Debug_LedgeWidth = true;
+	Debug_LedgeWidthLoc = LedgeProbeResultDestination;
+	Debug_LedgeWidthColor = bIsBlocked ? FColor::Red : FColor::Green;
+#endif //!UE_BUILD_SHIPPING
+	return !bIsBlocked;
+}
+
 #if !UE_BUILD_SHIPPING
 void UClimbComponent::DrawDebug()
 {
@@ -303,16 +629,27 @@ void UClimbComponent::DrawDebugLedgeUp()
 {
 	const float dipDelay = LedgeUpDipDelayMax - LedgeUpDipDelay;
 	GEngine->AddOnScreenDebugMessage(-1, 0.005, FColor::White, FString::Printf(TEXT("\tLerpTime: %.2f\n\tLerpMax: %.2f\n\tDip Locked for: %.2fs"), LedgeUpLerpTime, LedgeUpLerpTimeMax, dipDelay));
+	static const TCHAR* stageNames[(uint8)ELedgeProbeStage::Num] = { TEXT(""), TEXT("Overlap"), TEXT("Reach"), TEXT("Height"), TEXT("Surface"), TEXT("Room") };
+	FString stageStats;
+	for (uint8 stage = (uint8)ELedgeProbeStage::Overlap; stage < (uint8)ELedgeProbeStage::Num; ++stage)
+		stageStats += FString::Printf(TEXT("\n\t%s: %u run, %u rejected"), stageNames[stage], Debug_LedgeStageRuns[stage], Debug_LedgeStageRejects[stage]);
+	GEngine->AddOnScreenDebugMessage(-1, 0.005, FColor::White, stageStats);
 	GEngine->AddOnScreenDebugMessage(-1, 0.005, Debug_LedgeUpSuccess ? FColor::Green : FColor::Red, FString::Printf(TEXT("\t%s"), *Debug_LedgeUpMessage));
 	GEngine->AddOnScreenDebugMessage(-1, 0.005, FColor::Yellow, TEXT("\n-Ledge Up-"));
 
+	const FCollisionShape& capsuleShape = DeftCharacter->GetCollisionContext().CapsuleShape;
+
 	// debug reach
 	if (Debug_LedgeReach)
 	{
-		DrawDebugCapsule(GetWorld(), Debug_LedgeUpAttemptLoc, CapsuleCollisionShape.GetCapsuleHalfHeight(), CapsuleCollisionShape.GetCapsuleRadius(), DeftCharacter->GetActorRotation().Quaternion(), FColor::White);
-		DrawDebugCapsule(GetWorld(), Debug_LedgeReachLoc, CapsuleCollisionShape.GetCapsuleHalfHeight(), CapsuleCollisionShape.GetCapsuleRadius(), DeftCharacter->GetActorRotation().Quaternion(), Debug_LedgeReachColor);
+		DrawDebugCapsule(GetWorld(), Debug_LedgeUpAttemptLoc, capsuleShape.GetCapsuleHalfHeight(), capsuleShape.GetCapsuleRadius(), DeftCharacter->GetActorRotation().Quaternion(), FColor::White);
+		DrawDebugCapsule(GetWorld(), Debug_LedgeReachLoc, capsuleShape.GetCapsuleHalfHeight(), capsuleShape.GetCapsuleRadius(), DeftCharacter->GetActorRotation().Quaternion(), Debug_LedgeReachColor);
 	}
 	
+	// debug speculative probes, where the last round found we could ledge up to
+	if (bHasLedgeProbeResult && bLedgeProbeFoundLedge)
+		DrawDebugCapsule(GetWorld(), LedgeProbeResultDestination, capsuleShape.GetCapsuleHalfHeight(), capsuleShape.GetCapsuleRadius(), DeftCharacter->GetActorRotation().Quaternion(), IsLedgeProbeResultFresh() ? FColor::Cyan : FColor::Blue);
+
 	// debug height
 	if (Debug_LedgeHeight)
 		DrawDebugLine(GetWorld(), Debug_LedgeHeightStart, Debug_LedgeHeightEnd, Debug_LedgeHeightColor);
@@ -323,7 +660,7 @@ void UClimbComponent::DrawDebugLedgeUp()
 	
 	// debug reach
 	if (Debug_LedgeWidth)
-		DrawDebugCapsule(GetWorld(), Debug_LedgeWidthLoc, CapsuleCollisionShape.GetCapsuleHalfHeight(), CapsuleCollisionShape.GetCapsuleRadius(), DeftCharacter->GetActorRotation().Quaternion(), Debug_LedgeWidthColor);
+		DrawDebugCapsule(GetWorld(), Debug_LedgeWidthLoc, capsuleShape.GetCapsuleHalfHeight(), capsuleShape.GetCapsuleRadius(), DeftCharacter->GetActorRotation().Quaternion(), Debug_LedgeWidthColor);
 }
 
 #endif // !UE_BUILD_SHIPPING
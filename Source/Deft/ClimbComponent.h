@@ -4,10 +4,23 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "DeftSceneQuerySubsystem.h"
 #include "ClimbComponent.generated.h"
 
 DECLARE_MULTICAST_DELEGATE_OneParam(FOnLedgeUp, bool/*bStarted*/);
 
+// The ledge up checks in the order they depend on each other, each one can reject the ledge before the next has to run
+enum class ELedgeProbeStage : uint8
+{
+	None,
+	Overlap,	// anything at all in front of us at a height we could ledge up from
+	Reach,
+	Height,
+	Surface,
+	Room,
+	Num
+};
+
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class DEFT_API UClimbComponent : public UActorComponent
 {
@@ -38,9 +51,32 @@ private:
 	bool IsLedgeWithinHeightRange(const FVector& aLedgeLocation, FVector& outHeightDistanceTraceEnd);
 	bool IsLedgeSurfaceWalkable(const FVector& aHeightDistanceTraceEnd, FHitResult& outSurfaceHit);
 	bool IsEnoughRoomOnLedge(const FHitResult& aSurfaceHit, FVector& outFinalDestination);
-
-	FCollisionQueryParams CollisionQueryParams;
-	FCollisionShape CapsuleCollisionShape;
+	// Nothing to ledge up onto is the usual answer, one overlap in front of us finds most of those before the chain of queries
+	bool IsAnythingInLedgeReach();
+	// Passes bPassed straight through, counting it towards aStage's stats
+	bool RecordLedgeStage(ELedgeProbeStage aStage, bool bPassed);
+	const FCollisionQueryParams& GetLedgeRoomQueryParams(const AActor* aSurfaceActor);
+	FVector GetLedgeHeightTraceStart(const FVector& aLedgeLocation, const FVector& aActorLocation, const FVector& aForward) const;
+	FVector GetLedgeRoomLocation(const FVector& aSurfaceLocation) const;
+
+	// Same answer as the queries above but from the ledges baked into aLedgeGraph, with one overlap where we'd end up instead of the chain of queries
+	bool FindBakedLedge(const class ADeftLedgeGraph& aLedgeGraph, FVector& outFinalDestination);
+
+	// Ledge up queries have to be answered now, they still go through the scene query subsystem so they count against its budget
+	bool QueryLedgeNow(const FDeftSceneQuery& aQuery, FHitResult& outHit);
+
+	// Runs the same checks as best effort queries while we're in the air so a ledge up only has to look at the last result
+	void ProcessLedgeProbes();
+	void StartLedgeProbes();
+	uint32 SubmitLedgeProbe(const FDeftSceneQuery& aQuery, ELedgeProbeStage aStage);
+	void OnLedgeProbeDone(const FDeftSceneQueryResult& aResult, ELedgeProbeStage aStage);
+	void FinishLedgeProbes(bool bFoundLedge, const FVector& aFinalDestination);
+	// Stops the round in flight, ProcessLedgeProbes starts a new one next tick
+	void CancelLedgeProbes();
+	void ResetLedgeProbes();
+	// Whether the last finished probe was from close enough to where (and how) we are now to stand in for the checks
+	bool IsLedgeProbeResultFresh() const;
+	bool IsLedgeProbeDestinationClear();
 
 	FVector LedgeUpFinalLocation;
 	FVector LedgeUpStartLocation;
@@ -61,6 +97,35 @@ private:
 	// delay dip from being activated after a dip otherwise it looks too bouncy
 	float LedgeUpDipDelay;
 	float LedgeUpDipDelayMax;
+	uint16 LedgeUpRootMotionID;		// forced movement currently carrying us up the ledge
+	TSharedPtr<const struct FDeftBakedCurve> LedgeUpHeightBoostCurveBaked;		// shared bake of LedgeUpHeightBoostCurve, see FDeftBakedCurve::FindOrBake
+
+	// Speculative ledge probes
+	ELedgeProbeStage LedgeProbeStage;
+	uint32 LedgeProbeQueryID;				// probe waiting on its result, 0 if there isn't one
+	uint32 LedgeProbeSurfaceQueryID;		// the surface only depends on where the height trace ends, so it goes out alongside it
+	FDeftSceneQueryResult LedgeProbeHeightResult;	// whichever of height/surface comes back first waits here for the other
+	FDeftSceneQueryResult LedgeProbeSurfaceResult;
+	int32 LedgeProbeQueryPriority;			// against everyone else's best effort queries
+	FVector LedgeProbeOrigin;				// where we were when the probes started, every stage is relative to that
+	FVector LedgeProbeForward;
+	FVector LedgeProbeHeightEnd;
+
+	bool bHasLedgeProbeResult;
+	bool bLedgeProbeFoundLedge;
+	float LedgeProbeResultTime;
+	FVector LedgeProbeResultOrigin;
+	FVector LedgeProbeResultForward;
+	FVector LedgeProbeResultDestination;
+	TWeakObjectPtr<const AActor> LedgeProbeResultSurfaceActor;	// the room check ignores what we'd be standing on, see GetLedgeRoomQueryParams
+
+	// The room check ignores whatever we're standing on, kept around since it's usually the same ledge over and over
+	FCollisionQueryParams LedgeRoomQueryParams;
+	TWeakObjectPtr<const AActor> LedgeRoomIgnoredActor;
+
+	float LedgeProbeMaxAge;				// seconds
+	float LedgeProbeMaxDrift;			// how far we can have moved from where the result was probed
+	float LedgeProbeMinFacing;			// cos of how far we can have turned
 
 	bool bIsLedgeUpActive;
 
@@ -68,6 +133,9 @@ private:
 	void DrawDebug();
 	void DrawDebugLedgeUp();
 
+	uint32 Debug_LedgeStageRuns[(uint8)ELedgeProbeStage::Num];
+	uint32 Debug_LedgeStageRejects[(uint8)ELedgeProbeStage::Num];
+
 	bool Debug_LedgeUpSuccess;
 	FVector Debug_LedgeUpAttemptLoc;
 	FString Debug_LedgeUpMessage;
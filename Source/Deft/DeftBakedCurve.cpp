@@ -0,0 +1,248 @@
+#include "DeftBakedCurve.h"
+
+#include "Curves/CurveFloat.h"
+#include "UObject/ObjectKey.h"
+#include "UObject/UObjectIterator.h"
+
+namespace
+{
+	const int32 BakedCurveMaxSamples = 4096;
+
+	// One bake per curve asset, shared by everyone using it
+	TMap<FObjectKey, TSharedPtr<FDeftBakedCurve>> BakedCurves;
+
+#if WITH_EDITORONLY_DATA
+	uint32 HashCurveKeys(const FRichCurve& aCurve)
+	{
+		uint32 hash = GetTypeHash(aCurve.GetNumKeys());
+		for (const FRichCurveKey& key : aCurve.GetConstRefOfKeys())
+		{
+			hash = HashCombine(hash, GetTypeHash(key.Time));
+			hash = HashCombine(hash, GetTypeHash(key.Value));
+			hash = HashCombine(hash, GetTypeHash(key.ArriveTangent));
+			hash = HashCombine(hash, GetTypeHash(key.LeaveTangent));
+			hash = HashCombine(hash, GetTypeHash((uint8)key.InterpMode));
+			hash = HashCombine(hash, GetTypeHash((uint8)key.TangentMode));
+		}
+		return hash;
+	}
+#endif //WITH_EDITORONLY_DATA
+}
+
+FDeftBakedCurve::FDeftBakedCurve()
+	: Samples()
+	, MinTime(0.f)
+	, MaxTime(0.f)
+	, MinValue(0.f)
+	, MaxValue(0.f)
+	, SamplesPerTime(0.f)
+#if WITH_EDITORONLY_DATA
+	, SourceKeysHash(0)
+#endif //WITH_EDITORONLY_DATA
+{
+}
+
+TSharedPtr<const FDeftBakedCurve> FDeftBakedCurve::FindOrBake(const UCurveFloat* aCurve)
+{
+	check(IsInGameThread());
+
+	if (!aCurve || aCurve->FloatCurve.GetNumKeys() == 0)
+		return nullptr;
+
+	TSharedPtr<FDeftBakedCurve>* existingBake = BakedCurves.Find(FObjectKey(aCurve));
+#if WITH_EDITORONLY_DATA
+	// Anyone still holding the stale bake keeps it alive until they ask again
+	if (existingBake && (*existingBake)->SourceKeysHash != HashCurveKeys(aCurve->FloatCurve))
+		existingBake = nullptr;
+#endif //WITH_EDITORONLY_DATA
+	if (existingBake)
+		return *existingBake;
+
+	// Only happens at BeginPlay so this is a fine time to forget curves which have been unloaded
+	for (auto it = BakedCurves.CreateIterator(); it; ++it)
+	{
+		if (!it.Key().ResolveObjectPtr())
+			it.RemoveCurrent();
+	}
+
+	TSharedPtr<FDeftBakedCurve> bakedCurve = MakeShared<FDeftBakedCurve>();
+	bakedCurve->Bake(*aCurve);
+	BakedCurves.Add(FObjectKey(aCurve), bakedCurve);
+	return bakedCurve;
+}
+
+void FDeftBakedCurve::Register(const UCurveFloat* aCurve, const FDeftBakedCurve& aBakedCurve)
+{
+	check(IsInGameThread());
+
+	if (!aCurve || !aBakedCurve.IsBaked())
+		return;
+
+	TSharedPtr<FDeftBakedCurve> bakedCurve = MakeShared<FDeftBakedCurve>(aBakedCurve);
+#if WITH_EDITORONLY_DATA
+	// Not serialized, whoever registers is expected to have baked from the curve as it is right now
+	bakedCurve->SourceKeysHash = HashCurveKeys(aCurve->FloatCurve);
+#endif //WITH_EDITORONLY_DATA
+	BakedCurves.Add(FObjectKey(aCurve), bakedCurve);
+}
+
+void FDeftBakedCurve::Bake(const UCurveFloat& aCurve, float aSamplesPerSecond)
+{
+	aCurve.GetTimeRange(MinTime, MaxTime);
+	aCurve.GetValueRange(MinValue, MaxValue);
+
+	const float timeRange = MaxTime - MinTime;
+	const int32 numSamples = FMath::Clamp(FMath::CeilToInt32(timeRange * aSamplesPerSecond) + 1, 2, BakedCurveMaxSamples);
+	SamplesPerTime = timeRange > UE_SMALL_NUMBER ? (numSamples - 1) / timeRange : 0.f;
+
+	Samples.SetNumUninitialized(numSamples);
+	for (int32 i = 0; i < numSamples; ++i)
+		Samples[i] = aCurve.GetFloatValue(MinTime + (timeRange * i) / (numSamples - 1));
+
+#if WITH_EDITORONLY_DATA
+	SourceKeysHash = HashCurveKeys(aCurve.FloatCurve);
+#endif //WITH_EDITORONLY_DATA
+}
+
+void FDeftBakedCurve::Reset()
+{
+	*this = FDeftBakedCurve();
+}
+
+float FDeftBakedCurve::Eval(float aTime) const
+{
+	checkSlow(IsBaked());
+
+	const float sampleTime = FMath::Clamp(aTime - MinTime, 0.f, MaxTime - MinTime) * SamplesPerTime;
+	// the very end of the curve lands on the last sample, lerp into it rather than past it
+	const int32 index = FMath::Min((int32)sampleTime, Samples.Num() - 2);
+
+	const float* samples = Samples.GetData();
+	return FMath::Lerp(samples[index], samples[index + 1], sampleTime - index);
+}
+
+void FDeftBakedCurve::EvalBatch(const float* aTimes, float* outValues, int32 aCount) const
+{
+	checkSlow(IsBaked());
+
+	const float* samples = Samples.GetData();
+	const VectorRegister4Float minTime = VectorSetFloat1(MinTime);
+	const VectorRegister4Float timeRange = VectorSetFloat1(MaxTime - MinTime);
+	const VectorRegister4Float samplesPerTime = VectorSetFloat1(SamplesPerTime);
+	const VectorRegister4Float lastIndex = VectorSetFloat1((float)(Samples.Num() - 2));
+
+	int32 i = 0;
+	for (; i + 4 <= aCount; i += 4)
+	{
+		const VectorRegister4Float times = VectorMin(VectorMax(VectorSubtract(VectorLoad(aTimes + i), minTime), VectorZeroFloat()), timeRange);
+		const VectorRegister4Float sampleTimes = VectorMultiply(times, samplesPerTime);
+		const VectorRegister4Float indices = VectorMin(VectorFloor(sampleTimes), lastIndex);
+		const VectorRegister4Float alphas = VectorSubtract(sampleTimes, indices);
+
+		// No gather on every platform we ship so fetch the neighbours one lane at a time
+		alignas(16) float laneIndices[4];
+		alignas(16) float from[4];
+		alignas(16) float to[4];
+		VectorStoreAligned(indices, laneIndices);
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			const int32 index = (int32)laneIndices[lane];
+			from[lane] = samples[index];
+			to[lane] = samples[index + 1];
+		}
+
+		const VectorRegister4Float fromValues = VectorLoadAligned(from);
+		const VectorRegister4Float toValues = VectorLoadAligned(to);
+		VectorStore(VectorMultiplyAdd(VectorSubtract(toValues, fromValues), alphas, fromValues), outValues + i);
+	}
+
+	for (; i < aCount; ++i)
+		outValues[i] = Eval(aTimes[i]);
+}
+
+bool FDeftBakedCurve::FindDescendingTime(float aValue, float aFromTime, float& outTime) const
+{
+	checkSlow(IsBaked());
+
+	const float* samples = Samples.GetData();
+	const int32 lastIndex = Samples.Num() - 1;
+	if (samples[lastIndex] > aValue)
+		return false;
+
+	const float fromTime = FMath::Clamp(aFromTime, MinTime, MaxTime);
+	if (Eval(fromTime) <= aValue)
+	{
+		outTime = fromTime;
+		return true;
+	}
+
+	// Binary search for the first sample at or below aValue, samples are non-increasing from here on
+	int32 low = FMath::Min((int32)((fromTime - MinTime) * SamplesPerTime), lastIndex);
+	int32 high = lastIndex;
+	while (low < high)
+	{
+		const int32 mid = (low + high) / 2;
+		if (samples[mid] <= aValue)
+			high = mid;
+		else
+			low = mid + 1;
+	}
+
+	// aValue is somewhere between the previous sample and this one
+	const int32 index = FMath::Max(high - 1, 0);
+	const float valueRange = samples[index + 1] - samples[index];
+	const float alpha = valueRange < 0.f ? (aValue - samples[index]) / valueRange : 1.f;
+	outTime = FMath::Max(MinTime + ((index + FMath::Clamp(alpha, 0.f, 1.f)) / SamplesPerTime), fromTime);
+	return true;
+}
+
+#if !UE_BUILD_SHIPPING
+// Times GetFloatValue against the baked table on every loaded curve, e.g. "deft.bench.curves 100000"
+static FAutoConsoleCommand CCmd_BenchCurves(
+	TEXT("deft.bench.curves"),
+	TEXT("Compare UCurveFloat::GetFloatValue against FDeftBakedCurve for every loaded float curve. Optional arg: evaluations per curve"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& aArgs)
+	{
+		const int32 numEvals = aArgs.Num() > 0 ? FMath::Max(FCString::Atoi(*aArgs[0]), 4) : 100000;
+
+		TArray<float> times;
+		TArray<float> values;
+		times.SetNumUninitialized(numEvals);
+		values.SetNumUninitialized(numEvals);
+
+		for (TObjectIterator<UCurveFloat> it; it; ++it)
+		{
+			const UCurveFloat* curve = *it;
+			TSharedPtr<const FDeftBakedCurve> bakedCurve = FDeftBakedCurve::FindOrBake(curve);
+			if (!bakedCurve.IsValid())
+				continue;
+
+			// random times so neither side gets to lean on a warm key search
+			FRandomStream random(numEvals);
+			for (float& time : times)
+				time = random.FRandRange(bakedCurve->GetMinTime(), bakedCurve->GetMaxTime());
+
+			float sink = 0.f;
+			double startSeconds = FPlatformTime::Seconds();
+			for (const float time : times)
+				sink += curve->GetFloatValue(time);
+			const double curveSeconds = FPlatformTime::Seconds() - startSeconds;
+
+			startSeconds = FPlatformTime::Seconds();
+			for (const float time : times)
+				sink += bakedCurve->Eval(time);
+			const double bakedSeconds = FPlatformTime::Seconds() - startSeconds;
+
+			startSeconds = FPlatformTime::Seconds();
+			bakedCurve->EvalBatch(times.GetData(), values.GetData(), numEvals);
+			const double batchSeconds = FPlatformTime::Seconds() - startSeconds;
+
+			float maxError = 0.f;
+			for (int32 i = 0; i < numEvals; ++i)
+				maxError = FMath::Max(maxError, FMath::Abs(curve->GetFloatValue(times[i]) - values[i]));
+
+			UE_LOG(LogTemp, Display, TEXT("%s: GetFloatValue %.3fms, Eval %.3fms, EvalBatch %.3fms, max error %f (%d evals, sink %f)"),
+				*curve->GetName(), curveSeconds * 1000.0, bakedSeconds * 1000.0, batchSeconds * 1000.0, maxError, numEvals, sink);
+		}
+	}));
+#endif //!UE_BUILD_SHIPPING
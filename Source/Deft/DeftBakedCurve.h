@@ -0,0 +1,64 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DeftBakedCurve.generated.h"
+
+/**
+ * UCurveFloat sampled at a fixed step into a flat table so evaluating it is a lerp between two neighbours instead of a key search.
+ * Bakes are shared, every character using the same curve asset reads the same table (see FindOrBake)
+ */
+USTRUCT()
+struct DEFT_API FDeftBakedCurve
+{
+	GENERATED_BODY()
+
+	FDeftBakedCurve();
+
+	// Fine enough that lerping between samples is indistinguishable from the real curve at any frame rate we run at
+	static constexpr float DefaultSamplesPerSecond = 480.f;
+
+	// Returns the shared bake of aCurve, baking it the first time it's asked for. Null if there's no curve or it has no keys
+	static TSharedPtr<const FDeftBakedCurve> FindOrBake(const class UCurveFloat* aCurve);
+	// Shares a bake that was made ahead of time (i.e. saved in an asset) so FindOrBake hands it out instead of baking again
+	static void Register(const class UCurveFloat* aCurve, const FDeftBakedCurve& aBakedCurve);
+
+	// Samples aCurve every 1/aSamplesPerSecond across its whole time range
+	void Bake(const class UCurveFloat& aCurve, float aSamplesPerSecond = DefaultSamplesPerSecond);
+	void Reset();
+
+	// Times outside the curve range are clamped just like UCurveFloat::GetFloatValue with constant extrapolation
+	float Eval(float aTime) const;
+	// Evaluates aCount times at once, 4 at a time with vector math
+	void EvalBatch(const float* aTimes, float* outValues, int32 aCount) const;
+	// Inverse of Eval for a part of the curve that only goes down from aFromTime on (i.e. after a jump apex or a fall), false if it never gets as low as aValue
+	bool FindDescendingTime(float aValue, float aFromTime, float& outTime) const;
+
+	void GetTimeRange(float& outMinTime, float& outMaxTime) const { outMinTime = MinTime; outMaxTime = MaxTime; }
+	void GetValueRange(float& outMinValue, float& outMaxValue) const { outMinValue = MinValue; outMaxValue = MaxValue; }
+	float GetMinTime() const { return MinTime; }
+	float GetMaxTime() const { return MaxTime; }
+	bool IsBaked() const { return Samples.Num() >= 2; }
+
+private:
+	UPROPERTY()
+	TArray<float> Samples;
+
+	UPROPERTY()
+	float MinTime;
+
+	UPROPERTY()
+	float MaxTime;
+
+	UPROPERTY()
+	float MinValue;
+
+	UPROPERTY()
+	float MaxValue;
+
+	UPROPERTY()
+	float SamplesPerTime;		// 1 / time between samples, turns a time into a (fractional) sample index
+
+#if WITH_EDITORONLY_DATA
+	uint32 SourceKeysHash;		// lets designers tweak curves during PIE without the bake going stale
+#endif //WITH_EDITORONLY_DATA
+};
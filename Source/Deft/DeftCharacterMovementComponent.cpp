@@ -1,15 +1,19 @@
 #include "DeftCharacterMovementComponent.h"
 
 #include "Components/CapsuleComponent.h"
-#include "ClimbComponent.h"
+#include "DeftBakedCurve.h"
 #include "DeftPlayerCharacter.h"
 #include "DeftLocks.h"
-#include "GrappleComponent.h"
+#include "DeftMovementCurveSet.h"
 #include "GameFramework/Character.h"
-#include "Kismet/KismetSystemLibrary.h"
+#include "GameFramework/PhysicsVolume.h"
+#include "GameFramework/PlayerController.h"
+#include "UObject/UObjectIterator.h"
 
 
 TAutoConsoleVariable<int> CVar_FeatureJumpCurve(TEXT("deft.feature.jump"), 1, TEXT("1=use custom jump curve logic, 0=use engine jump logic"), ECVF_Cheat);
+TAutoConsoleVariable<float> CVar_Feature_FixedStepHz(TEXT("deft.feature.fixedStepHz"), 120.f, TEXT("Rate Deft jump/fall/slide are simulated at regardless of frame rate, 0=simulate at the frame rate. Standalone only, networked games always simulate at the frame rate"), ECVF_Cheat);
+TAutoConsoleVariable<bool> CVar_Feature_FloorColumn(TEXT("deft.feature.floorColumn"), true, TEXT("true=skip floor sweeps while falling through space already known to be clear, false=sweep for a floor every step"), ECVF_Cheat);
 TAutoConsoleVariable<int> CVar_Feature_SlideMode(TEXT("deft.feature.slide"), 1, TEXT("0=slide distance is determined by entering velocity, 1=slide distance is consistent regardless of entering velocity"), ECVF_Cheat);
 
 TAutoConsoleVariable<bool> CVar_DebugLocks(TEXT("deft.debug.locks"), false, TEXT("show debugging for locks"), ECVF_Cheat);
@@ -17,12 +21,60 @@ TAutoConsoleVariable<bool> CVar_DebugJump(TEXT("deft.debug.jump"), false, TEXT("
 TAutoConsoleVariable<bool> CVar_DebugSlide(TEXT("deft.debug.slide"), false, TEXT("draw debug for sliding"), ECVF_Cheat);
 TAutoConsoleVariable<bool> CVar_DebugFall(TEXT("deft.debug.fall"), false, TEXT("draw debug for falling"), ECVF_Cheat);
 
+namespace
+{
+	// Jump policies
+	struct FCurveJumpPolicy { static constexpr bool bUsesCurves = true; };		// Deft jump/fall following the curves
+	struct FEngineJumpPolicy { static constexpr bool bUsesCurves = false; };		// UE jump + gravity, only for comparing against
+
+	// Slide policies
+	struct FVelocitySlidePolicy { static constexpr bool bIsDistanceFromVelocity = true; };		// slide distance is determined by entering velocity
+	struct FConstantSlidePolicy { static constexpr bool bIsDistanceFromVelocity = false; };		// slide distance is consistent regardless of entering velocity
+
+#if UE_BUILD_SHIPPING
+	// No cvars in shipping, add DEFT_SHIPPING_VELOCITY_SLIDE=1 to the Deft module definitions to ship the velocity based slide instead
+#ifndef DEFT_SHIPPING_VELOCITY_SLIDE
+#define DEFT_SHIPPING_VELOCITY_SLIDE 0
+#endif
+	using FShippingJumpPolicy = FCurveJumpPolicy;
+#if DEFT_SHIPPING_VELOCITY_SLIDE
+	using FShippingSlidePolicy = FVelocitySlidePolicy;
+#else
+	using FShippingSlidePolicy = FConstantSlidePolicy;
+#endif //DEFT_SHIPPING_VELOCITY_SLIDE
+#else
+	void OnMovementPolicyChanged(IConsoleVariable* aCVar)
+	{
+		for (TObjectIterator<UDeftCharacterMovementComponent> it; it; ++it)
+		{
+			if (!it->IsTemplate())
+				it->RefreshMovementPolicies();
+		}
+	}
+
+	// Components only look at the cvars when they change rather than on every tick
+	struct FMovementPolicyCVarCallbacks
+	{
+		FMovementPolicyCVarCallbacks()
+		{
+			CVar_FeatureJumpCurve.AsVariable()->SetOnChangedCallback(FConsoleVariableDelegate::CreateStatic(&OnMovementPolicyChanged));
+			CVar_Feature_SlideMode.AsVariable()->SetOnChangedCallback(FConsoleVariableDelegate::CreateStatic(&OnMovementPolicyChanged));
+		}
+	} MovementPolicyCVarCallbacks;
+#endif //UE_BUILD_SHIPPING
+}
+
 UDeftCharacterMovementComponent::UDeftCharacterMovementComponent(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 	, JumpCurve(nullptr)
 	, JumpFallCurve(nullptr)
 	, NonJumpFallCurve(nullptr)
 	, SlideCurve(nullptr)
+	, CurveSet(nullptr)
+	, JumpCurveBaked(nullptr)
+	, JumpFallCurveBaked(nullptr)
+	, NonJumpFallCurveBaked(nullptr)
+	, SlideCurveBaked(nullptr)
 	, SlideDirection(FVector::ZeroVector)
 	, SlideJumpAdditive(FVector::ZeroVector)
 	, FallCurveToUse(nullptr)
@@ -43,13 +95,45 @@ UDeftCharacterMovementComponent::UDeftCharacterMovementComponent(const FObjectIn
 	, SlideMinimumStartTime(0.f)
 	, SlideJumpSpeedMod(0.f)
 	, SlideJumpSpeedModMax(0.f)
+	, ForcedMovementRootMotionID((uint16)ERootMotionSourceID::Invalid)
+	, FixedStepPrevLocation(FVector::ZeroVector)
+	, FixedStepAccumulator(0.f)
+	, FixedStepBacklogMax(0.f)
+	, bHasFixedStepPrevLocation(false)
+	, bHasFixedStepRenderOffset(false)
+	, MoveSubstepRadiusFraction(0.f)
+	, MoveSubstepsMax(0)
+	, RoofNormalZMin(0.f)
+	, FloorColumnTop(FVector::ZeroVector)
+	, FloorColumnClearBottomZ(0.f)
+	, FloorColumnBuildTime(0.f)
+	, FloorColumnLength(0.f)
+	, FloorColumnMargin(0.f)
+	, FloorColumnMaxAge(0.f)
+	, bHasFloorColumn(false)
+	, LandingPrediction()
+	, LandingPredictionVelocity(FVector::ZeroVector)
+	, LandingPredictionLandTime(0.f)
+	, LandingPredictionBuildTime(0.f)
+	, LandingPredictionSweepLength(0.f)
+	, LandingPredictionVelocityTolerance(0.f)
+	, LandingPredictionMaxAge(0.f)
+	, bHasLandingPrediction(false)
 	, ImpulseFallDelay(0.f)
 	, ImpulseFallDelayMax(0.f)
 	, bIsJumping(false)
+	, bWasJumpingLastFrame(false)
 	, bIsValidJumpCurve(false)
 	, bIsFalling(false)
 	, bIsSliding(false)
 	, bIsInImpulse(false)
+#if !UE_BUILD_SHIPPING
+	, DoJumpPath(&UDeftCharacterMovementComponent::DoJumpWithPolicy<FCurveJumpPolicy>)
+	, IsFallingPath(&UDeftCharacterMovementComponent::IsFallingWithPolicy<FCurveJumpPolicy>)
+	, ProcessEngineFallingPath(&UDeftCharacterMovementComponent::ProcessEngineFallingWithPolicy<FCurveJumpPolicy>)
+	, DoSlidePath(&UDeftCharacterMovementComponent::DoSlideWithPolicy<FConstantSlidePolicy>)
+	, PhysDeftSlidePath(&UDeftCharacterMovementComponent::PhysDeftSlideWithPolicy<FConstantSlidePolicy>)
+#endif //!UE_BUILD_SHIPPING
 {
 }
 
@@ -57,24 +141,47 @@ void UDeftCharacterMovementComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	if (UClimbComponent* climbComponent = CharacterOwner->FindComponentByClass<UClimbComponent>())
-		climbComponent->OnLedgeUpDelegate.AddUObject(this, &UDeftCharacterMovementComponent::OnForcedMovementAction);
-
-	if (UGrappleComponent* grappleComponent = CharacterOwner->FindComponentByClass<UGrappleComponent>())
-		grappleComponent->OnGrapplePullDelegate.AddUObject(this, &UDeftCharacterMovementComponent::OnForcedMovementAction);
+#if !UE_BUILD_SHIPPING
+	RefreshMovementPolicies();
+#endif //!UE_BUILD_SHIPPING
 
 	bIsFalling = false;
 	bIsJumping = false;
 
-	if (JumpCurve)
+	// A curve set already baked and analyzed its curves when it was saved (and registered the bakes on load) so FindOrBake is just a lookup
+	if (CurveSet)
 	{
-		JumpCurve->GetTimeRange(JumpCurveStartTime, JumpCurveMaxTime);
+		JumpCurve = CurveSet->JumpCurve;
+		JumpFallCurve = CurveSet->JumpFallCurve;
+		NonJumpFallCurve = CurveSet->NonJumpFallCurve;
+		SlideCurve = CurveSet->SlideCurve;
+	}
 
-		float minHeight;
-		JumpCurve->GetValueRange(minHeight, JumpApexHeight);
+	// Curves are evaluated every substep, bake them once up front instead of key searching each time
+	JumpCurveBaked = FDeftBakedCurve::FindOrBake(JumpCurve);
+	JumpFallCurveBaked = FDeftBakedCurve::FindOrBake(JumpFallCurve);
+	NonJumpFallCurveBaked = FDeftBakedCurve::FindOrBake(NonJumpFallCurve);
+	SlideCurveBaked = FDeftBakedCurve::FindOrBake(SlideCurve);
 
-		if (!FindJumpApexTime(JumpApexTime))
-			UE_LOG(LogTemp, Error, TEXT("Invalid Jump Curve, no Apex found"));
+	if (JumpCurveBaked.IsValid())
+	{
+		JumpCurveBaked->GetTimeRange(JumpCurveStartTime, JumpCurveMaxTime);
+
+		if (CurveSet)
+		{
+			JumpApexTime = CurveSet->JumpApexTime;
+			JumpApexHeight = CurveSet->JumpApexHeight;
+			if (!CurveSet->bIsJumpApexValid)
+				UE_LOG(LogTemp, Error, TEXT("Invalid Jump Curve, no Apex found"));
+		}
+		else
+		{
+			float minHeight;
+			JumpCurveBaked->GetValueRange(minHeight, JumpApexHeight);
+
+			if (!FindJumpApexTime(JumpApexTime))
+				UE_LOG(LogTemp, Error, TEXT("Invalid Jump Curve, no Apex found"));
+		}
 
 		UE_LOG(LogTemp, Warning, TEXT("Jump Curve Time (min,max): (%f, %f)"), JumpCurveStartTime, JumpCurveMaxTime);
 		UE_LOG(LogTemp, Warning, TEXT("Jump Apex Height %f at time %f"), JumpApexTime, JumpApexHeight);
@@ -83,15 +190,15 @@ void UDeftCharacterMovementComponent::BeginPlay()
 		UE_LOG(LogTemp, Error, TEXT("Missing Jump Curve"));
 
 
-	if (!JumpFallCurve)
+	if (!JumpFallCurveBaked.IsValid())
 		UE_LOG(LogTemp, Error, TEXT("Missing jump Fall Curve"));
 
-	if (!NonJumpFallCurve)
+	if (!NonJumpFallCurveBaked.IsValid())
 		UE_LOG(LogTemp, Error, TEXT("Missing non-jump Fall Curve"));
 
-	if (SlideCurve)
+	if (SlideCurveBaked.IsValid())
 	{
-		SlideCurve->GetTimeRange(SlideCurveStartTime, SlideCurveMaxTime);
+		SlideCurveBaked->GetTimeRange(SlideCurveStartTime, SlideCurveMaxTime);
 		UE_LOG(LogTemp, Warning, TEXT("Slide Curve Time (min,max): (%f, %f)"), SlideCurveStartTime, SlideCurveMaxTime);
 	}
 	else 
@@ -104,30 +211,177 @@ void UDeftCharacterMovementComponent::BeginPlay()
 	SlideJumpSpeedModMax = 4.f;
 
 	ImpulseFallDelayMax = 2.f;
+
+	FixedStepBacklogMax = 0.25f;
+
+	MoveSubstepRadiusFraction = 0.5f;
+	MoveSubstepsMax = 8;
+	RoofNormalZMin = 0.3f;
+
+	FloorColumnLength = 2000.f;
+	FloorColumnMargin = 50.f;
+	FloorColumnMaxAge = 0.25f;
+
+	LandingPredictionSweepLength = 5000.f;
+	LandingPredictionVelocityTolerance = 10.f;
+	LandingPredictionMaxAge = 0.5f;
 }
 
 void UDeftCharacterMovementComponent::TickComponent(float aDeltaTime, enum ELevelTick aTickType, FActorComponentTickFunction* aThisTickFunction)
 {
+	// Deft jump, fall and slide are simulated by PhysCustom from within the base tick
 	Super::TickComponent(aDeltaTime, aTickType, aThisTickFunction);
-	
-	ProcessJumping(aDeltaTime);
-	ProcessFalling(aDeltaTime);
-	ProcessSliding(aDeltaTime);
+
+	// PhysDeftJump only runs while jumping, make sure walking off a ledge later doesn't think we just came out of a jump
+	bWasJumpingLastFrame = bIsJumping;
+
+	ProcessImpulseFallDelay(aDeltaTime);
+	ProcessEngineFalling();
+	ProcessForcedMovement();
+	UpdateFixedStepRenderOffset();
 
 #if !UE_BUILD_SHIPPING
 	DrawDebug();
 #endif //!UE_BUILD_SHIPPING
 }
 
+void UDeftCharacterMovementComponent::PhysCustom(float aDeltaTime, int32 aIterations)
+{
+	if (aDeltaTime < MIN_TICK_TIME)
+		return;
+
+	const float fixedStepTime = GetFixedStepTime();
+	if (fixedStepTime > 0.f)
+	{
+		PhysCustomFixedStep(aDeltaTime, aIterations, fixedStepTime);
+		return;
+	}
+
+	float remainingTime = aDeltaTime;
+	while (remainingTime >= MIN_TICK_TIME && aIterations < MaxSimulationIterations && MovementMode == MOVE_Custom && CharacterOwner)
+	{
+		++aIterations;
+		const float timeTick = GetSimulationTimeStep(remainingTime, aIterations);
+		remainingTime -= timeTick;
+
+		PhysDeftMode(timeTick);
+	}
+
+	// Landing or ending a slide mid-frame hands the rest of the frame to whichever mode we ended up in
+	if (MovementMode != MOVE_Custom && remainingTime >= MIN_TICK_TIME)
+		StartNewPhysics(remainingTime, aIterations);
+}
+
+void UDeftCharacterMovementComponent::PhysCustomFixedStep(float aDeltaTime, int32 aIterations, float aFixedStepTime)
+{
+	/*
+		The curves are integrated as a delta between this step's value and last step's, so variable steps make
+		the trajectory depend on frame rate. Always stepping by aFixedStepTime makes 30Hz and 240Hz walk the exact same path,
+		whatever time is left over waits in the accumulator for next frame and the mesh is interpolated to hide it (see UpdateFixedStepRenderOffset).
+		Every step the accumulator holds gets simulated, low frame rates just take more steps a frame. Only a hitch past FixedStepBacklogMax loses
+		time, otherwise we'd be simulating forever to catch up. MaxSimulationIterations is left for whatever mode we hand over to
+	*/
+	FixedStepAccumulator = FMath::Min(FixedStepAccumulator + aDeltaTime, FixedStepBacklogMax);
+
+	while (FixedStepAccumulator >= aFixedStepTime && MovementMode == MOVE_Custom && CharacterOwner)
+	{
+		FixedStepAccumulator -= aFixedStepTime;
+		FixedStepPrevLocation = UpdatedComponent->GetComponentLocation();
+		bHasFixedStepPrevLocation = true;
+
+		PhysDeftMode(aFixedStepTime);
+	}
+
+	if (MovementMode != MOVE_Custom)
+	{
+		// Landing or ending a slide hands whatever we had accumulated to the mode we ended up in
+		const float remainingTime = FixedStepAccumulator;
+		FixedStepAccumulator = 0.f;
+		bHasFixedStepPrevLocation = false;
+
+		if (remainingTime >= MIN_TICK_TIME)
+			StartNewPhysics(remainingTime, aIterations + 1);
+	}
+}
+
+void UDeftCharacterMovementComponent::PhysDeftMode(float aDeltaTime)
+{
+	switch (CustomMovementMode)
+	{
+	case CMOVE_DeftJump: PhysDeftJump(aDeltaTime);
+		break;
+	case CMOVE_DeftFall: PhysDeftFall(aDeltaTime);
+		break;
+	case CMOVE_DeftSlide: PhysDeftSlide(aDeltaTime);
+		break;
+	default:
+		UE_LOG(LogTemp, Error, TEXT("Unknown custom movement mode %u"), CustomMovementMode);
+		SetMovementMode(MOVE_Walking);
+		break;
+	}
+}
+
+float UDeftCharacterMovementComponent::GetFixedStepTime() const
+{
+	// The accumulator isn't part of saved moves, a server replaying our moves would take a different number of steps than we did and correct us
+	if (GetNetMode() != NM_Standalone)
+		return 0.f;
+
+	const float fixedStepHz = CVar_Feature_FixedStepHz.GetValueOnGameThread();
+	return fixedStepHz > 0.f ? 1.f / fixedStepHz : 0.f;
+}
+
+void UDeftCharacterMovementComponent::UpdateFixedStepRenderOffset()
+{
+	if (!CharacterOwner || !CharacterOwner->GetMesh())
+		return;
+
+	// Simulated proxies are smoothed by the engine which already owns the mesh offset, and nobody is looking on a dedicated server
+	if (CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy || IsNetMode(NM_DedicatedServer))
+		return;
+
+	const float fixedStepTime = GetFixedStepTime();
+	const bool shouldInterpolate = fixedStepTime > 0.f && bHasFixedStepPrevLocation && MovementMode == MOVE_Custom;
+	if (!shouldInterpolate)
+	{
+		if (bHasFixedStepRenderOffset)
+		{
+			CharacterOwner->GetMesh()->SetRelativeLocation(CharacterOwner->GetBaseTranslationOffset());
+			bHasFixedStepRenderOffset = false;
+		}
+		return;
+	}
+
+	// Render one step behind the simulation, as far between the last two steps as we are into the next one.
+	// The camera rides on the mesh (via the spring arm) so this smooths the view as well
+	const float alpha = FMath::Clamp(FixedStepAccumulator / fixedStepTime, 0.f, 1.f);
+	const FVector simLocation = UpdatedComponent->GetComponentLocation();
+	const FVector renderLocation = FMath::Lerp(FixedStepPrevLocation, simLocation, alpha);
+	const FVector localOffset = UpdatedComponent->GetComponentTransform().InverseTransformVectorNoScale(renderLocation - simLocation);
+
+	CharacterOwner->GetMesh()->SetRelativeLocation(CharacterOwner->GetBaseTranslationOffset() + localOffset);
+	bHasFixedStepRenderOffset = true;
+}
+
 bool UDeftCharacterMovementComponent::DoJump(bool bReplayingMoves)
 {
-#if !UE_BUILD_SHIPPING
-	if (!IsJumpCurveEnabled())
+#if UE_BUILD_SHIPPING
+	return DoJumpWithPolicy<FShippingJumpPolicy>(bReplayingMoves);
+#else
+	return (this->*DoJumpPath)(bReplayingMoves);
+#endif //UE_BUILD_SHIPPING
+}
+
+template<class TJumpPolicy>
+bool UDeftCharacterMovementComponent::DoJumpWithPolicy(bool bReplayingMoves)
+{
+	if constexpr (!TJumpPolicy::bUsesCurves)
 	{
+#if !UE_BUILD_SHIPPING
 		GEngine->AddOnScreenDebugMessage(-1, 1.f, FColor::Red, TEXT("Jump curve disabled"));
+#endif//!UE_BUILD_SHIPPING
 		return Super::DoJump(bReplayingMoves);
 	}
-#endif//!UE_BUILD_SHIPPING
 
 	if (bIsJumping)
 		return false;
@@ -146,16 +400,17 @@ bool UDeftCharacterMovementComponent::DoJump(bool bReplayingMoves)
 				StopSlide();
 			}
 
-			// Ignore gravity but keep UE air control
-			SetMovementMode(MOVE_Flying);
-
 			bIsJumping = true;
 			bIsFalling = false;
 
 			JumpTime = JumpCurveStartTime;
 
 			PrevJumpTime = JumpTime;
-			PrevJumpCurveVal = JumpCurve->GetFloatValue(JumpTime);
+			PrevJumpCurveVal = JumpCurveBaked.IsValid() ? JumpCurveBaked->Eval(JumpTime) : 0.f;
+			bHasLandingPrediction = false;
+
+			// Ignore gravity, PhysDeftJump moves us along the curve and keeps UE air control
+			SetMovementMode(MOVE_Custom, CMOVE_DeftJump);
 
 #if !UE_BUILD_SHIPPING
 			Debug_JumpHeightApex = 0.f;
@@ -170,17 +425,41 @@ bool UDeftCharacterMovementComponent::DoJump(bool bReplayingMoves)
 
 bool UDeftCharacterMovementComponent::IsFalling() const
 {
-	// overriding default engine IsFalling() for animation reasons since we logically are in MOVE_Flying during any Jump or Fall
+#if UE_BUILD_SHIPPING
+	return IsFallingWithPolicy<FShippingJumpPolicy>();
+#else
+	return (this->*IsFallingPath)();
+#endif //UE_BUILD_SHIPPING
+}
+
+template<class TJumpPolicy>
+bool UDeftCharacterMovementComponent::IsFallingWithPolicy() const
+{
+	// overriding default engine IsFalling() for animation reasons since we logically are in MOVE_Custom during any Jump or Fall
 	// however animations may need to know if we're falling
-#if !UE_BUILD_SHIPPING
-	if (!IsJumpCurveEnabled())
+	if constexpr (!TJumpPolicy::bUsesCurves)
 		return Super::IsFalling();
-#endif
-	// note: This causes horizontal collisions to break when jumping or falling into collision
-	// TODO: investigate cause, my assumption is that the engine is colliding which puts us into MOVE_Walking, then it sees it's IsFalling() (because of our override)
-	// and puts us in MOVE_Falling, and the cycle repeats
-	// Can be investigated
-	return Super::IsFalling() || bIsJumping || bIsFalling;
+
+	// note: Keyed off the movement mode rather than bIsJumping/bIsFalling. Back when jump/fall ran in MOVE_Flying the engine would collide us into MOVE_Walking,
+	// see IsFalling() and put us in MOVE_Falling, and the cycle repeated. Our own modes are never touched by the engine so that loop can't happen anymore
+	const bool isDeftAirborne = MovementMode == MOVE_Custom && (CustomMovementMode == CMOVE_DeftJump || CustomMovementMode == CMOVE_DeftFall);
+	return Super::IsFalling() || isDeftAirborne;
+}
+
+float UDeftCharacterMovementComponent::GetMaxSpeed() const
+{
+	if (MovementMode == MOVE_Custom)
+		return MaxFlySpeed;
+
+	return Super::GetMaxSpeed();
+}
+
+float UDeftCharacterMovementComponent::GetMaxBrakingDeceleration() const
+{
+	if (MovementMode == MOVE_Custom)
+		return BrakingDecelerationFlying;
+
+	return Super::GetMaxBrakingDeceleration();
 }
 
 bool UDeftCharacterMovementComponent::CanAttemptJump() const
@@ -200,8 +479,18 @@ void UDeftCharacterMovementComponent::OnMovementModeChanged(EMovementMode Previo
 {
 	Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
 
-	if (MovementMode == MOVE_Flying)
+	if (MovementMode == MOVE_Flying || MovementMode == MOVE_Custom)
 		bCrouchMaintainsBaseLocation = true;
+
+	// Fixed step time and the floor column only carry between Deft modes, anything left from a previous stint in them is stale
+	if (MovementMode == MOVE_Custom && PreviousMovementMode != MOVE_Custom)
+	{
+		FixedStepAccumulator = 0.f;
+		bHasFixedStepPrevLocation = false;
+		bHasFloorColumn = false;
+	}
+
+	bHasLandingPrediction = false;
 }
 
 bool UDeftCharacterMovementComponent::CanStepUp(const FHitResult& Hit) const
@@ -226,18 +515,58 @@ void UDeftCharacterMovementComponent::OnForcedMovementAction(bool aIsStarted)
 		SetCustomFallingMode();
 }
 
-void UDeftCharacterMovementComponent::ProcessJumping(float aDeltaTime)
+uint16 UDeftCharacterMovementComponent::ApplyForcedMovement(TSharedPtr<FRootMotionSource> aForcedMovementSource)
+{
+	// Only one thing gets to drag the character around at a time
+	if (ForcedMovementRootMotionID != (uint16)ERootMotionSourceID::Invalid)
+		RemoveRootMotionSourceByID(ForcedMovementRootMotionID);
+
+	// MOVE_Flying ignores gravity and PhysFlying does a single swept move with whatever velocity the root motion source asks for
+	OnForcedMovementAction(true);
+	ForcedMovementRootMotionID = ApplyRootMotionSource(aForcedMovementSource);
+
+	return ForcedMovementRootMotionID;
+}
+
+void UDeftCharacterMovementComponent::StopForcedMovement(uint16 aForcedMovementID)
+{
+	if (aForcedMovementID == (uint16)ERootMotionSourceID::Invalid || aForcedMovementID != ForcedMovementRootMotionID)
+		return;
+
+	// ProcessForcedMovement picks up that the source is gone and hands us back to falling
+	RemoveRootMotionSourceByID(aForcedMovementID);
+}
+
+bool UDeftCharacterMovementComponent::IsForcedMovementActive(uint16 aForcedMovementID)
+{
+	return aForcedMovementID != (uint16)ERootMotionSourceID::Invalid && GetRootMotionSourceByID(aForcedMovementID).IsValid();
+}
+
+void UDeftCharacterMovementComponent::ProcessForcedMovement()
+{
+	if (ForcedMovementRootMotionID == (uint16)ERootMotionSourceID::Invalid)
+		return;
+
+	// Finished sources are cleaned up by the base movement tick
+	if (IsForcedMovementActive(ForcedMovementRootMotionID))
+		return;
+
+	ForcedMovementRootMotionID = (uint16)ERootMotionSourceID::Invalid;
+	OnForcedMovementAction(false);
+}
+
+void UDeftCharacterMovementComponent::PhysDeftJump(float aDeltaTime)
 {
 	bWasJumpingLastFrame = bIsJumping;
 
-	if (!JumpCurve || !bIsJumping)
+	if (!JumpCurveBaked.IsValid() || !bIsJumping)
 		return;
 
 	JumpTime += aDeltaTime;
 	if (JumpTime <= JumpCurveMaxTime)
 	{
 		// Get the new character location
-		float jumpCurveVal = JumpCurve->GetFloatValue(JumpTime);
+		float jumpCurveVal = JumpCurveBaked->Eval(JumpTime);
 
 		// Make sure that the character always reaches the jump apex height and notify character about reaching apex
 		bool isJumpApexReached = PrevJumpTime < JumpApexTime && JumpTime > JumpApexTime;
@@ -252,82 +581,54 @@ void UDeftCharacterMovementComponent::ProcessJumping(float aDeltaTime)
 		const float jumpCurveValDelta = jumpCurveVal - PrevJumpCurveVal;
 		PrevJumpCurveVal = jumpCurveVal;
 
-		// when in MOVE_Flying the base character movement component will move the character based off velocity
-		// yet we want to move based off the curve position
-		// TODO(optional): consider using custom and making specific movement modes for these custom jump & falling
-		// which means we'll have to handle input when the character is in the air just as a heads up
-		Velocity.Z = 0.f;
+		// The curve owns the vertical axis, input only steers us horizontally
+		CalcAirControlVelocity(aDeltaTime);
 		float yVelocity = jumpCurveValDelta / aDeltaTime; //note: velocity = distance / time
 
-		const FVector actorLocation = GetActorLocation();
-		FVector destinationLocation = actorLocation + FVector(0.f, 0.f, jumpCurveValDelta) + SlideJumpAdditive;
+		const FVector actorLocation = UpdatedComponent->GetComponentLocation();
+		FVector destinationLocation = actorLocation + (Velocity * aDeltaTime) + FVector(0.f, 0.f, jumpCurveValDelta) + SlideJumpAdditive;
 
-		// Check roof collision if character is moving up
-		if (yVelocity > 0.f)
-		{
-			FCollisionQueryParams roofCheckCollisionParams;
-			roofCheckCollisionParams.AddIgnoredActor(CharacterOwner);
-			// TODO: could cache this since the capsule shape isn't going to change dynamically 
-			const UCapsuleComponent* capsulComponent = CharacterOwner->GetCapsuleComponent();
-			FCollisionShape capsulShape = FCollisionShape::MakeCapsule(capsulComponent->GetScaledCapsuleRadius(), capsulComponent->GetScaledCapsuleHalfHeight());
-
-			FHitResult roofHitResult;
-			const bool bIsBlockingHit = GetWorld()->SweepSingleByProfile(roofHitResult, actorLocation, destinationLocation, CharacterOwner->GetActorRotation().Quaternion(), capsulComponent->GetCollisionProfileName(), capsulShape, roofCheckCollisionParams);
-			if (bIsBlockingHit)
-			{
-				// To be sure we actually hit a roof and not just intersected with an object due to slide + jump speed moving the component too far
-				// do another check only taking into account the destination's vertical location
-				const FVector destVertOnly = FVector(actorLocation.X, actorLocation.Y, destinationLocation.Z);
-				const bool bStillCollidedVertically = GetWorld()->SweepSingleByProfile(roofHitResult, actorLocation, destVertOnly, CharacterOwner->GetActorRotation().Quaternion(), capsulComponent->GetCollisionProfileName(), capsulShape, roofCheckCollisionParams);
-
-				// Now we are confident we actually hit a roof
-				if (bStillCollidedVertically)
-				{
-					// Roof collision hit
-					SetCustomFallingMode();
-
-					bIsJumping = false;
-					CharacterOwner->StopJumping();
-
-					// Reset vertical velocity to let gravity do the work
-					Velocity.Z = 0.f;
-
-					// Take character to a safe location where its not hitting roof
-					// TODO: this can be improved by using the impact location and using that
-					destinationLocation = actorLocation;
-				}
-			}
-
-#if !UE_BUILD_SHIPPING
-			// accumulating distance traveled UPWARDS to find the apex
-			Debug_JumpHeightApex += (destinationLocation.Z - actorLocation.Z);
-#endif //!UE_BUILD_SHIPPING
-		}
-
-		// There is no floor checks while in MOVE_Flying so do it manually
+		// Deft modes have no floor checks so do it manually
 		bool landedOnFloor = false;
 		if (yVelocity < 0.f)
 		{
-			const FVector capsulLoc = UpdatedComponent->GetComponentLocation();
 			FFindFloorResult floorResult;
-			if (FindFloorBySweep(floorResult, capsulLoc, destinationLocation))
+			if (FindFloorBySweep(floorResult, actorLocation, destinationLocation))
 			{
 				const float floorDistance = floorResult.GetDistanceToFloor();
 				if (FMath::Abs(jumpCurveValDelta) > floorDistance)
-					destinationLocation = capsulLoc - FVector(0.f, 0.f, floorDistance);
-
-				SetMovementMode(MOVE_Walking);
+					destinationLocation = actorLocation - FVector(0.f, 0.f, floorDistance);
 
-				bIsJumping = false;
-				CharacterOwner->StopJumping();
 				landedOnFloor = true;
 			}
 		}
 
-		// Move the actual capsule component in the world
-		FLatentActionInfo latentInfo;
-		latentInfo.CallbackTarget = this;
-		UKismetSystemLibrary::MoveComponentTo((USceneComponent*)CharacterOwner->GetCapsuleComponent(), destinationLocation, CharacterOwner->GetActorRotation(), false, false, 0.f, true, EMoveComponentAction::Type::Move, latentInfo);
+		// Move the actual capsule component in the world, the move itself tells us if we bumped into a roof on the way up
+		const bool hitRoof = MoveDeft(destinationLocation - actorLocation, aDeltaTime) && yVelocity > 0.f;
+
+#if !UE_BUILD_SHIPPING
+		// accumulating distance traveled UPWARDS to find the apex
+		if (yVelocity > 0.f)
+			Debug_JumpHeightApex += (UpdatedComponent->GetComponentLocation().Z - actorLocation.Z);
+#endif //!UE_BUILD_SHIPPING
+
+		if (hitRoof)
+		{
+			// Roof collision hit
+			SetCustomFallingMode();
+
+			bIsJumping = false;
+			CharacterOwner->StopJumping();
+
+			// Reset vertical velocity to let gravity do the work
+			Velocity.Z = 0.f;
+		}
+		else if (landedOnFloor)
+		{
+			bIsJumping = false;
+			SetMovementMode(MOVE_Walking);
+			CharacterOwner->StopJumping();
+		}
 
 		// Notifying for animation support. Nothing in code is actively using this atm
 		if (isJumpApexReached && bNotifyApex)
@@ -364,82 +665,79 @@ void UDeftCharacterMovementComponent::ProcessJumping(float aDeltaTime)
 	}
 }
 
-void UDeftCharacterMovementComponent::ProcessFalling(float aDeltaTime)
+void UDeftCharacterMovementComponent::PhysDeftFall(float aDeltaTime)
 {
 	if (bIsInImpulse)
 	{
-		ProcessImpulseFallDelay(aDeltaTime);
+		// Impulse owns the fall until its delay runs out, carry its velocity through like MOVE_Flying used to
+		MoveDeft(Velocity * aDeltaTime, aDeltaTime);
 		return;
 	}
 
-	if (bIsFalling)
-	{
-		if (!FallCurveToUse)
-		{
-			UE_LOG(LogTemp, Error, TEXT("Missing FallCurveToUse!"));
-			return;
-		}
-
-		FallTime += aDeltaTime;
+	if (!bIsFalling)
+		return;
 
-		const float fallCurveVal = FallCurveToUse->GetFloatValue(FallTime);
-		const float fallCurveValDelta = fallCurveVal - PrevFallCurveVal;
-		PrevFallCurveVal = fallCurveVal;
+	if (!FallCurveToUse.IsValid())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Missing FallCurveToUse!"));
+		return;
+	}
 
-		Velocity.Z = 0.f;
+	FallTime += aDeltaTime;
 
-		const FVector capsuleLocation = UpdatedComponent->GetComponentLocation();
-		FVector destinationLocation = capsuleLocation + FVector(0.f, 0.f, fallCurveValDelta);
+	const float fallCurveVal = FallCurveToUse->Eval(FallTime);
+	const float fallCurveValDelta = fallCurveVal - PrevFallCurveVal;
+	PrevFallCurveVal = fallCurveVal;
 
-		bool landedOnFloor = false;
-		FFindFloorResult floorResult;
-		if (FindFloorBySweep(floorResult, capsuleLocation, destinationLocation))
-		{
-			const float floorDistance = floorResult.GetDistanceToFloor();
-			if (FMath::Abs(fallCurveValDelta) > floorDistance)
-				destinationLocation = capsuleLocation - FVector(0.f, 0.f, floorDistance);
+	CalcAirControlVelocity(aDeltaTime);
 
-			bIsFalling = false;
+	const FVector capsuleLocation = UpdatedComponent->GetComponentLocation();
+	FVector destinationLocation = capsuleLocation + (Velocity * aDeltaTime) + FVector(0.f, 0.f, fallCurveValDelta);
 
-			// Stopping the character and canceling all the movement carried from before the jump/fall
-			// note: Remove if you want to carry the momentum
-			Velocity = FVector::ZeroVector;
+	bool landedOnFloor = false;
+	FFindFloorResult floorResult;
+	if (FindFloorBySweep(floorResult, capsuleLocation, destinationLocation))
+	{
+		const float floorDistance = floorResult.GetDistanceToFloor();
+		if (FMath::Abs(fallCurveValDelta) > floorDistance)
+			destinationLocation = capsuleLocation - FVector(0.f, 0.f, floorDistance);
 
-			SetMovementMode(MOVE_Walking);
-			landedOnFloor = true;
+		landedOnFloor = true;
 
-			//DrawDebugCapsule(GetWorld(), destinationLocation, CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleHalfHeight(), CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleRadius(), CharacterOwner->GetActorRotation().Quaternion(), FColor::Yellow, false, 5.f);
-		}
+		//DrawDebugCapsule(GetWorld(), destinationLocation, CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleHalfHeight(), CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleRadius(), CharacterOwner->GetActorRotation().Quaternion(), FColor::Yellow, false, 5.f);
+	}
 
-		FLatentActionInfo latentInfo;
-		latentInfo.CallbackTarget = this;
-		UKismetSystemLibrary::MoveComponentTo((USceneComponent*)CharacterOwner->GetCapsuleComponent(), destinationLocation, CharacterOwner->GetActorRotation(), false, false, 0.f, true, EMoveComponentAction::Move, latentInfo);
+	MoveDeft(destinationLocation - capsuleLocation, aDeltaTime);
 
-		if (landedOnFloor)
-			OnLandedFromAir.Broadcast();
-	}
-	else if (MovementMode == EMovementMode::MOVE_Falling)
+	if (landedOnFloor)
 	{
-		// Dropping down from ledge while walking should use our custom fall logic
-		// TODO: need a fall curve for when not jumping I think otherwise it's a little too aggressive of a fall
+		bIsFalling = false;
 
-#if !UE_BUILD_SHIPPING
-		// note: not doing it during engine jump since engine jump uses falling
-		if (!IsJumpCurveEnabled())
-			return;
-#endif
+		// Stopping the character and canceling all the movement carried from before the jump/fall
+		// note: Remove if you want to carry the momentum
+		Velocity = FVector::ZeroVector;
 
-		//UE_LOG(LogTemp, Warning, TEXT("UE MOVE_Falling"));
-		SetCustomFallingMode();
+		SetMovementMode(MOVE_Walking);
+		OnLandedFromAir.Broadcast();
 	}
 }
 
-void UDeftCharacterMovementComponent::ProcessSliding(float aDeltaTime)
+void UDeftCharacterMovementComponent::PhysDeftSlide(float aDeltaTime)
+{
+#if UE_BUILD_SHIPPING
+	PhysDeftSlideWithPolicy<FShippingSlidePolicy>(aDeltaTime);
+#else
+	(this->*PhysDeftSlidePath)(aDeltaTime);
+#endif //UE_BUILD_SHIPPING
+}
+
+template<class TSlidePolicy>
+void UDeftCharacterMovementComponent::PhysDeftSlideWithPolicy(float aDeltaTime)
 {
 	if (!bIsSliding)
 		return;
 
-	if (!SlideCurve)
+	if (!SlideCurveBaked.IsValid())
 		return;
 
 	if (bIsJumping || bIsFalling)
@@ -448,11 +746,7 @@ void UDeftCharacterMovementComponent::ProcessSliding(float aDeltaTime)
 		return;
 	}
 
-	float slideMaxTime = 0.f;
-	if (CVar_Feature_SlideMode.GetValueOnGameThread() == 0) // Velocity based slide distance
-		slideMaxTime = SlideCurveMaxTime;
-	else if (CVar_Feature_SlideMode.GetValueOnGameThread() == 1) // Constant slide distance
-		slideMaxTime = SlideMaxTime;
+	const float slideMaxTime = TSlidePolicy::bIsDistanceFromVelocity ? SlideCurveMaxTime : SlideMaxTime;
 
 	// move component based off curve (increasing speed essentially)
 	const float prevSlideTime = SlideTime;
@@ -471,18 +765,10 @@ void UDeftCharacterMovementComponent::ProcessSliding(float aDeltaTime)
 		}
 	}
 
-	float slideSpeed = 0.f;
-	if (CVar_Feature_SlideMode.GetValueOnGameThread() == 0) // Velocity based slide distance
-		slideSpeed = SlideCurve->GetFloatValue(SlideTime);
-	else if (CVar_Feature_SlideMode.GetValueOnGameThread() == 1) // Constant slide distance
-		slideSpeed = SlideSpeedMax;
-
-	const FVector actorLocation = CharacterOwner->GetActorLocation();
-	const FVector destinationLocation = actorLocation + (SlideDirection * slideSpeed * aDeltaTime);
+	const float slideSpeed = TSlidePolicy::bIsDistanceFromVelocity ? SlideCurveBaked->Eval(SlideTime) : SlideSpeedMax;
 
-	FLatentActionInfo latentInfo;
-	latentInfo.CallbackTarget = this;
-	UKismetSystemLibrary::MoveComponentTo((USceneComponent*)CharacterOwner->GetCapsuleComponent(), destinationLocation, CharacterOwner->GetActorRotation(), false, false, 0.f, true, EMoveComponentAction::Move, latentInfo);
+	// Velocity stays zeroed during the slide (see DoSlide), the slide direction is all that moves us
+	MoveDeft(SlideDirection * slideSpeed * aDeltaTime, aDeltaTime);
 
 #if !UE_BUILD_SHIPPING
 	Debug_SlideVal = slideSpeed;
@@ -490,6 +776,36 @@ void UDeftCharacterMovementComponent::ProcessSliding(float aDeltaTime)
 #endif
 }
 
+void UDeftCharacterMovementComponent::ProcessEngineFalling()
+{
+#if UE_BUILD_SHIPPING
+	ProcessEngineFallingWithPolicy<FShippingJumpPolicy>();
+#else
+	(this->*ProcessEngineFallingPath)();
+#endif //UE_BUILD_SHIPPING
+}
+
+template<class TJumpPolicy>
+void UDeftCharacterMovementComponent::ProcessEngineFallingWithPolicy()
+{
+	// note: not doing it during engine jump since engine jump uses falling
+	if constexpr (!TJumpPolicy::bUsesCurves)
+		return;
+
+	// Impulses are allowed to use engine falling until their delay runs out
+	if (bIsInImpulse)
+		return;
+
+	if (MovementMode != EMovementMode::MOVE_Falling)
+		return;
+
+	// Dropping down from ledge while walking should use our custom fall logic
+	// TODO: need a fall curve for when not jumping I think otherwise it's a little too aggressive of a fall
+
+	//UE_LOG(LogTemp, Warning, TEXT("UE MOVE_Falling"));
+	SetCustomFallingMode();
+}
+
 void UDeftCharacterMovementComponent::ProcessImpulseFallDelay(float aDeltaTime)
 {
 	if (!bIsInImpulse)
@@ -500,9 +816,70 @@ void UDeftCharacterMovementComponent::ProcessImpulseFallDelay(float aDeltaTime)
 		bIsInImpulse = false;
 }
 
+const FDeftCollisionContext& UDeftCharacterMovementComponent::GetCollisionContext() const
+{
+	// Only ever created with a Deft character (see ADeftPlayerCharacter's constructor)
+	return static_cast<const ADeftPlayerCharacter*>(CharacterOwner)->GetCollisionContext();
+}
+
+void UDeftCharacterMovementComponent::CalcAirControlVelocity(float aDeltaTime)
+{
+	// Same horizontal input handling PhysFlying gives, the vertical axis belongs to the jump/fall curves
+	Velocity.Z = 0.f;
+	if (!HasAnimRootMotion() && !CurrentRootMotion.HasOverrideVelocity())
+		CalcVelocity(aDeltaTime, 0.5f * GetPhysicsVolume()->FluidFriction, true, GetMaxBrakingDeceleration());
+	Velocity.Z = 0.f;
+}
+
+bool UDeftCharacterMovementComponent::MoveDeft(const FVector& aDelta, float aDeltaTime)
+{
+	if (aDelta.IsNearlyZero())
+		return false;
+
+	/*
+		At 120Hz fixed steps even a full speed slide (SlideSpeedMax) only moves ~10 units a step, but stepping at the frame rate (fixedStepHz 0, networked games)
+		on a slow frame that's 40+ units, as much as a capsule radius, and a long fall gets faster than that. A single sweep + slide only gets one bounce off
+		whatever it hits, so those moves are split into segments no longer than a fraction of the capsule radius. Almost every step fits in one segment so it's still one sweep.
+		Each segment's hit normal tells roofs (facing down) apart from walls we just clipped sideways, no second sweep needed to double check
+	*/
+	const float segmentLengthMax = GetCollisionContext().CapsuleShape.GetCapsuleRadius() * MoveSubstepRadiusFraction;
+	const int numSegments = segmentLengthMax > 0.f ? FMath::Clamp(FMath::CeilToInt(aDelta.Size() / segmentLengthMax), 1, MoveSubstepsMax) : 1;
+	const FVector segmentDelta = aDelta / numSegments;
+	const float segmentTime = aDeltaTime / numSegments;
+
+	for (int i = 0; i < numSegments; ++i)
+	{
+		// sliding along whatever we bump into instead of stopping dead
+		FHitResult hit(1.f);
+		SafeMoveUpdatedComponent(segmentDelta, UpdatedComponent->GetComponentQuat(), true, hit);
+		if (!hit.IsValidBlockingHit())
+			continue;
+
+		HandleImpact(hit, segmentTime, segmentDelta);
+
+		const bool isRoof = segmentDelta.Z > 0.f && hit.Normal.Z < -RoofNormalZMin;
+		if (isRoof)
+			return true;
+
+		SlideAlongSurface(segmentDelta, 1.f - hit.Time, hit.Normal, hit, true);
+	}
+
+	return false;
+}
+
 // TODO: there is a bug where if you're walking into collision that you _can_ slide under, when you slide you'll be displaced horizontally 
 // as if it were an impassible wall instead of sliding under it
 void UDeftCharacterMovementComponent::DoSlide()
+{
+#if UE_BUILD_SHIPPING
+	DoSlideWithPolicy<FShippingSlidePolicy>();
+#else
+	(this->*DoSlidePath)();
+#endif //UE_BUILD_SHIPPING
+}
+
+template<class TSlidePolicy>
+void UDeftCharacterMovementComponent::DoSlideWithPolicy()
 {
 	// Don't allow sliding while currently sliding
 	if (bIsSliding)
@@ -523,7 +900,7 @@ void UDeftCharacterMovementComponent::DoSlide()
 
 	DeftLocks::IncrementInputLockRef();
 
-	SetMovementMode(MOVE_Flying);
+	SetMovementMode(MOVE_Custom, CMOVE_DeftSlide);
 
 	bIsSliding = true;
 
@@ -540,7 +917,7 @@ void UDeftCharacterMovementComponent::DoSlide()
 	const float minSpeedPercent = 0.5f;
 	float speedPercent = 1.f;
 
-	if (CVar_Feature_SlideMode.GetValueOnGameThread() == 0) // Velocity based slide distance
+	if constexpr (TSlidePolicy::bIsDistanceFromVelocity)
 	{
 		// min speed percent makes sure we can still slide even at very low velocities
 		speedPercent = FMath::Max(minSpeedPercent, Velocity.Length() / GetMaxSpeed());
@@ -552,7 +929,7 @@ void UDeftCharacterMovementComponent::DoSlide()
 
 	// SlideCurveMaxTime: For velocity curve based slide determines how far into the slide curve to start inverse proportional to speed.
 	// SlideMaxTime: constant slide speed
-	float slideMaxtime = CVar_Feature_SlideMode.GetValueOnGameThread() == 0 ? SlideCurveMaxTime : SlideMaxTime;
+	const float slideMaxtime = TSlidePolicy::bIsDistanceFromVelocity ? SlideCurveMaxTime : SlideMaxTime;
 	SlideTime = slideMaxtime - (slideMaxtime * speedPercent);
 
 	// Jump displacement is affected by slide (i.e. slide to jump greater distances)
@@ -606,11 +983,14 @@ void UDeftCharacterMovementComponent::SetCustomFallingMode()
 	Velocity.Z = 0.f;				// !important! so that velocity from jump doesn't get carried over to falling
 
 	// hitting something while ascending on the jump is jarring if we use the JumpFall curve which is linear 
-	FallCurveToUse = NonJumpFallCurve;
+	FallCurveToUse = NonJumpFallCurveBaked;
 	if (bWasJumpingLastFrame && PrevJumpTime > JumpApexTime)
-		FallCurveToUse = JumpFallCurve;
+		FallCurveToUse = JumpFallCurveBaked;
+
+	// may already be in CMOVE_DeftFall in which case the mode change below won't do this for us
+	bHasLandingPrediction = false;
 
-	SetMovementMode(EMovementMode::MOVE_Flying);
+	SetMovementMode(MOVE_Custom, CMOVE_DeftFall);
 }
 
 bool UDeftCharacterMovementComponent::FindFloorBySweep(FFindFloorResult& outFloorResult, const FVector aStartLoc, const FVector aEndLoc)
@@ -619,13 +999,13 @@ bool UDeftCharacterMovementComponent::FindFloorBySweep(FFindFloorResult& outFloo
 	// Solving paper bullet problem if player is falling very fast (i.e 100+ units in a frame) which means FindFloor would become inaccurate
 	// However you can pass a collision test into the FindFloor() function to have it included in the calculation
 
-	FCollisionQueryParams floorCheckCollisionParams;
-	floorCheckCollisionParams.AddIgnoredActor(CharacterOwner);
-	const UCapsuleComponent* capsulComponent = CharacterOwner->GetCapsuleComponent();
-	FCollisionShape capsulShape = FCollisionShape::MakeCapsule(capsulComponent->GetScaledCapsuleRadius(), capsulComponent->GetScaledCapsuleHalfHeight());
+	if (IsInsideClearFloorColumn(aStartLoc, aEndLoc))
+		return false;
+
+	const FDeftCollisionContext& collisionContext = GetCollisionContext();
 
 	FHitResult floorHitResult;
-	const bool bIsBlockingHit = GetWorld()->SweepSingleByProfile(floorHitResult, aStartLoc, aEndLoc, CharacterOwner->GetActorRotation().Quaternion(), capsulComponent->GetCollisionProfileName(), capsulShape, floorCheckCollisionParams);
+	const bool bIsBlockingHit = GetWorld()->SweepSingleByProfile(floorHitResult, aStartLoc, aEndLoc, collisionContext.GetCapsuleRotation(), collisionContext.CapsuleProfileName, collisionContext.CapsuleShape, collisionContext.QueryParams);
 	if (bIsBlockingHit)
 	{
 		FindFloor(aStartLoc, outFloorResult, false, &floorHitResult);
@@ -634,6 +1014,176 @@ bool UDeftCharacterMovementComponent::FindFloorBySweep(FFindFloorResult& outFloo
 	return false;
 }
 
+bool UDeftCharacterMovementComponent::IsInsideClearFloorColumn(const FVector& aStartLoc, const FVector& aEndLoc)
+{
+	if (!CVar_Feature_FloorColumn.GetValueOnGameThread())
+		return false;
+
+	auto isColumnUsable = [this, &aStartLoc, &aEndLoc]()
+	{
+		const float marginSquared = FloorColumnMargin * FloorColumnMargin;
+		return bHasFloorColumn &&
+			GetWorld()->GetTimeSeconds() - FloorColumnBuildTime <= FloorColumnMaxAge &&
+			aStartLoc.Z <= FloorColumnTop.Z &&
+			FVector::DistSquared2D(aStartLoc, FloorColumnTop) <= marginSquared &&
+			FVector::DistSquared2D(aEndLoc, FloorColumnTop) <= marginSquared;
+	};
+
+	// Once we've fallen through all the clear space the column stays put so we're back to sweeping every step instead of rebuilding it
+	if (!isColumnUsable())
+		BuildFloorColumn(aStartLoc);
+
+	return isColumnUsable() && aEndLoc.Z >= FloorColumnClearBottomZ;
+}
+
+void UDeftCharacterMovementComponent::BuildFloorColumn(const FVector& aTopLoc)
+{
+	/*
+		One long sweep straight down with a capsule fattened by FloorColumnMargin tells us how far we can fall before touching anything,
+		as long as we don't drift further than the margin sideways. Only static geometry can be trusted to still be where it was when we get there,
+		so anything dynamic in (or at the end of) the column means we don't trust any of it and sweep every step like before.
+	*/
+	FloorColumnTop = aTopLoc;
+	FloorColumnBuildTime = GetWorld()->GetTimeSeconds();
+	FloorColumnClearBottomZ = TNumericLimits<float>::Max();
+	bHasFloorColumn = true;
+
+	const FDeftCollisionContext& collisionContext = GetCollisionContext();
+	const float columnRadius = collisionContext.CapsuleShape.GetCapsuleRadius() + FloorColumnMargin;
+	const float columnHalfHeight = collisionContext.CapsuleShape.GetCapsuleHalfHeight() + FloorColumnMargin;
+
+	float clearDistance = FloorColumnLength;
+	FHitResult columnHit;
+	if (GetWorld()->SweepSingleByProfile(columnHit, aTopLoc, aTopLoc - FVector(0.f, 0.f, FloorColumnLength), collisionContext.GetCapsuleRotation(), collisionContext.CapsuleProfileName, FCollisionShape::MakeCapsule(columnRadius, columnHalfHeight), collisionContext.QueryParams))
+	{
+		const UPrimitiveComponent* hitComponent = columnHit.GetComponent();
+		if (!hitComponent || hitComponent->Mobility != EComponentMobility::Static)
+			return;
+
+		clearDistance = columnHit.Distance;
+	}
+
+	const FVector columnCenter = aTopLoc - FVector(0.f, 0.f, clearDistance / 2.f);
+	const FCollisionShape columnBox = FCollisionShape::MakeBox(FVector(columnRadius, columnRadius, columnHalfHeight + (clearDistance / 2.f)));
+	if (GetWorld()->OverlapAnyTestByObjectType(columnCenter, FQuat::Identity, collisionContext.DynamicObjectParams, columnBox, collisionContext.QueryParams))
+		return;
+
+	// the fattened capsule touches at this height so the real one still has FloorColumnMargin to spare
+	FloorColumnClearBottomZ = aTopLoc.Z - clearDistance;
+}
+
+FDeftLandingPrediction UDeftCharacterMovementComponent::PredictLanding()
+{
+	const float worldTime = GetWorld()->GetTimeSeconds();
+	if (bHasLandingPrediction &&
+		worldTime - LandingPredictionBuildTime <= LandingPredictionMaxAge &&
+		FVector::DistSquared2D(Velocity, LandingPredictionVelocity) <= LandingPredictionVelocityTolerance * LandingPredictionVelocityTolerance)
+	{
+		LandingPrediction.TimeToLand = FMath::Max(LandingPredictionLandTime - worldTime, 0.f);
+		return LandingPrediction;
+	}
+
+	const bool isDeftJumping = MovementMode == MOVE_Custom && CustomMovementMode == CMOVE_DeftJump && bIsJumping;
+	const bool isDeftFalling = MovementMode == MOVE_Custom && CustomMovementMode == CMOVE_DeftFall && bIsFalling;
+	if (!CharacterOwner || bIsInImpulse || !(isDeftJumping || isDeftFalling))
+		return FDeftLandingPrediction();
+
+	/*
+		Rather than stepping the simulation forward: one long sweep finds the floor below us, the curve is inverted to find when we've dropped that far,
+		and we drift sideways at our current velocity in the meantime. If that drift carries us off the floor we found, one more sweep under where we'd end up fixes it.
+		Each step of a jump adds SlideJumpAdditive on top of velocity so the step length matters for that part
+	*/
+	const float fixedStepTime = GetFixedStepTime();
+	const float stepTime = fixedStepTime > 0.f ? fixedStepTime : GetWorld()->GetDeltaSeconds();
+	const FVector horizontalVelocity = FVector(Velocity.X, Velocity.Y, 0.f);
+	const FVector slideJumpVelocity = stepTime > 0.f ? FVector(SlideJumpAdditive.X, SlideJumpAdditive.Y, 0.f) / stepTime : FVector::ZeroVector;
+
+	const FVector startLocation = UpdatedComponent->GetComponentLocation();
+	auto predictFrom = [this, &startLocation, &horizontalVelocity, &slideJumpVelocity](const FVector& aSweepLoc, FVector& outLocation, float& outTimeToLand)
+	{
+		float floorZ, jumpTimeLeft;
+		if (!SweepForLandingFloor(aSweepLoc, floorZ) || !FindTimeToDrop(startLocation.Z - floorZ, outTimeToLand, jumpTimeLeft))
+			return false;
+
+		const FVector travel = (horizontalVelocity * outTimeToLand) + (slideJumpVelocity * FMath::Min(jumpTimeLeft, outTimeToLand));
+		outLocation = FVector(startLocation.X + travel.X, startLocation.Y + travel.Y, floorZ);
+		return true;
+	};
+
+	FDeftLandingPrediction prediction;
+	prediction.bWillLand = predictFrom(startLocation, prediction.Location, prediction.TimeToLand);
+
+	const float capsuleRadius = GetCollisionContext().CapsuleShape.GetCapsuleRadius();
+	if (prediction.bWillLand && FVector::DistSquared2D(startLocation, prediction.Location) > capsuleRadius * capsuleRadius)
+		prediction.bWillLand = predictFrom(FVector(prediction.Location.X, prediction.Location.Y, startLocation.Z), prediction.Location, prediction.TimeToLand);
+
+	if (!prediction.bWillLand)
+		prediction = FDeftLandingPrediction();
+
+	LandingPrediction = prediction;
+	LandingPredictionVelocity = horizontalVelocity;
+	LandingPredictionLandTime = worldTime + prediction.TimeToLand;
+	LandingPredictionBuildTime = worldTime;
+	bHasLandingPrediction = true;
+
+	return prediction;
+}
+
+bool UDeftCharacterMovementComponent::FindTimeToDrop(float aDropHeight, float& outTimeToDrop, float& outJumpTimeLeft) const
+{
+	outJumpTimeLeft = 0.f;
+
+	// Curve values are heights relative to wherever the jump/fall started, so we want the time the curve gets aDropHeight below where it is now
+	if (bIsFalling)
+	{
+		float landTime;
+		if (!FallCurveToUse.IsValid() || !FallCurveToUse->FindDescendingTime(PrevFallCurveVal - aDropHeight, FallTime, landTime))
+			return false;
+
+		outTimeToDrop = landTime - FallTime;
+		return true;
+	}
+
+	if (!JumpCurveBaked.IsValid())
+		return false;
+
+	// Still going up means we have to come back down past where we are first, the jump curve only descends after the apex
+	const float targetJumpVal = PrevJumpCurveVal - aDropHeight;
+	float landTime;
+	if (JumpCurveBaked->FindDescendingTime(targetJumpVal, FMath::Max(JumpTime, JumpApexTime), landTime))
+	{
+		outTimeToDrop = landTime - JumpTime;
+		outJumpTimeLeft = outTimeToDrop;
+		return true;
+	}
+
+	// Floor is below where the jump curve ends, the rest is on the fall curve SetCustomFallingMode will pick once the jump ends
+	outJumpTimeLeft = FMath::Max(JumpCurveMaxTime - JumpTime, 0.f);
+	const float dropLeft = JumpCurveBaked->Eval(JumpCurveMaxTime) - targetJumpVal;
+	const TSharedPtr<const FDeftBakedCurve>& fallCurve = JumpCurveMaxTime > JumpApexTime ? JumpFallCurveBaked : NonJumpFallCurveBaked;
+	if (!fallCurve.IsValid() || !fallCurve->FindDescendingTime(-dropLeft, 0.f, landTime))
+		return false;
+
+	outTimeToDrop = outJumpTimeLeft + landTime;
+	return true;
+}
+
+bool UDeftCharacterMovementComponent::SweepForLandingFloor(const FVector& aStartLoc, float& outFloorZ) const
+{
+	const FDeftCollisionContext& collisionContext = GetCollisionContext();
+
+	FHitResult floorHit;
+	if (!GetWorld()->SweepSingleByProfile(floorHit, aStartLoc, aStartLoc - FVector(0.f, 0.f, LandingPredictionSweepLength), collisionContext.GetCapsuleRotation(), collisionContext.CapsuleProfileName, collisionContext.CapsuleShape, collisionContext.QueryParams))
+		return false;
+
+	if (floorHit.bStartPenetrating || !IsWalkable(floorHit))
+		return false;
+
+	// where the capsule center ends up once it's touching the floor
+	outFloorZ = floorHit.Location.Z;
+	return true;
+}
+
 bool UDeftCharacterMovementComponent::FindJumpApexTime(float& outApexTime)
 {
 	/*
@@ -653,11 +1203,11 @@ bool UDeftCharacterMovementComponent::FindJumpApexTime(float& outApexTime)
 	const FVector constTimeXAxis = FVector(1.f, 0.f, 0.f);
 
 	float jumpMin, jumpApexHeight;
-	JumpCurve->GetValueRange(jumpMin, jumpApexHeight);
+	JumpCurveBaked->GetValueRange(jumpMin, jumpApexHeight);
 
 	// Range of where we perform the graph  walking
 	float startTime, endTime;
-	JumpCurve->GetTimeRange(startTime, endTime);
+	JumpCurveBaked->GetTimeRange(startTime, endTime);
 
 	// how many times to find the estimated apex 
 	// each iteration halves the step size so the more iterations the more accurate but more computationally costly
@@ -686,22 +1236,27 @@ bool UDeftCharacterMovementComponent::FindJumpApexTime(float& outApexTime)
 		// step through the range defined by startTime and endTime looking for where slope changes from pos to neg
 		while (!isApexFound)
 		{
+			// all three heights in one go, the 4th lane is just padding
+			const float times[4] = { t1, t2, t3, t3 };
+			float heights[4];
+			JumpCurveBaked->EvalBatch(times, heights, 4);
+
 			// early out apex checks in case any of the time steps are exactly our apex
-			float h1 = JumpCurve->GetFloatValue(t1);
+			float h1 = heights[0];
 			if (h1 == jumpApexHeight)
 			{
 				outApexTime = t1;
 				return true;
 			}
 
-			float h2 = JumpCurve->GetFloatValue(t2);
+			float h2 = heights[1];
 			if (h2 == jumpApexHeight)
 			{
 				outApexTime = t2;
 				return true;
 			}
 
-			float h3 = JumpCurve->GetFloatValue(t3);
+			float h3 = heights[2];
 			if (h3 == jumpApexHeight)
 			{
 				outApexTime = t3;
@@ -749,9 +1304,31 @@ bool UDeftCharacterMovementComponent::FindJumpApexTime(float& outApexTime)
 }
 
 #if !UE_BUILD_SHIPPING
-bool UDeftCharacterMovementComponent::IsJumpCurveEnabled() const
+void UDeftCharacterMovementComponent::RefreshMovementPolicies()
 {
-	return CVar_FeatureJumpCurve.GetValueOnGameThread() > 0;
+	if (CVar_FeatureJumpCurve.GetValueOnGameThread() > 0)
+	{
+		DoJumpPath = &UDeftCharacterMovementComponent::DoJumpWithPolicy<FCurveJumpPolicy>;
+		IsFallingPath = &UDeftCharacterMovementComponent::IsFallingWithPolicy<FCurveJumpPolicy>;
+		ProcessEngineFallingPath = &UDeftCharacterMovementComponent::ProcessEngineFallingWithPolicy<FCurveJumpPolicy>;
+	}
+	else
+	{
+		DoJumpPath = &UDeftCharacterMovementComponent::DoJumpWithPolicy<FEngineJumpPolicy>;
+		IsFallingPath = &UDeftCharacterMovementComponent::IsFallingWithPolicy<FEngineJumpPolicy>;
+		ProcessEngineFallingPath = &UDeftCharacterMovementComponent::ProcessEngineFallingWithPolicy<FEngineJumpPolicy>;
+	}
+
+	if (CVar_Feature_SlideMode.GetValueOnGameThread() == 0)
+	{
+		DoSlidePath = &UDeftCharacterMovementComponent::DoSlideWithPolicy<FVelocitySlidePolicy>;
+		PhysDeftSlidePath = &UDeftCharacterMovementComponent::PhysDeftSlideWithPolicy<FVelocitySlidePolicy>;
+	}
+	else
+	{
+		DoSlidePath = &UDeftCharacterMovementComponent::DoSlideWithPolicy<FConstantSlidePolicy>;
+		PhysDeftSlidePath = &UDeftCharacterMovementComponent::PhysDeftSlideWithPolicy<FConstantSlidePolicy>;
+	}
 }
 
 void UDeftCharacterMovementComponent::DrawDebug()
@@ -781,8 +1358,108 @@ void UDeftCharacterMovementComponent::DrawDebugSlide()
 
 void UDeftCharacterMovementComponent::DrawDebugFall()
 {
+	if (bHasFloorColumn && FloorColumnClearBottomZ < FloorColumnTop.Z)
+		DrawDebugLine(GetWorld(), FloorColumnTop, FVector(FloorColumnTop.X, FloorColumnTop.Y, FloorColumnClearBottomZ), FColor::Green);
+
 	GEngine->AddOnScreenDebugMessage(-1, 0.005, bIsFalling ? FColor::Green : FColor::White, FString::Printf(TEXT("\tFalling duration: %.2f"), FallTime));
 	GEngine->AddOnScreenDebugMessage(-1, 0.005, FColor::White, TEXT("\n-Fall-"));
 }
 
+void UDeftCharacterMovementComponent::Debug_ReplayJump(float aFrameRate, float aDuration, const FVector& aInputDirection, float aSampleInterval, TArray<FVector>& outSamples)
+{
+	outSamples.Reset();
+	if (!CharacterOwner || aFrameRate <= 0.f || aSampleInterval <= 0.f)
+		return;
+
+	const FVector startLocation = UpdatedComponent->GetComponentLocation();
+	const FQuat startRotation = UpdatedComponent->GetComponentQuat();
+
+	auto resetToStart = [this, &startLocation, &startRotation]()
+	{
+		UpdatedComponent->SetWorldLocationAndRotation(startLocation, startRotation, false, nullptr, ETeleportType::TeleportPhysics);
+		Velocity = FVector::ZeroVector;
+		bIsJumping = false;
+		bIsFalling = false;
+		SetMovementMode(MOVE_Walking);
+	};
+
+	resetToStart();
+	if (!DoJump(false))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Replay couldn't jump, make sure we're standing somewhere we can jump from"));
+		return;
+	}
+
+	const float deltaTime = 1.f / aFrameRate;
+	float time = 0.f;
+	float nextSampleTime = 0.f;
+	FVector prevLocation = startLocation;
+
+	while (time < aDuration)
+	{
+		CharacterOwner->AddMovementInput(aInputDirection);
+		TickComponent(deltaTime, LEVELTICK_All, &PrimaryComponentTick);
+
+		// Frames never line up between rates, sample at shared times by lerping between frames
+		const FVector location = UpdatedComponent->GetComponentLocation();
+		while (nextSampleTime <= time + deltaTime)
+		{
+			outSamples.Add(FMath::Lerp(prevLocation, location, (nextSampleTime - time) / deltaTime));
+			nextSampleTime += aSampleInterval;
+		}
+
+		prevLocation = location;
+		time += deltaTime;
+	}
+
+	resetToStart();
+}
+
+// Replays the same jump at several frame rates, with and without fixed stepping, and logs how far each strays from the highest rate
+static FAutoConsoleCommandWithWorldAndArgs CCmd_FixedStepDivergence(
+	TEXT("deft.debug.fixedStepDivergence"),
+	TEXT("Replay a forward jump at 30/60/144/240Hz and report the trajectory divergence. Optional arg: seconds to simulate"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& aArgs, UWorld* aWorld)
+	{
+		APlayerController* playerController = aWorld ? aWorld->GetFirstPlayerController() : nullptr;
+		ACharacter* character = playerController ? playerController->GetCharacter() : nullptr;
+		UDeftCharacterMovementComponent* movementComponent = character ? Cast<UDeftCharacterMovementComponent>(character->GetCharacterMovement()) : nullptr;
+		if (!movementComponent)
+		{
+			UE_LOG(LogTemp, Error, TEXT("No Deft character to replay with"));
+			return;
+		}
+
+		const float duration = aArgs.Num() > 0 ? FMath::Max(FCString::Atof(*aArgs[0]), 0.1f) : 1.5f;
+		const float sampleInterval = 1.f / 30.f;
+		const float frameRates[] = { 240.f, 144.f, 60.f, 30.f }; // first is the reference
+		const FVector inputDirection = character->GetActorForwardVector();
+
+		IConsoleVariable* fixedStepHz = CVar_Feature_FixedStepHz.AsVariable();
+		const float originalFixedStepHz = fixedStepHz->GetFloat();
+		const float fixedStepRates[] = { 0.f, originalFixedStepHz > 0.f ? originalFixedStepHz : 120.f };
+
+		for (const float fixedStepRate : fixedStepRates)
+		{
+			fixedStepHz->Set(fixedStepRate, ECVF_SetByCode);
+
+			TArray<FVector> reference;
+			movementComponent->Debug_ReplayJump(frameRates[0], duration, inputDirection, sampleInterval, reference);
+
+			for (int i = 1; i < UE_ARRAY_COUNT(frameRates); ++i)
+			{
+				TArray<FVector> samples;
+				movementComponent->Debug_ReplayJump(frameRates[i], duration, inputDirection, sampleInterval, samples);
+
+				float maxDivergence = 0.f;
+				for (int j = 0, end = FMath::Min(reference.Num(), samples.Num()); j < end; ++j)
+					maxDivergence = FMath::Max(maxDivergence, FVector::Dist(reference[j], samples[j]));
+
+				UE_LOG(LogTemp, Display, TEXT("fixed step %.0fHz: %.0fHz strays up to %.2f units from %.0fHz"), fixedStepRate, frameRates[i], maxDivergence, frameRates[0]);
+			}
+		}
+
+		fixedStepHz->Set(originalFixedStepHz, ECVF_SetByCode);
+	}));
+
 #endif//UE_BUILD_SHIPPING
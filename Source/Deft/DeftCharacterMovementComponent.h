@@ -7,6 +7,41 @@
 DECLARE_MULTICAST_DELEGATE(FLandedFromAirDelegate);
 DECLARE_MULTICAST_DELEGATE_OneParam(FSlideActionOccurredDelegate, bool /*aIsSlidingActive*/);
 
+// Sub-modes of MOVE_Custom, simulated in UDeftCharacterMovementComponent::PhysCustom
+UENUM(BlueprintType)
+enum EDeftMovementMode
+{
+	CMOVE_None			UMETA(Hidden),
+	CMOVE_DeftJump		UMETA(DisplayName = "Deft Jump"),
+	CMOVE_DeftFall		UMETA(DisplayName = "Deft Fall"),
+	CMOVE_DeftSlide		UMETA(DisplayName = "Deft Slide"),
+	CMOVE_MAX			UMETA(Hidden),
+};
+
+// Where and when the current Deft jump/fall is expected to touch down (see UDeftCharacterMovementComponent::PredictLanding)
+USTRUCT(BlueprintType)
+struct FDeftLandingPrediction
+{
+	GENERATED_BODY()
+
+	FDeftLandingPrediction()
+		: Location(FVector::ZeroVector)
+		, TimeToLand(0.f)
+		, bWillLand(false)
+	{}
+
+	// Capsule center once we're standing on the floor
+	UPROPERTY(BlueprintReadOnly, Category = "Deft Movement")
+	FVector Location;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Deft Movement")
+	float TimeToLand;
+
+	// false when we aren't in a Deft jump/fall or there's no floor in reach below us
+	UPROPERTY(BlueprintReadOnly, Category = "Deft Movement")
+	bool bWillLand;
+};
+
 /**
  * 
  */
@@ -23,10 +58,27 @@ public:
 
 	void DoImpulse(const FVector& impulseDir);
 
+	// Hands a root motion source (ledge up, grapple pull...) control of the character until it finishes or is stopped
+	uint16 ApplyForcedMovement(TSharedPtr<FRootMotionSource> aForcedMovementSource);
+	void StopForcedMovement(uint16 aForcedMovementID);
+	bool IsForcedMovementActive(uint16 aForcedMovementID);
+
 	bool IsDeftJumping() const { return bIsJumping; }
 	bool IsDeftFalling() const { return bIsFalling; }
 	bool IsDeftSliding() const { return bIsSliding; }
 
+	// Solved from the curves instead of simulated forward and cached until the jump/fall changes, cheap enough to call every frame from anywhere
+	UFUNCTION(BlueprintCallable, Category = "Deft Movement")
+	FDeftLandingPrediction PredictLanding();
+
+#if !UE_BUILD_SHIPPING
+	// Picks the jump/slide paths from the deft.feature cvars, only needs calling when they change
+	void RefreshMovementPolicies();
+
+	// Jumps from where we stand holding aInputDirection at a fixed frame rate, samples where we are every aSampleInterval, then puts us back
+	void Debug_ReplayJump(float aFrameRate, float aDuration, const FVector& aInputDirection, float aSampleInterval, TArray<FVector>& outSamples);
+#endif //!UE_BUILD_SHIPPING
+
 protected:
 	void BeginPlay() override;
 	void TickComponent(float aDeltaTime, enum ELevelTick aTickType, FActorComponentTickFunction* aThisTickFunction) override;
@@ -34,17 +86,24 @@ protected:
 	// Override Reason: Custom jump logic using curves and not gravity x velocity
 	bool DoJump(bool bReplayingMoves) override;
 
-	// Override Reason: default engine IsFalling() for animation reasons since we logically are in MOVE_Flying during any Jump or Fall however animations may need to know if we're falling
+	// Override Reason: Deft jump, fall and slide are MOVE_Custom sub-modes which the base class knows nothing about
+	void PhysCustom(float aDeltaTime, int32 aIterations) override;
+
+	// Override Reason: default engine IsFalling() for animation reasons since we logically are in MOVE_Custom during any Jump or Fall however animations may need to know if we're falling
 	bool IsFalling() const override;
 
+	// Override Reason: Air control during Deft jump/fall keeps the same tuning it had back when those ran in MOVE_Flying
+	float GetMaxSpeed() const override;
+	float GetMaxBrakingDeceleration() const override;
+
 	// Override Reason: We want to allow jumping while sliding
 	bool CanAttemptJump() const override;
 
-	// Override reason: Slide puts us in MOVE_Flying which is excluded from crouch allowance, so we need to check if we're sliding
+	// Override reason: Slide puts us in MOVE_Custom which is excluded from crouch allowance, so we need to check if we're sliding
 	bool CanCrouchInCurrentState() const override;
 
-	// Override reason: Forcing crouch to maintain base location while in MOVE_Flying since that's our custom slide and we want the capsule to stay at ground level
-	// otherwise base UE implementation sets bCrouchMaintainsBaseLocation = false whenever we're MOVE_Flying
+	// Override reason: Forcing crouch to maintain base location while in MOVE_Custom since that's our custom slide and we want the capsule to stay at ground level
+	// otherwise base UE implementation sets bCrouchMaintainsBaseLocation = false whenever we're not MOVE_Walking
 	void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
 	
 	// Override reason: This will trigger during jumping/falling with horizontal collision and cause a bug
@@ -66,22 +125,60 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Deft Movement", meta=(DisplayName="Slide Curve"))
 	UCurveFloat* SlideCurve;
 
+	// Preferred over the individual curves above, its curve analysis is done ahead of time instead of on every spawn
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Deft Movement", meta=(DisplayName="Curve Set"))
+	class UDeftMovementCurveSet* CurveSet;
+
 private:
-	void ProcessJumping(float aDeltaTime);
-	void ProcessFalling(float aDeltaTime);
-	void ProcessSliding(float aDeltaTime);
+	// Baked lookup tables of the curves above, these are what actually get evaluated
+	TSharedPtr<const struct FDeftBakedCurve> JumpCurveBaked;
+	TSharedPtr<const struct FDeftBakedCurve> JumpFallCurveBaked;
+	TSharedPtr<const struct FDeftBakedCurve> NonJumpFallCurveBaked;
+	TSharedPtr<const struct FDeftBakedCurve> SlideCurveBaked;
+
+	// Single substep of each Deft movement mode, driven by PhysCustom
+	void PhysDeftMode(float aDeltaTime);
+	void PhysDeftJump(float aDeltaTime);
+	void PhysDeftFall(float aDeltaTime);
+	void PhysDeftSlide(float aDeltaTime);
+
+	void ProcessEngineFalling();
 	void ProcessImpulseFallDelay(float aDeltaTime);
+	void ProcessForcedMovement();
+
+	// Fixed step simulation (see deft.feature.fixedStepHz)
+	float GetFixedStepTime() const;
+	void PhysCustomFixedStep(float aDeltaTime, int32 aIterations, float aFixedStepTime);
+	void UpdateFixedStepRenderOffset();
+
+	const struct FDeftCollisionContext& GetCollisionContext() const;
+	void CalcAirControlVelocity(float aDeltaTime);
+	// Swept move split into collision safe segments when it's long, returns true if we bumped into a roof on the way up (and stopped there)
+	bool MoveDeft(const FVector& aDelta, float aDeltaTime);
 
 	void StopSlide();
 
+	// Jump and slide written once per policy (see the policies at the top of the .cpp) so the choice is made up front instead of every tick
+	template<class TJumpPolicy> bool DoJumpWithPolicy(bool bReplayingMoves);
+	template<class TJumpPolicy> bool IsFallingWithPolicy() const;
+	template<class TJumpPolicy> void ProcessEngineFallingWithPolicy();
+	template<class TSlidePolicy> void DoSlideWithPolicy();
+	template<class TSlidePolicy> void PhysDeftSlideWithPolicy(float aDeltaTime);
+
 	void SetCustomFallingMode();
 	bool FindFloorBySweep(FFindFloorResult& outFloorResult, const FVector aStartLoc, const FVector aEndLWoc);
+	bool IsInsideClearFloorColumn(const FVector& aStartLoc, const FVector& aEndLoc);
+	void BuildFloorColumn(const FVector& aTopLoc);
 	bool FindJumpApexTime(float& outApexTime);
 
+	// How long until we've dropped aDropHeight below where we are now, following the rest of the jump/fall curves
+	bool FindTimeToDrop(float aDropHeight, float& outTimeToDrop, float& outJumpTimeLeft) const;
+	bool SweepForLandingFloor(const FVector& aStartLoc, float& outFloorZ) const;
+
 	FVector SlideDirection;
 	FVector SlideJumpAdditive;
 
-	UCurveFloat* FallCurveToUse;
+	TSharedPtr<const struct FDeftBakedCurve> FallCurveToUse;
 
 	// Jumping
 	float JumpTime;
@@ -107,6 +204,40 @@ private:
 	float SlideJumpSpeedMod;			// Jump Speed modifier based off slide speed to give the player a longer jump during slide
 	float SlideJumpSpeedModMax;
 
+	// Forced Movement
+	uint16 ForcedMovementRootMotionID;
+
+	// Fixed Step
+	FVector FixedStepPrevLocation;		// where the previous fixed step left us, rendering interpolates from here
+	float FixedStepAccumulator;			// frame time that hasn't been simulated yet
+	float FixedStepBacklogMax;			// most frame time the accumulator carries, only a hitch longer than this loses time
+	bool bHasFixedStepPrevLocation;
+	bool bHasFixedStepRenderOffset;
+
+	// Moving
+	float MoveSubstepRadiusFraction;	// moves longer than this fraction of the capsule radius get split up
+	int MoveSubstepsMax;
+	float RoofNormalZMin;				// how much a surface has to face downwards for hitting it on the way up to count as a roof
+
+	// Floor Column: space under us known to be clear of floors while airborne (see BuildFloorColumn)
+	FVector FloorColumnTop;
+	float FloorColumnClearBottomZ;		// capsule can fall as far as this without touching anything
+	float FloorColumnBuildTime;
+	float FloorColumnLength;
+	float FloorColumnMargin;			// how far we can drift sideways and still be inside the column
+	float FloorColumnMaxAge;			// dynamic objects can wander in after the fact, don't trust the column forever
+	bool bHasFloorColumn;
+
+	// Landing Prediction: reused until the jump/fall changes or we steer away from it
+	FDeftLandingPrediction LandingPrediction;
+	FVector LandingPredictionVelocity;
+	float LandingPredictionLandTime;		// world time we expect to touch down, TimeToLand counts down towards it
+	float LandingPredictionBuildTime;
+	float LandingPredictionSweepLength;
+	float LandingPredictionVelocityTolerance;
+	float LandingPredictionMaxAge;			// walls we slide along don't change our velocity, so don't trust a prediction forever
+	bool bHasLandingPrediction;
+
 	// TODO: I dont' remember what this is for xD
 	// Impulse
 	float ImpulseFallDelay;
@@ -121,7 +252,12 @@ private:
 
 private:
 #if !UE_BUILD_SHIPPING
-	bool IsJumpCurveEnabled() const;
+	// Whichever policy the cvars picked last (shipping calls the one it was built with directly)
+	bool (UDeftCharacterMovementComponent::*DoJumpPath)(bool);
+	bool (UDeftCharacterMovementComponent::*IsFallingPath)() const;
+	void (UDeftCharacterMovementComponent::*ProcessEngineFallingPath)();
+	void (UDeftCharacterMovementComponent::*DoSlidePath)();
+	void (UDeftCharacterMovementComponent::*PhysDeftSlidePath)(float);
 
 	void DrawDebug();
 	void DrawDebugJump();
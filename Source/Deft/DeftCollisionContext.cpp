@@ -0,0 +1,30 @@
+#include "DeftCollisionContext.h"
+
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/Character.h"
+
+FDeftCollisionContext::FDeftCollisionContext()
+	: CapsuleShape()
+	, CapsuleProfileName(NAME_None)
+	, QueryParams(SCENE_QUERY_STAT(DeftCharacter), false)
+	, DynamicObjectParams()
+{
+	DynamicObjectParams.AddObjectTypesToQuery(ECC_WorldDynamic);
+	DynamicObjectParams.AddObjectTypesToQuery(ECC_Pawn);
+	DynamicObjectParams.AddObjectTypesToQuery(ECC_PhysicsBody);
+	DynamicObjectParams.AddObjectTypesToQuery(ECC_Vehicle);
+	DynamicObjectParams.AddObjectTypesToQuery(ECC_Destructible);
+}
+
+void FDeftCollisionContext::Refresh(const ACharacter& aCharacter)
+{
+	const UCapsuleComponent* capsulComponent = aCharacter.GetCapsuleComponent();
+	if (!capsulComponent)
+		return;
+
+	CapsuleShape = FCollisionShape::MakeCapsule(capsulComponent->GetScaledCapsuleRadius(), capsulComponent->GetScaledCapsuleHalfHeight());
+	CapsuleProfileName = capsulComponent->GetCollisionProfileName();
+
+	QueryParams.ClearIgnoredActors();
+	QueryParams.AddIgnoredActor(&aCharacter);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CollisionQueryParams.h"
+#include "CollisionShape.h"
+
+/**
+ * Everything a scene query against the character's capsule needs, built once and shared by the movement, climb and grapple components.
+ * Only the capsule size ever changes (crouching) so the owner refreshes it then and nowhere else
+ */
+struct DEFT_API FDeftCollisionContext
+{
+	FDeftCollisionContext();
+
+	void Refresh(const class ACharacter& aCharacter);
+
+	// The capsule is symmetric around its up axis and never pitches or rolls, so sweeping it unrotated is the same as sweeping it with the actor's rotation
+	static const FQuat& GetCapsuleRotation() { return FQuat::Identity; }
+
+	FCollisionShape CapsuleShape;
+	FName CapsuleProfileName;
+	FCollisionQueryParams QueryParams;		// ignores the character (and therefore all of its components)
+	FCollisionObjectQueryParams DynamicObjectParams;	// everything that can move after we've checked it's not in the way
+};
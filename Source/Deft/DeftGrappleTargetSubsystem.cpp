@@ -0,0 +1,314 @@
+#include "DeftGrappleTargetSubsystem.h"
+
+#include "Components/SceneComponent.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+
+const FName UDeftGrappleTargetSubsystem::PullableTag(TEXT("Pullable"));
+const FName UDeftGrappleTargetSubsystem::GrappleTargetTag(TEXT("GrappleTarget"));
+
+UDeftGrappleTargetSubsystem::UDeftGrappleTargetSubsystem()
+	: SlotComponents()
+	, SlotLocationsX()
+	, SlotLocationsY()
+	, SlotLocationsZ()
+	, SlotCells()
+	, FreeSlots()
+	, ComponentToSlot()
+	, Cells()
+	, CellSize(500.f)
+	, ActorSpawnedHandle()
+	, LevelAddedHandle()
+{
+}
+
+void UDeftGrappleTargetSubsystem::Initialize(FSubsystemCollectionBase& aCollection)
+{
+	Super::Initialize(aCollection);
+
+	ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UDeftGrappleTargetSubsystem::OnActorSpawned));
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UDeftGrappleTargetSubsystem::OnLevelAddedToWorld);
+}
+
+void UDeftGrappleTargetSubsystem::Deinitialize()
+{
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+
+	for (const TWeakObjectPtr<USceneComponent>& component : SlotComponents)
+	{
+		if (component.IsValid())
+			component->TransformUpdated.RemoveAll(this);
+	}
+
+	Super::Deinitialize();
+}
+
+void UDeftGrappleTargetSubsystem::OnWorldBeginPlay(UWorld& aWorld)
+{
+	Super::OnWorldBeginPlay(aWorld);
+
+	// Everything placed in the level, from here on OnActorSpawned/OnLevelAddedToWorld keep us up to date
+	for (TActorIterator<AActor> it(&aWorld); it; ++it)
+		RegisterActorTargets(*it);
+}
+
+bool UDeftGrappleTargetSubsystem::DoesSupportWorldType(const EWorldType::Type aWorldType) const
+{
+	return aWorldType == EWorldType::Game || aWorldType == EWorldType::PIE;
+}
+
+void UDeftGrappleTargetSubsystem::RegisterTarget(USceneComponent* aComponent)
+{
+	if (!aComponent || ComponentToSlot.Contains(FObjectKey(aComponent)))
+		return;
+
+	int32 slot;
+	if (FreeSlots.Num() > 0)
+	{
+		slot = FreeSlots.Pop(false);
+		SlotComponents[slot] = aComponent;
+	}
+	else
+	{
+		slot = SlotComponents.Add(aComponent);
+		SlotLocationsX.AddUninitialized();
+		SlotLocationsY.AddUninitialized();
+		SlotLocationsZ.AddUninitialized();
+		SlotCells.AddUninitialized();
+	}
+
+	ComponentToSlot.Add(FObjectKey(aComponent), slot);
+
+	const FVector location = aComponent->GetComponentLocation();
+	SlotLocationsX[slot] = location.X;
+	SlotLocationsY[slot] = location.Y;
+	SlotLocationsZ[slot] = location.Z;
+	SlotCells[slot] = GetCell(location);
+	Cells.FindOrAdd(SlotCells[slot]).Add(slot);
+
+	// Static anchors never move, only pay for following the ones that can
+	if (aComponent->Mobility == EComponentMobility::Movable)
+		aComponent->TransformUpdated.AddUObject(this, &UDeftGrappleTargetSubsystem::OnTargetTransformUpdated);
+}
+
+void UDeftGrappleTargetSubsystem::UnregisterTarget(USceneComponent* aComponent)
+{
+	int32 slot;
+	if (!aComponent || !ComponentToSlot.RemoveAndCopyValue(FObjectKey(aComponent), slot))
+		return;
+
+	aComponent->TransformUpdated.RemoveAll(this);
+
+	if (TArray<int32>* cellSlots = Cells.Find(SlotCells[slot]))
+	{
+		cellSlots->RemoveSingleSwap(slot, false);
+		if (cellSlots->Num() == 0)
+			Cells.Remove(SlotCells[slot]);
+	}
+
+	SlotComponents[slot] = nullptr;
+	FreeSlots.Add(slot);
+}
+
+int32 UDeftGrappleTargetSubsystem::QueryCone(const FVector& aOrigin, const FVector& aDirection, float aMaxDistance, float aConeHalfAngle, TArray<FDeftGrappleTarget>& outTargets, int32 aMaxResults) const
+{
+	outTargets.Reset();
+
+	const FVector direction = aDirection.GetSafeNormal();
+	if (direction.IsZero() || aMaxDistance <= 0.f || aMaxResults <= 0)
+		return 0;
+
+	// Everything in the cone is at most aMaxDistance along it and aMaxDistance * sin(angle) off to the side of it
+	const float coneHalfAngle = FMath::Clamp(aConeHalfAngle, 0.f, 89.f);
+	const float coneRadius = aMaxDistance * FMath::Sin(FMath::DegreesToRadians(coneHalfAngle));
+	FBox coneBounds(aOrigin, aOrigin);
+	coneBounds += aOrigin + (direction * aMaxDistance);
+	coneBounds = coneBounds.ExpandBy(coneRadius);
+
+	const FIntVector minCell = GetCell(coneBounds.Min);
+	const FIntVector maxCell = GetCell(coneBounds.Max);
+	const int64 numConeCells = (int64)(maxCell.X - minCell.X + 1) * (maxCell.Y - minCell.Y + 1) * (maxCell.Z - minCell.Z + 1);
+
+	// Fewer cells in the whole hash than the cone covers (i.e. a long reach) is cheaper to walk than looking up every cell in the cone
+	TArray<int32, TInlineAllocator<128>> candidates;
+	if (numConeCells > Cells.Num())
+	{
+		for (const TPair<FIntVector, TArray<int32>>& cell : Cells)
+		{
+			const FIntVector& cellCoord = cell.Key;
+			if (cellCoord.X >= minCell.X && cellCoord.X <= maxCell.X && cellCoord.Y >= minCell.Y && cellCoord.Y <= maxCell.Y && cellCoord.Z >= minCell.Z && cellCoord.Z <= maxCell.Z)
+				candidates.Append(cell.Value);
+		}
+	}
+	else
+	{
+		for (int32 x = minCell.X; x <= maxCell.X; ++x)
+		{
+			for (int32 y = minCell.Y; y <= maxCell.Y; ++y)
+			{
+				for (int32 z = minCell.Z; z <= maxCell.Z; ++z)
+				{
+					if (const TArray<int32>* cellSlots = Cells.Find(FIntVector(x, y, z)))
+						candidates.Append(*cellSlots);
+				}
+			}
+		}
+	}
+
+	if (candidates.Num() == 0)
+		return 0;
+
+	// Gather candidates into contiguous per-axis arrays, padded to a multiple of 4 with the origin which never scores
+	const int32 numPadded = Align(candidates.Num(), 4);
+	TArray<float, TAlignedHeapAllocator<16>> xs, ys, zs, scores;
+	xs.SetNumUninitialized(numPadded);
+	ys.SetNumUninitialized(numPadded);
+	zs.SetNumUninitialized(numPadded);
+	scores.SetNumUninitialized(numPadded);
+	for (int32 i = 0; i < numPadded; ++i)
+	{
+		const bool isPadding = i >= candidates.Num();
+		xs[i] = isPadding ? aOrigin.X : SlotLocationsX[candidates[i]];
+		ys[i] = isPadding ? aOrigin.Y : SlotLocationsY[candidates[i]];
+		zs[i] = isPadding ? aOrigin.Z : SlotLocationsZ[candidates[i]];
+	}
+
+	/*
+		For each target with d = target - origin:
+			in the cone when d.dir > 0, |d| <= maxDistance and d.dir / |d| >= cos(halfAngle)
+			score = how close to the center it is (1 center, 0 edge) * (1 at our feet .. 0.5 at max distance)
+	*/
+	const float coneCos = FMath::Cos(FMath::DegreesToRadians(coneHalfAngle));
+	const VectorRegister4Float originX = VectorSetFloat1(aOrigin.X);
+	const VectorRegister4Float originY = VectorSetFloat1(aOrigin.Y);
+	const VectorRegister4Float originZ = VectorSetFloat1(aOrigin.Z);
+	const VectorRegister4Float directionX = VectorSetFloat1(direction.X);
+	const VectorRegister4Float directionY = VectorSetFloat1(direction.Y);
+	const VectorRegister4Float directionZ = VectorSetFloat1(direction.Z);
+	const VectorRegister4Float maxDistanceSq = VectorSetFloat1(aMaxDistance * aMaxDistance);
+	const VectorRegister4Float coneCosSq = VectorSetFloat1(coneCos * coneCos);
+	const VectorRegister4Float coneCosV = VectorSetFloat1(coneCos);
+	const VectorRegister4Float invConeRange = VectorSetFloat1(coneCos < 1.f ? 1.f / (1.f - coneCos) : 0.f);
+	const VectorRegister4Float distanceFalloff = VectorSetFloat1(-0.5f / aMaxDistance);
+	const VectorRegister4Float notInCone = VectorSetFloat1(-1.f);
+
+	for (int32 i = 0; i < numPadded; i += 4)
+	{
+		const VectorRegister4Float dx = VectorSubtract(VectorLoadAligned(&xs[i]), originX);
+		const VectorRegister4Float dy = VectorSubtract(VectorLoadAligned(&ys[i]), originY);
+		const VectorRegister4Float dz = VectorSubtract(VectorLoadAligned(&zs[i]), originZ);
+
+		const VectorRegister4Float distanceSq = VectorMultiplyAdd(dz, dz, VectorMultiplyAdd(dy, dy, VectorMultiply(dx, dx)));
+		const VectorRegister4Float along = VectorMultiplyAdd(dz, directionZ, VectorMultiplyAdd(dy, directionY, VectorMultiply(dx, directionX)));
+
+		// along^2 >= cos^2 * |d|^2 is the angle test without a square root, along > 0 keeps it to the front half
+		const VectorRegister4Float inCone = VectorBitwiseAnd(
+			VectorBitwiseAnd(VectorCompareGT(along, VectorZeroFloat()), VectorCompareGE(maxDistanceSq, distanceSq)),
+			VectorCompareGE(VectorMultiply(along, along), VectorMultiply(coneCosSq, distanceSq)));
+
+		const VectorRegister4Float invDistance = VectorReciprocalSqrt(distanceSq);
+		const VectorRegister4Float distance = VectorMultiply(distanceSq, invDistance);
+		const VectorRegister4Float centered = VectorMultiply(VectorSubtract(VectorMultiply(along, invDistance), coneCosV), invConeRange);
+		const VectorRegister4Float closeness = VectorMultiplyAdd(distance, distanceFalloff, VectorOneFloat());
+		const VectorRegister4Float score = VectorMin(VectorMultiply(centered, closeness), VectorOneFloat());
+
+		VectorStoreAligned(VectorSelect(inCone, score, notInCone), &scores[i]);
+	}
+
+	for (int32 i = 0; i < candidates.Num(); ++i)
+	{
+		if (scores[i] < 0.f)
+			continue;
+
+		const int32 slot = candidates[i];
+		outTargets.Add({ SlotComponents[slot], FVector(xs[i], ys[i], zs[i]), scores[i] });
+	}
+
+	outTargets.Sort([](const FDeftGrappleTarget& aTarget1, const FDeftGrappleTarget& aTarget2) { return aTarget1.Score > aTarget2.Score; });
+	if (outTargets.Num() > aMaxResults)
+		outTargets.SetNum(aMaxResults, false);
+
+	return outTargets.Num();
+}
+
+void UDeftGrappleTargetSubsystem::RegisterActorTargets(AActor* aActor)
+{
+	if (!aActor)
+		return;
+
+	bool hasTargets = false;
+	if (aActor->ActorHasTag(PullableTag) || aActor->ActorHasTag(GrappleTargetTag))
+	{
+		RegisterTarget(aActor->GetRootComponent());
+		hasTargets = aActor->GetRootComponent() != nullptr;
+	}
+
+	TInlineComponentArray<USceneComponent*> sceneComponents(aActor);
+	for (USceneComponent* sceneComponent : sceneComponents)
+	{
+		if (sceneComponent->ComponentHasTag(PullableTag) || sceneComponent->ComponentHasTag(GrappleTargetTag))
+		{
+			RegisterTarget(sceneComponent);
+			hasTargets = true;
+		}
+	}
+
+	if (hasTargets)
+		aActor->OnEndPlay.AddUniqueDynamic(this, &UDeftGrappleTargetSubsystem::OnTargetActorEndPlay);
+}
+
+void UDeftGrappleTargetSubsystem::OnActorSpawned(AActor* aActor)
+{
+	RegisterActorTargets(aActor);
+}
+
+void UDeftGrappleTargetSubsystem::OnLevelAddedToWorld(ULevel* aLevel, UWorld* aWorld)
+{
+	if (!aLevel || aWorld != GetWorld())
+		return;
+
+	for (AActor* actor : aLevel->Actors)
+		RegisterActorTargets(actor);
+}
+
+void UDeftGrappleTargetSubsystem::OnTargetActorEndPlay(AActor* aActor, EEndPlayReason::Type aEndPlayReason)
+{
+	TInlineComponentArray<USceneComponent*> sceneComponents(aActor);
+	for (USceneComponent* sceneComponent : sceneComponents)
+		UnregisterTarget(sceneComponent);
+}
+
+void UDeftGrappleTargetSubsystem::OnTargetTransformUpdated(USceneComponent* aComponent, EUpdateTransformFlags aUpdateTransformFlags, ETeleportType aTeleport)
+{
+	if (const int32* slot = ComponentToSlot.Find(FObjectKey(aComponent)))
+		SetSlotLocation(*slot, aComponent->GetComponentLocation());
+}
+
+FIntVector UDeftGrappleTargetSubsystem::GetCell(const FVector& aLocation) const
+{
+	return FIntVector(FMath::FloorToInt32(aLocation.X / CellSize), FMath::FloorToInt32(aLocation.Y / CellSize), FMath::FloorToInt32(aLocation.Z / CellSize));
+}
+
+void UDeftGrappleTargetSubsystem::SetSlotLocation(int32 aSlot, const FVector& aLocation)
+{
+	SlotLocationsX[aSlot] = aLocation.X;
+	SlotLocationsY[aSlot] = aLocation.Y;
+	SlotLocationsZ[aSlot] = aLocation.Z;
+
+	// Only moving between cells touches the hash, moving within one is just the location above
+	const FIntVector cell = GetCell(aLocation);
+	if (cell == SlotCells[aSlot])
+		return;
+
+	if (TArray<int32>* cellSlots = Cells.Find(SlotCells[aSlot]))
+	{
+		cellSlots->RemoveSingleSwap(aSlot, false);
+		if (cellSlots->Num() == 0)
+			Cells.Remove(SlotCells[aSlot]);
+	}
+
+	SlotCells[aSlot] = cell;
+	Cells.FindOrAdd(cell).Add(aSlot);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DeftGrappleTargetSubsystem.generated.h"
+
+// A grapple target found by UDeftGrappleTargetSubsystem::QueryCone
+struct FDeftGrappleTarget
+{
+	TWeakObjectPtr<class USceneComponent> Component;
+	FVector Location;
+	float Score;		// 1 is dead center of the cone right in front of us, 0 is the edge of it
+};
+
+/**
+ * Every grapplable anchor in the world (actors or components tagged Pullable/GrappleTarget) bucketed into a spatial hash as they come and go,
+ * so aim assist and target highlighting can ask what's in front of the camera without sweeping for it
+ */
+UCLASS()
+class DEFT_API UDeftGrappleTargetSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UDeftGrappleTargetSubsystem();
+
+	static const FName PullableTag;
+	static const FName GrappleTargetTag;
+
+	void Initialize(FSubsystemCollectionBase& aCollection) override;
+	void Deinitialize() override;
+	void OnWorldBeginPlay(UWorld& aWorld) override;
+
+	// Tagged actors/components register themselves, anything else that wants to be grappled can do it by hand
+	void RegisterTarget(class USceneComponent* aComponent);
+	void UnregisterTarget(class USceneComponent* aComponent);
+
+	// Targets within aMaxDistance and aConeHalfAngle degrees of aDirection, best scored first. Nothing here knows what's in the way, that's up to whoever asks
+	int32 QueryCone(const FVector& aOrigin, const FVector& aDirection, float aMaxDistance, float aConeHalfAngle, TArray<FDeftGrappleTarget>& outTargets, int32 aMaxResults = 8) const;
+
+	int32 GetNumTargets() const { return ComponentToSlot.Num(); }
+
+protected:
+	// Override Reason: Only game worlds have anything to grapple
+	bool DoesSupportWorldType(const EWorldType::Type aWorldType) const override;
+
+private:
+	void RegisterActorTargets(AActor* aActor);
+	void OnActorSpawned(AActor* aActor);
+	void OnLevelAddedToWorld(ULevel* aLevel, UWorld* aWorld);
+	UFUNCTION()
+	void OnTargetActorEndPlay(AActor* aActor, EEndPlayReason::Type aEndPlayReason);
+	void OnTargetTransformUpdated(class USceneComponent* aComponent, EUpdateTransformFlags aUpdateTransformFlags, ETeleportType aTeleport);
+
+	FIntVector GetCell(const FVector& aLocation) const;
+	void SetSlotLocation(int32 aSlot, const FVector& aLocation);
+
+	// Slots are reused once their target unregisters. Locations are split per axis so the cone query can score 4 targets at a time
+	TArray<TWeakObjectPtr<class USceneComponent>> SlotComponents;
+	TArray<float> SlotLocationsX;
+	TArray<float> SlotLocationsY;
+	TArray<float> SlotLocationsZ;
+	TArray<FIntVector> SlotCells;
+	TArray<int32> FreeSlots;
+	TMap<FObjectKey, int32> ComponentToSlot;
+
+	// Spatial hash, which slots are in each CellSize cube
+	TMap<FIntVector, TArray<int32>> Cells;
+	float CellSize;
+
+	FDelegateHandle ActorSpawnedHandle;
+	FDelegateHandle LevelAddedHandle;
+};
@@ -0,0 +1,308 @@
+#include "DeftLedgeGraph.h"
+
+#include "Components/SceneComponent.h"
+#include "Engine/World.h"
+
+namespace
+{
+	// Graphs in play, every level that has one adds it when it's loaded
+	TArray<TWeakObjectPtr<const ADeftLedgeGraph>> LoadedLedgeGraphs;
+
+	const float LedgeLipProbeOffset = 5.f;		// how far under the top we look for the face of the drop
+	const float LedgeKneeHeight = 30.f;			// anything lower than this on the top is something to step over, not something in the way
+	const float LedgeLayerGap = 100.f;			// least room between stacked floors for the lower one to be worth probing
+	const float LedgeMergeHeightTolerance = 10.f;
+	const float LedgeFacingMin = 0.5f;			// how squarely (cos) we have to be facing the ledge to climb it
+}
+
+ADeftLedgeGraph::ADeftLedgeGraph()
+	: BuildExtent(FVector(5000.f, 5000.f, 2000.f))
+	, SampleSpacing(25.f)
+	, MinDrop(50.f)
+	, WalkableFloorZ(0.71f)
+	, MaxFreeDepth(200.f)
+	, MaxClearance(300.f)
+	, MaxLayers(4)
+	, CellSize(500.f)
+	, NumSegments(0)
+	, Segments()
+	, CellStarts()
+	, CellSegments()
+	, BakedBounds(ForceInit)
+	, GridSize(FIntPoint::ZeroValue)
+	, BakedCellSize(0.f)
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+}
+
+void ADeftLedgeGraph::BeginPlay()
+{
+	Super::BeginPlay();
+
+	LoadedLedgeGraphs.Add(this);
+}
+
+void ADeftLedgeGraph::EndPlay(const EEndPlayReason::Type aEndPlayReason)
+{
+	LoadedLedgeGraphs.RemoveAllSwap([this](const TWeakObjectPtr<const ADeftLedgeGraph>& aLedgeGraph) { return !aLedgeGraph.IsValid() || aLedgeGraph.Get() == this; });
+
+	Super::EndPlay(aEndPlayReason);
+}
+
+const ADeftLedgeGraph* ADeftLedgeGraph::FindCovering(const UWorld* aWorld, const FVector& aLocation)
+{
+	for (const TWeakObjectPtr<const ADeftLedgeGraph>& ledgeGraph : LoadedLedgeGraphs)
+	{
+		if (ledgeGraph.IsValid() && ledgeGraph->GetWorld() == aWorld && ledgeGraph->Covers(aLocation))
+			return ledgeGraph.Get();
+	}
+	return nullptr;
+}
+
+bool ADeftLedgeGraph::Covers(const FVector& aLocation) const
+{
+	return BakedCellSize > 0.f && BakedBounds.IsInsideOrOn(aLocation);
+}
+
+FIntPoint ADeftLedgeGraph::GetCell(const FVector& aLocation) const
+{
+	return FIntPoint(
+		FMath::Clamp(FMath::FloorToInt32((aLocation.X - BakedBounds.Min.X) / BakedCellSize), 0, GridSize.X - 1),
+		FMath::Clamp(FMath::FloorToInt32((aLocation.Y - BakedBounds.Min.Y) / BakedCellSize), 0, GridSize.Y - 1));
+}
+
+bool ADeftLedgeGraph::FindLedge(const FDeftLedgeQuery& aQuery, FDeftLedgeHit& outHit) const
+{
+	if (!Covers(aQuery.Location))
+		return false;
+
+	const FVector forward = aQuery.Forward.GetSafeNormal2D();
+	const FVector reachExtent(aQuery.Reach, aQuery.Reach, 0.f);
+	const FIntPoint minCell = GetCell(aQuery.Location - reachExtent);
+	const FIntPoint maxCell = GetCell(aQuery.Location + reachExtent);
+
+	// Long segments sit in several cells, checking one twice just finds the same distance again
+	float bestDistSq = FMath::Square(aQuery.Reach);
+	bool bFound = false;
+	for (int32 y = minCell.Y; y <= maxCell.Y; ++y)
+	{
+		for (int32 x = minCell.X; x <= maxCell.X; ++x)
+		{
+			const int32 cell = (y * GridSize.X) + x;
+			for (int32 i = CellStarts[cell], end = CellStarts[cell + 1]; i < end; ++i)
+			{
+				const int32 segmentIndex = CellSegments[i];
+				const FDeftLedgeSegment& segment = Segments[segmentIndex];
+
+				// Cheapest rejections first, most segments near us are facing some other way
+				if ((segment.Outward | forward) > -LedgeFacingMin)
+					continue;
+				if (segment.FreeDepth < aQuery.MinDepth || segment.Clearance < aQuery.MinClearance)
+					continue;
+
+				const FVector edgePoint = FMath::ClosestPointOnSegment(aQuery.Location, segment.Start, segment.End);
+				const float height = edgePoint.Z - aQuery.Location.Z;
+				if (height < aQuery.MinHeight || height > aQuery.MaxHeight)
+					continue;
+
+				const float distSq = FVector::DistSquared2D(edgePoint, aQuery.Location);
+				if (distSq > bestDistSq)
+					continue;
+
+				bestDistSq = distSq;
+				outHit.EdgePoint = edgePoint;
+				outHit.Outward = segment.Outward;
+				outHit.TopNormal = segment.TopNormal;
+				outHit.SegmentIndex = segmentIndex;
+				bFound = true;
+			}
+		}
+	}
+	return bFound;
+}
+
+#if WITH_EDITOR
+void ADeftLedgeGraph::BuildLedgeGraph()
+{
+	UWorld* world = GetWorld();
+	if (!world || SampleSpacing <= 0.f || CellSize <= 0.f)
+		return;
+
+	struct FLedgeSample
+	{
+		FVector EdgePoint;
+		FVector TopNormal;
+		FVector Outward;
+		float FreeDepth;
+		float Clearance;
+		int32 Direction;	// which of the probe directions found it
+		int32 Line;			// lips found in the same direction on the same line (across it) can be joined into one segment
+		float Along;		// and where along that line it is
+	};
+
+	const FVector probeDirections[4] = { FVector::ForwardVector, FVector::BackwardVector, FVector::RightVector, FVector::LeftVector };
+	const FBox bounds = FBox::BuildAABB(GetActorLocation(), BuildExtent);
+	const FCollisionObjectQueryParams staticObjectParams(ECC_WorldStatic);
+	const FCollisionQueryParams queryParams(SCENE_QUERY_STAT(DeftLedgeGraphBuild), false, this);
+
+	auto traceStatic = [world, &staticObjectParams, &queryParams](FHitResult& outHit, const FVector& aStart, const FVector& aEnd)
+	{
+		return world->LineTraceSingleByObjectType(outHit, aStart, aEnd, staticObjectParams, queryParams);
+	};
+
+	Modify();
+
+	TArray<FLedgeSample> samples;
+	const int32 numX = FMath::FloorToInt32((bounds.Max.X - bounds.Min.X) / SampleSpacing) + 1;
+	const int32 numY = FMath::FloorToInt32((bounds.Max.Y - bounds.Min.Y) / SampleSpacing) + 1;
+	for (int32 ix = 0; ix < numX; ++ix)
+	{
+		for (int32 iy = 0; iy < numY; ++iy)
+		{
+			const float x = bounds.Min.X + (ix * SampleSpacing);
+			const float y = bounds.Min.Y + (iy * SampleSpacing);
+
+			// Every floor in this column, top down
+			float layerTopZ = bounds.Max.Z;
+			for (int32 layer = 0; layer < MaxLayers && layerTopZ > bounds.Min.Z; ++layer)
+			{
+				FHitResult floorHit;
+				if (!traceStatic(floorHit, FVector(x, y, layerTopZ), FVector(x, y, bounds.Min.Z)))
+					break;
+
+				layerTopZ = floorHit.Location.Z - LedgeLayerGap;
+				if (floorHit.ImpactNormal.Z < WalkableFloorZ)
+					continue;
+
+				const FVector floorLoc = floorHit.Location;
+				for (int32 direction = 0; direction < 4; ++direction)
+				{
+					const FVector& probeDir = probeDirections[direction];
+					const FVector beyond = floorLoc + (probeDir * SampleSpacing);
+
+					// A wall going up isn't a ledge, neither is ground carrying on at about the same height
+					FHitResult ignoredHit;
+					if (traceStatic(ignoredHit, floorLoc + (FVector::UpVector * LedgeKneeHeight), beyond + (FVector::UpVector * LedgeKneeHeight)))
+						continue;
+					if (traceStatic(ignoredHit, beyond + (FVector::UpVector * LedgeKneeHeight), beyond - (FVector::UpVector * MinDrop)))
+						continue;
+
+					// The face of the drop, coming back at it from outside gives where the lip actually is
+					FHitResult lipHit;
+					if (!traceStatic(lipHit, beyond - (FVector::UpVector * LedgeLipProbeOffset), floorLoc - (FVector::UpVector * LedgeLipProbeOffset)))
+						continue;
+
+					FLedgeSample& sample = samples.AddDefaulted_GetRef();
+					sample.EdgePoint = FVector(lipHit.Location.X, lipHit.Location.Y, floorLoc.Z);
+					sample.TopNormal = floorHit.ImpactNormal;
+					sample.Outward = lipHit.ImpactNormal.GetSafeNormal2D();
+					if (sample.Outward.IsNearlyZero())
+						sample.Outward = probeDir;
+
+					FHitResult depthHit;
+					const FVector depthStart = sample.EdgePoint + (FVector::UpVector * LedgeKneeHeight);
+					sample.FreeDepth = traceStatic(depthHit, depthStart, depthStart - (sample.Outward * MaxFreeDepth)) ? depthHit.Distance : MaxFreeDepth;
+
+					FHitResult clearanceHit;
+					const FVector clearanceStart = sample.EdgePoint - (sample.Outward * LedgeLipProbeOffset) + FVector::UpVector;
+					sample.Clearance = traceStatic(clearanceHit, clearanceStart, clearanceStart + (FVector::UpVector * MaxClearance)) ? clearanceHit.Distance : MaxClearance;
+
+					sample.Direction = direction;
+					const bool bAlongY = FMath::Abs(probeDir.X) > 0.f;
+					sample.Line = FMath::RoundToInt32((bAlongY ? sample.EdgePoint.X : sample.EdgePoint.Y) / (SampleSpacing * 0.5f));
+					sample.Along = bAlongY ? sample.EdgePoint.Y : sample.EdgePoint.X;
+				}
+			}
+		}
+	}
+
+	// Neighbouring lips along the same line at about the same height are one segment
+	samples.Sort([](const FLedgeSample& aLhs, const FLedgeSample& aRhs)
+	{
+		if (aLhs.Direction != aRhs.Direction)
+			return aLhs.Direction < aRhs.Direction;
+		if (aLhs.Line != aRhs.Line)
+			return aLhs.Line < aRhs.Line;
+		return aLhs.Along < aRhs.Along;
+	});
+
+	Segments.Reset();
+	const FLedgeSample* previous = nullptr;
+	for (const FLedgeSample& sample : samples)
+	{
+		const bool bContinues = previous && previous->Direction == sample.Direction && previous->Line == sample.Line
+			&& (sample.Along - previous->Along) <= SampleSpacing * 1.5f && FMath::Abs(sample.EdgePoint.Z - previous->EdgePoint.Z) <= LedgeMergeHeightTolerance;
+
+		if (bContinues)
+		{
+			FDeftLedgeSegment& segment = Segments.Last();
+			segment.End = sample.EdgePoint;
+			segment.FreeDepth = FMath::Min(segment.FreeDepth, sample.FreeDepth);
+			segment.Clearance = FMath::Min(segment.Clearance, sample.Clearance);
+		}
+		else
+		{
+			FDeftLedgeSegment& segment = Segments.AddDefaulted_GetRef();
+			segment.Start = segment.End = sample.EdgePoint;
+			segment.TopNormal = sample.TopNormal;
+			segment.Outward = sample.Outward;
+			segment.FreeDepth = sample.FreeDepth;
+			segment.Clearance = sample.Clearance;
+		}
+		previous = &sample;
+	}
+
+	// Each sample stands for the spacing around it, not just the point it was found at
+	for (FDeftLedgeSegment& segment : Segments)
+	{
+		const FVector along = FVector::CrossProduct(FVector::UpVector, segment.Outward);
+		const FVector startToEnd = segment.End - segment.Start;
+		const FVector extend = (startToEnd.IsNearlyZero() ? along : startToEnd.GetSafeNormal()) * (SampleSpacing * 0.5f);
+		segment.Start -= extend;
+		segment.End += extend;
+	}
+
+	BakedBounds = bounds;
+	BakedCellSize = CellSize;
+	BuildGrid();
+
+	NumSegments = Segments.Num();
+	UE_LOG(LogTemp, Display, TEXT("%s: baked %d ledge segments from %d lips"), *GetName(), Segments.Num(), samples.Num());
+}
+
+void ADeftLedgeGraph::BuildGrid()
+{
+	GridSize = FIntPoint(
+		FMath::Max(FMath::CeilToInt32((BakedBounds.Max.X - BakedBounds.Min.X) / BakedCellSize), 1),
+		FMath::Max(FMath::CeilToInt32((BakedBounds.Max.Y - BakedBounds.Min.Y) / BakedCellSize), 1));
+	const int32 numCells = GridSize.X * GridSize.Y;
+
+	// Count, prefix sum into starts, then fill. Every segment goes in each cell its bounds touch
+	auto forEachCell = [this](const FDeftLedgeSegment& aSegment, TFunctionRef<void(int32)> aFunction)
+	{
+		const FIntPoint minCell = GetCell(aSegment.Start.ComponentMin(aSegment.End));
+		const FIntPoint maxCell = GetCell(aSegment.Start.ComponentMax(aSegment.End));
+		for (int32 y = minCell.Y; y <= maxCell.Y; ++y)
+		{
+			for (int32 x = minCell.X; x <= maxCell.X; ++x)
+				aFunction((y * GridSize.X) + x);
+		}
+	};
+
+	CellStarts.Reset();
+	CellStarts.SetNumZeroed(numCells + 1);
+	for (const FDeftLedgeSegment& segment : Segments)
+		forEachCell(segment, [this](int32 aCell) { ++CellStarts[aCell + 1]; });
+
+	for (int32 cell = 0; cell < numCells; ++cell)
+		CellStarts[cell + 1] += CellStarts[cell];
+
+	TArray<int32> cellFill(CellStarts.GetData(), numCells);
+	CellSegments.Reset();
+	CellSegments.SetNumUninitialized(CellStarts[numCells]);
+	for (int32 segmentIndex = 0; segmentIndex < Segments.Num(); ++segmentIndex)
+		forEachCell(Segments[segmentIndex], [this, &cellFill, segmentIndex](int32 aCell) { CellSegments[cellFill[aCell]++] = segmentIndex; });
+}
+#endif //WITH_EDITOR
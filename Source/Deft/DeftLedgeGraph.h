@@ -0,0 +1,156 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "DeftLedgeGraph.generated.h"
+
+// A straight run of ledge, the lip of a walkable top with a drop below it
+USTRUCT()
+struct FDeftLedgeSegment
+{
+	GENERATED_BODY()
+
+	FDeftLedgeSegment()
+		: Start(FVector::ZeroVector)
+		, End(FVector::ZeroVector)
+		, TopNormal(FVector::UpVector)
+		, Outward(FVector::ForwardVector)
+		, FreeDepth(0.f)
+		, Clearance(0.f)
+	{}
+
+	// Edge line along the lip, at the height of the top
+	UPROPERTY()
+	FVector Start;
+
+	UPROPERTY()
+	FVector End;
+
+	UPROPERTY()
+	FVector TopNormal;
+
+	// Horizontal, pointing off the ledge (towards whoever is climbing up it)
+	UPROPERTY()
+	FVector Outward;
+
+	// How far back from the lip the top is clear to stand on, the least along the whole segment
+	UPROPERTY()
+	float FreeDepth;
+
+	// Room above the top before anything overhangs it, the least along the whole segment
+	UPROPERTY()
+	float Clearance;
+};
+
+// What a ledge up needs from a ledge, see ADeftLedgeGraph::FindLedge
+struct FDeftLedgeQuery
+{
+	FVector Location;		// capsule center
+	FVector Forward;		// facing, only the horizontal part matters
+	float Reach;			// furthest the lip can be from Location horizontally
+	float MinHeight;		// lip height relative to Location
+	float MaxHeight;
+	float MinDepth;
+	float MinClearance;
+};
+
+struct FDeftLedgeHit
+{
+	FVector EdgePoint;		// closest point on the lip
+	FVector Outward;
+	FVector TopNormal;
+	int32 SegmentIndex;
+};
+
+/**
+ * Every ledge in the static collision around it, found once in the editor (Build Ledge Graph) and saved with the level.
+ * Segments are bucketed into a flat 2D grid so a ledge up is a lookup in the cells around the character instead of a chain of scene queries.
+ * Depth and clearance are only probed along a couple of lines, enough to throw out most ledges but not to promise a capsule fits.
+ * Whoever uses a ledge still checks where they'll end up, and that catches anything that moved there too
+ */
+UCLASS()
+class DEFT_API ADeftLedgeGraph : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ADeftLedgeGraph();
+
+	// The graph covering aLocation in aWorld, null if no baked graph does
+	static const ADeftLedgeGraph* FindCovering(const UWorld* aWorld, const FVector& aLocation);
+
+	bool Covers(const FVector& aLocation) const;
+	// The closest ledge which satisfies aQuery, false if there isn't one
+	bool FindLedge(const FDeftLedgeQuery& aQuery, FDeftLedgeHit& outHit) const;
+
+	const TArray<FDeftLedgeSegment>& GetSegments() const { return Segments; }
+
+#if WITH_EDITOR
+	// Probes the static collision within BuildExtent for ledges, replacing whatever was baked before
+	UFUNCTION(CallInEditor, Category = "Ledge Graph")
+	void BuildLedgeGraph();
+#endif //WITH_EDITOR
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type aEndPlayReason) override;
+
+	// Half size of the box around the actor that gets baked
+	UPROPERTY(EditAnywhere, Category = "Ledge Graph|Build")
+	FVector BuildExtent;
+
+	// Distance between probes, ledges narrower than this can be missed
+	UPROPERTY(EditAnywhere, Category = "Ledge Graph|Build")
+	float SampleSpacing;
+
+	// How far the ground has to fall away past the lip for it to count as a ledge
+	UPROPERTY(EditAnywhere, Category = "Ledge Graph|Build")
+	float MinDrop;
+
+	// Tops steeper than this (normal Z) aren't something to stand on
+	UPROPERTY(EditAnywhere, Category = "Ledge Graph|Build")
+	float WalkableFloorZ;
+
+	// Depth and clearance are only measured this far, anything more is plenty
+	UPROPERTY(EditAnywhere, Category = "Ledge Graph|Build")
+	float MaxFreeDepth;
+
+	UPROPERTY(EditAnywhere, Category = "Ledge Graph|Build")
+	float MaxClearance;
+
+	// Floors stacked on top of each other that get probed per column
+	UPROPERTY(EditAnywhere, Category = "Ledge Graph|Build")
+	int32 MaxLayers;
+
+	UPROPERTY(EditAnywhere, Category = "Ledge Graph|Build")
+	float CellSize;
+
+	UPROPERTY(VisibleAnywhere, Category = "Ledge Graph")
+	int32 NumSegments;
+
+private:
+#if WITH_EDITOR
+	void BuildGrid();
+#endif //WITH_EDITOR
+
+	FIntPoint GetCell(const FVector& aLocation) const;
+
+	UPROPERTY()
+	TArray<FDeftLedgeSegment> Segments;
+
+	// Grid cell c holds CellSegments[CellStarts[c]] up to (not including) CellSegments[CellStarts[c + 1]]
+	UPROPERTY()
+	TArray<int32> CellStarts;
+
+	UPROPERTY()
+	TArray<int32> CellSegments;
+
+	UPROPERTY()
+	FBox BakedBounds;
+
+	UPROPERTY()
+	FIntPoint GridSize;
+
+	UPROPERTY()
+	float BakedCellSize;	// CellSize the grid was built with, editing CellSize doesn't do anything until it's rebuilt
+};
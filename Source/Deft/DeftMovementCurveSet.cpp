@@ -0,0 +1,169 @@
+#include "DeftMovementCurveSet.h"
+
+#include "Curves/CurveFloat.h"
+#include "UObject/ObjectSaveContext.h"
+
+UDeftMovementCurveSet::UDeftMovementCurveSet()
+	: JumpCurve(nullptr)
+	, JumpFallCurve(nullptr)
+	, NonJumpFallCurve(nullptr)
+	, SlideCurve(nullptr)
+	, JumpApexTime(0.f)
+	, JumpApexHeight(0.f)
+	, bIsJumpApexValid(false)
+	, JumpCurveBaked()
+	, JumpFallCurveBaked()
+	, NonJumpFallCurveBaked()
+	, SlideCurveBaked()
+{
+}
+
+void UDeftMovementCurveSet::PostLoad()
+{
+	Super::PostLoad();
+
+#if WITH_EDITOR
+	// The curves may have been edited since this was saved, editor loads can afford to redo it
+	Analyze();
+#endif //WITH_EDITOR
+
+	RegisterBakedCurves();
+}
+
+#if WITH_EDITOR
+void UDeftMovementCurveSet::PostEditChangeProperty(FPropertyChangedEvent& aPropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(aPropertyChangedEvent);
+
+	Analyze();
+	RegisterBakedCurves();
+}
+
+void UDeftMovementCurveSet::PreSave(FObjectPreSaveContext aObjectSaveContext)
+{
+	Super::PreSave(aObjectSaveContext);
+
+	Analyze();
+}
+#endif //WITH_EDITOR
+
+void UDeftMovementCurveSet::Analyze()
+{
+	auto bakeCurve = [](const UCurveFloat* aCurve, FDeftBakedCurve& outBakedCurve)
+	{
+		outBakedCurve.Reset();
+		if (aCurve && aCurve->FloatCurve.GetNumKeys() > 0)
+			outBakedCurve.Bake(*aCurve);
+	};
+
+	bakeCurve(JumpCurve, JumpCurveBaked);
+	bakeCurve(JumpFallCurve, JumpFallCurveBaked);
+	bakeCurve(NonJumpFallCurve, NonJumpFallCurveBaked);
+	bakeCurve(SlideCurve, SlideCurveBaked);
+
+	JumpApexTime = 0.f;
+	JumpApexHeight = 0.f;
+	bIsJumpApexValid = JumpCurve && FindCurveApex(JumpCurve->FloatCurve, JumpApexTime, JumpApexHeight);
+	if (!bIsJumpApexValid && JumpCurve)
+		UE_LOG(LogTemp, Error, TEXT("%s: Invalid Jump Curve, no Apex found"), *GetName());
+}
+
+void UDeftMovementCurveSet::RegisterBakedCurves() const
+{
+	FDeftBakedCurve::Register(JumpCurve, JumpCurveBaked);
+	FDeftBakedCurve::Register(JumpFallCurve, JumpFallCurveBaked);
+	FDeftBakedCurve::Register(NonJumpFallCurve, NonJumpFallCurveBaked);
+	FDeftBakedCurve::Register(SlideCurve, SlideCurveBaked);
+}
+
+bool UDeftMovementCurveSet::FindCurveApex(const FRichCurve& aCurve, float& outApexTime, float& outApexValue)
+{
+	/*
+		The highest point is either on a key or where a cubic segment's slope is 0.
+		Unweighted cubic segments are the bezier UE evaluates them as:
+			P0 = value1, P1 = value1 + leaveTangent1 * dt/3, P2 = value2 - arriveTangent2 * dt/3, P3 = value2
+		whose derivative 3[(a - 2b + c)s^2 + 2(b - a)s + a] with a = P1-P0, b = P2-P1, c = P3-P2 is a quadratic we can just solve.
+		Weighted tangents don't have a closed form so those segments get sampled instead.
+	*/
+	const TArray<FRichCurveKey>& keys = aCurve.GetConstRefOfKeys();
+	if (keys.Num() < 2)
+		return false;
+
+	outApexTime = keys[0].Time;
+	outApexValue = keys[0].Value;
+
+	// Ties keep the earliest time, a flat top counts as reached the moment we get to it
+	auto considerTime = [&aCurve, &outApexTime, &outApexValue](float aTime)
+	{
+		const float value = aCurve.Eval(aTime);
+		if (value > outApexValue)
+		{
+			outApexTime = aTime;
+			outApexValue = value;
+		}
+	};
+
+	for (int32 i = 0, end = keys.Num() - 1; i < end; ++i)
+	{
+		const FRichCurveKey& key1 = keys[i];
+		const FRichCurveKey& key2 = keys[i + 1];
+		const float timeDiff = key2.Time - key1.Time;
+
+		if (key1.InterpMode == RCIM_Cubic && timeDiff > 0.f)
+		{
+			const bool isWeighted = (key1.TangentWeightMode == RCTWM_WeightedLeave || key1.TangentWeightMode == RCTWM_WeightedBoth) ||
+				(key2.TangentWeightMode == RCTWM_WeightedArrive || key2.TangentWeightMode == RCTWM_WeightedBoth);
+
+			if (isWeighted)
+			{
+				const int weightedSegmentSamples = 64;
+				for (int j = 1; j < weightedSegmentSamples; ++j)
+					considerTime(key1.Time + (timeDiff * j) / weightedSegmentSamples);
+			}
+			else
+			{
+				const float p0 = key1.Value;
+				const float p1 = key1.Value + (key1.LeaveTangent * timeDiff / 3.f);
+				const float p2 = key2.Value - (key2.ArriveTangent * timeDiff / 3.f);
+				const float p3 = key2.Value;
+
+				const float a = p1 - p0;
+				const float b = p2 - p1;
+				const float c = p3 - p2;
+
+				const float quadA = a - (2.f * b) + c;
+				const float quadB = 2.f * (b - a);
+				const float quadC = a;
+
+				float roots[2];
+				int numRoots = 0;
+				if (FMath::IsNearlyZero(quadA))
+				{
+					if (!FMath::IsNearlyZero(quadB))
+						roots[numRoots++] = -quadC / quadB;
+				}
+				else
+				{
+					const float discriminant = (quadB * quadB) - (4.f * quadA * quadC);
+					if (discriminant >= 0.f)
+					{
+						const float discriminantSqrt = FMath::Sqrt(discriminant);
+						roots[numRoots++] = (-quadB - discriminantSqrt) / (2.f * quadA);
+						roots[numRoots++] = (-quadB + discriminantSqrt) / (2.f * quadA);
+					}
+				}
+
+				for (int j = 0; j < numRoots; ++j)
+				{
+					if (roots[j] > 0.f && roots[j] < 1.f)
+						considerTime(key1.Time + (roots[j] * timeDiff));
+				}
+			}
+		}
+
+		considerTime(key2.Time);
+	}
+
+	// Highest at either end means the curve only goes one way, there's nothing to reach
+	return outApexTime > keys[0].Time && outApexTime < keys.Last().Time;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "DeftBakedCurve.h"
+#include "DeftMovementCurveSet.generated.h"
+
+struct FRichCurve;
+
+/**
+ * Every curve the Deft movement modes run on, analyzed and baked when the asset is edited/saved so spawning a character doesn't have to
+ */
+UCLASS(BlueprintType)
+class DEFT_API UDeftMovementCurveSet : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UDeftMovementCurveSet();
+
+	void PostLoad() override;
+#if WITH_EDITOR
+	void PostEditChangeProperty(FPropertyChangedEvent& aPropertyChangedEvent) override;
+	void PreSave(FObjectPreSaveContext aObjectSaveContext) override;
+#endif //WITH_EDITOR
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Deft Movement", meta=(DisplayName="Jump Curve"))
+	UCurveFloat* JumpCurve;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Deft Movement", meta=(DisplayName="Jump Fall Curve"))
+	UCurveFloat* JumpFallCurve;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Deft Movement", meta=(DisplayName="Non Jump Fall Curve"))
+	UCurveFloat* NonJumpFallCurve;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Deft Movement", meta=(DisplayName="Slide Curve"))
+	UCurveFloat* SlideCurve;
+
+	// Exact time/height of the jump curve's highest point, solved from its keys
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Analysis")
+	float JumpApexTime;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Analysis")
+	float JumpApexHeight;
+
+	// false when the jump curve never turns back down (or there is no jump curve)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Analysis")
+	bool bIsJumpApexValid;
+
+private:
+	// Recomputes everything under "Analysis" and the baked tables
+	void Analyze();
+	void RegisterBakedCurves() const;
+
+	static bool FindCurveApex(const FRichCurve& aCurve, float& outApexTime, float& outApexValue);
+
+	UPROPERTY()
+	FDeftBakedCurve JumpCurveBaked;
+
+	UPROPERTY()
+	FDeftBakedCurve JumpFallCurveBaked;
+
+	UPROPERTY()
+	FDeftBakedCurve NonJumpFallCurveBaked;
+
+	UPROPERTY()
+	FDeftBakedCurve SlideCurveBaked;
+};
@@ -0,0 +1,177 @@
+#include "DeftParabolaPath.h"
+
+FDeftParabolaPath::FDeftParabolaPath()
+	: Origin(FVector::ZeroVector)
+	, Forward(FVector::ForwardVector)
+	, Up(FVector::UpVector)
+	, VelocityForward(0.f)
+	, VelocityUp(0.f)
+	, Gravity(0.f)
+	, EndTime(0.f)
+	, Length(0.f)
+{
+	FMemory::Memzero(TimeAtDistance);
+}
+
+bool FDeftParabolaPath::Init(const FVector& aOrigin, const FVector& aForward, const FVector& aUp, float aSpeed, float aAngle, float aGravity, const FVector& aPathEnd)
+{
+	Reset();
+
+	float angleSin, angleCos;
+	FMath::SinCos(&angleSin, &angleCos, FMath::DegreesToRadians(aAngle));
+
+	Origin = aOrigin;
+	Forward = aForward;
+	Up = aUp;
+	VelocityForward = aSpeed * angleCos;
+	VelocityUp = aSpeed * angleSin;
+	Gravity = aGravity;
+
+	// time until we're back at the height we started from, launching downwards never gets there
+	if (Gravity >= 0.f || VelocityUp <= 0.f)
+	{
+		Reset();
+		return false;
+	}
+	EndTime = (VelocityUp * 2.f) / -Gravity;
+
+	/*
+		We've gone past aPathEnd once we're further along origin->end than the end itself:
+			toEnd.(forward*x(t) + up*z(t)) = |toEnd|^2	with x(t) = vf*t, z(t) = vu*t + 1/2gt^2
+		which is the quadratic (1/2g*toEnd.up) t^2 + (vf*toEnd.forward + vu*toEnd.up) t - |toEnd|^2 = 0, the first time it's true is where the path ends
+	*/
+	const FVector toEnd = aPathEnd - Origin;
+	const float a = 0.5f * Gravity * toEnd.Dot(Up);
+	const float b = (VelocityForward * toEnd.Dot(Forward)) + (VelocityUp * toEnd.Dot(Up));
+	const float c = -toEnd.SizeSquared();
+
+	float passEndTime = TNumericLimits<float>::Max();
+	if (FMath::IsNearlyZero(a))
+	{
+		if (b > 0.f)
+			passEndTime = -c / b;
+	}
+	else
+	{
+		const float discriminant = (b * b) - (4.f * a * c);
+		if (discriminant >= 0.f)
+		{
+			const float discriminantSqrt = FMath::Sqrt(discriminant);
+			const float root1 = (-b - discriminantSqrt) / (2.f * a);
+			const float root2 = (-b + discriminantSqrt) / (2.f * a);
+			if (FMath::Min(root1, root2) >= 0.f)
+				passEndTime = FMath::Min(root1, root2);
+			else if (FMath::Max(root1, root2) >= 0.f)
+				passEndTime = FMath::Max(root1, root2);
+		}
+	}
+	EndTime = FMath::Min(EndTime, passEndTime);
+
+	BuildArcLengthTable();
+	return IsValid();
+}
+
+void FDeftParabolaPath::Reset()
+{
+	*this = FDeftParabolaPath();
+}
+
+FVector FDeftParabolaPath::GetLocationAtTime(float aTime) const
+{
+	const float time = FMath::Clamp(aTime, 0.f, EndTime);
+	const float forwardDistance = VelocityForward * time;
+	const float upDistance = (VelocityUp * time) + (0.5f * Gravity * time * time);
+	return Origin + (Forward * forwardDistance) + (Up * upDistance);
+}
+
+FVector FDeftParabolaPath::GetLocationAtDistance(float aDistance) const
+{
+	if (!IsValid())
+		return Origin;
+
+	const float tableIndex = FMath::Clamp(aDistance / Length, 0.f, 1.f) * (ArcLengthTableSize - 1);
+	const int32 index = FMath::Min((int32)tableIndex, ArcLengthTableSize - 2);
+	return GetLocationAtTime(FMath::Lerp(TimeAtDistance[index], TimeAtDistance[index + 1], tableIndex - index));
+}
+
+void FDeftParabolaPath::Sample(float aStepTime, TArray<FVector>& outPoints) const
+{
+	outPoints.Reset();
+	if (!IsValid() || aStepTime <= 0.f)
+		return;
+
+	const int32 numSteps = FMath::CeilToInt32(EndTime / aStepTime);
+	outPoints.Reserve(numSteps + 1);
+	for (int32 i = 0; i < numSteps; ++i)
+		outPoints.Emplace(GetLocationAtTime(i * aStepTime));
+	outPoints.Emplace(GetEndLocation());
+}
+
+bool FDeftParabolaPath::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	Ar << Origin;
+	Ar << Forward;
+	Ar << Up;
+	Ar << VelocityForward;
+	Ar << VelocityUp;
+	Ar << Gravity;
+	Ar << EndTime;
+
+	if (Ar.IsLoading())
+		BuildArcLengthTable();
+
+	bOutSuccess = true;
+	return true;
+}
+
+void FDeftParabolaPath::BuildArcLengthTable()
+{
+	Length = GetDistanceAtTime(EndTime);
+	if (Length <= 0.f)
+	{
+		Length = 0.f;
+		return;
+	}
+
+	// Distance only ever grows with time so a bisection per entry finds exactly when we've travelled that far
+	TimeAtDistance[0] = 0.f;
+	TimeAtDistance[ArcLengthTableSize - 1] = EndTime;
+	for (int32 i = 1; i < ArcLengthTableSize - 1; ++i)
+	{
+		const float distance = (Length * i) / (ArcLengthTableSize - 1);
+		float low = TimeAtDistance[i - 1];
+		float high = EndTime;
+		for (int32 iteration = 0; iteration < 24; ++iteration)
+		{
+			const float mid = (low + high) * 0.5f;
+			if (GetDistanceAtTime(mid) < distance)
+				low = mid;
+			else
+				high = mid;
+		}
+		TimeAtDistance[i] = (low + high) * 0.5f;
+	}
+}
+
+float FDeftParabolaPath::GetDistanceAtTime(float aTime) const
+{
+	/*
+		Speed along the arc is sqrt(vf^2 + u^2) with u = vu + g*t, which integrates to
+			s(t) = (F(vu + g*t) - F(vu)) / g		with F(u) = 1/2 (u*sqrt(vf^2 + u^2) + vf^2 * asinh(u / vf))
+	*/
+	const float velocityForward = FMath::Abs(VelocityForward);
+	auto antiderivative = [velocityForward](float aU)
+	{
+		if (velocityForward < UE_KINDA_SMALL_NUMBER)
+			return 0.5f * aU * FMath::Abs(aU);
+
+		const float ratio = aU / velocityForward;
+		const float asinh = FMath::Loge(ratio + FMath::Sqrt((ratio * ratio) + 1.f));
+		return 0.5f * ((aU * FMath::Sqrt((velocityForward * velocityForward) + (aU * aU))) + (velocityForward * velocityForward * asinh));
+	};
+
+	if (FMath::IsNearlyZero(Gravity))
+		return FMath::Sqrt((VelocityForward * VelocityForward) + (VelocityUp * VelocityUp)) * aTime;
+
+	return (antiderivative(VelocityUp + (Gravity * aTime)) - antiderivative(VelocityUp)) / Gravity;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DeftParabolaPath.generated.h"
+
+/**
+ * Launch arc kept as its launch parameters rather than a list of points, with a table from distance travelled to time on the arc
+ * so something moving along it at a constant speed finds where it is in one lookup
+ */
+USTRUCT()
+struct DEFT_API FDeftParabolaPath
+{
+	GENERATED_BODY()
+
+	FDeftParabolaPath();
+
+	// Fine enough that moving between entries at any speed we pull at is indistinguishable from moving along the real arc
+	static constexpr int32 ArcLengthTableSize = 64;
+
+	// Arc launched aAngle degrees up from aForward at aSpeed, cut off where it passes aPathEnd or comes back down to where it started. False if it never leaves the ground
+	bool Init(const FVector& aOrigin, const FVector& aForward, const FVector& aUp, float aSpeed, float aAngle, float aGravity, const FVector& aPathEnd);
+	void Reset();
+
+	FVector GetLocationAtTime(float aTime) const;
+	// Constant time no matter how long the path is, distances past either end are clamped to it
+	FVector GetLocationAtDistance(float aDistance) const;
+	// Points every aStepTime along the path, the end of it included
+	void Sample(float aStepTime, TArray<FVector>& outPoints) const;
+
+	float GetLength() const { return Length; }
+	float GetEndTime() const { return EndTime; }
+	FVector GetEndLocation() const { return GetLocationAtTime(EndTime); }
+	bool IsValid() const { return Length > 0.f; }
+
+	// Only the launch parameters go over the network, the table is rebuilt on the other end
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+private:
+	void BuildArcLengthTable();
+	float GetDistanceAtTime(float aTime) const;
+
+	UPROPERTY()
+	FVector Origin;
+
+	UPROPERTY()
+	FVector Forward;
+
+	UPROPERTY()
+	FVector Up;
+
+	UPROPERTY()
+	float VelocityForward;
+
+	UPROPERTY()
+	float VelocityUp;
+
+	UPROPERTY()
+	float Gravity;
+
+	UPROPERTY()
+	float EndTime;
+
+	float Length;
+	float TimeAtDistance[ArcLengthTableSize];	// time on the arc after travelling Length * i / (ArcLengthTableSize - 1)
+};
+
+template<>
+struct TStructOpsTypeTraits<FDeftParabolaPath> : public TStructOpsTypeTraitsBase2<FDeftParabolaPath>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
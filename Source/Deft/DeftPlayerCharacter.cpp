@@ -28,6 +28,7 @@ ADeftPlayerCharacter::ADeftPlayerCharacter(const FObjectInitializer& ObjectIniti
 	, ClimbComponent(nullptr)
 	, GrappleComponent(nullptr)
 	, PredictPathComponent(nullptr)
+	, CollisionContext()
 	, InputMoveVector(FVector2D::ZeroVector)
 	, JumpDelayMaxTime(0.f)
 	, JumpDelayTime(0.f)
@@ -87,6 +88,27 @@ void ADeftPlayerCharacter::BeginPlay()
 	}
 }
 
+void ADeftPlayerCharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	CollisionContext.Refresh(*this);
+}
+
+void ADeftPlayerCharacter::OnStartCrouch(float HalfHeightAdjust, float ScaledHalfHeightAdjust)
+{
+	Super::OnStartCrouch(HalfHeightAdjust, ScaledHalfHeightAdjust);
+
+	CollisionContext.Refresh(*this);
+}
+
+void ADeftPlayerCharacter::OnEndCrouch(float HalfHeightAdjust, float ScaledHalfHeightAdjust)
+{
+	Super::OnEndCrouch(HalfHeightAdjust, ScaledHalfHeightAdjust);
+
+	CollisionContext.Refresh(*this);
+}
+
 bool ADeftPlayerCharacter::CanJumpInternal_Implementation() const
 {
 	return JumpIsAllowedInternal();
@@ -2,6 +2,7 @@
 
 #include "CoreMinimal.h"
 #include "InputActionValue.h"
+#include "DeftCollisionContext.h"
 #include "GameFramework/Character.h"
 #include "DeftPlayerCharacter.generated.h"
 
@@ -24,12 +25,19 @@ public:
 
 	const FVector2D& GetInputMoveVector() const { return InputMoveVector; }
 	class UPredictPathComponent* GetPredictPathComponent() const { return PredictPathComponent; }
+	class UCameraComponent* GetCameraComponent() const { return CameraComp; }
+	const FDeftCollisionContext& GetCollisionContext() const { return CollisionContext; }
 
 	FOnJumpInputPressedDelegate OnJumpInputPressed;
 
 protected:
 	// Called when the game starts or when spawned
 	void BeginPlay() override;
+	// Override Reason: components grab the collision context in their BeginPlay so it has to be ready before then
+	void PostInitializeComponents() override;
+	// Override Reason: crouching (and sliding) resizes the capsule, the collision context has to follow
+	void OnStartCrouch(float HalfHeightAdjust, float ScaledHalfHeightAdjust) override;
+	void OnEndCrouch(float HalfHeightAdjust, float ScaledHalfHeightAdjust) override;
 	bool CanJumpInternal_Implementation() const override;
 
 	void Move(const FInputActionValue& aValue);
@@ -81,6 +89,8 @@ protected:
 	class UPredictPathComponent* PredictPathComponent;
 
 private:
+	FDeftCollisionContext CollisionContext;
+
 	FVector2D InputMoveVector;
 	
 	float JumpDelayMaxTime;
@@ -0,0 +1,287 @@
+#include "DeftPullSubsystem.h"
+
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+
+namespace
+{
+	const float PullMinMove = 0.1f;		// not worth a sweep
+}
+
+UDeftPullSubsystem::UDeftPullSubsystem()
+	: PullActors()
+	, PullKeys()
+	, PullRoots()
+	, PullPullers()
+	, LocationsX()
+	, LocationsY()
+	, LocationsZ()
+	, PullerLocationsX()
+	, PullerLocationsY()
+	, PullerLocationsZ()
+	, NextLocationsX()
+	, NextLocationsY()
+	, NextLocationsZ()
+	, Speeds()
+	, StopDistances()
+	, IsSimulating()
+	, SweepHandles()
+	, SweepEnds()
+	, QueryParams()
+	, ActorToPull()
+	, FinishedPulls()
+{
+}
+
+void UDeftPullSubsystem::Deinitialize()
+{
+	// Let go of everything we were throwing around
+	for (int32 i = PullActors.Num() - 1; i >= 0; --i)
+		FinishPull(i, false);
+
+	Super::Deinitialize();
+}
+
+TStatId UDeftPullSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDeftPullSubsystem, STATGROUP_Tickables);
+}
+
+bool UDeftPullSubsystem::DoesSupportWorldType(const EWorldType::Type aWorldType) const
+{
+	return aWorldType == EWorldType::Game || aWorldType == EWorldType::PIE;
+}
+
+bool UDeftPullSubsystem::StartPull(AActor* aActor, USceneComponent* aPuller, float aSpeed, float aStopDistance)
+{
+	if (!aActor || !aPuller || aSpeed <= 0.f)
+		return false;
+
+	UPrimitiveComponent* root = Cast<UPrimitiveComponent>(aActor->GetRootComponent());
+	if (!root)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s can't be pulled, its root isn't a primitive component"), *aActor->GetName());
+		return false;
+	}
+
+	const bool bIsSimulating = root->IsSimulatingPhysics();
+	if (!bIsSimulating && root->Mobility != EComponentMobility::Movable)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s can't be pulled, it isn't movable"), *aActor->GetName());
+		return false;
+	}
+
+	// Pulled again by someone else, they get it from here
+	StopPull(aActor);
+
+	FCollisionQueryParams queryParams(SCENE_QUERY_STAT(DeftPull), false, aActor);
+	queryParams.AddIgnoredActor(aPuller->GetOwner());
+	queryParams.bFindInitialOverlaps = false;	// whatever it's resting on when we grab it shouldn't stop it leaving
+
+	const FVector location = root->GetComponentLocation();
+	const int32 index = PullActors.Add(aActor);
+	PullKeys.Add(FObjectKey(aActor));
+	PullRoots.Add(root);
+	PullPullers.Add(aPuller);
+	LocationsX.Add(location.X);
+	LocationsY.Add(location.Y);
+	LocationsZ.Add(location.Z);
+	PullerLocationsX.AddZeroed();
+	PullerLocationsY.AddZeroed();
+	PullerLocationsZ.AddZeroed();
+	NextLocationsX.AddZeroed();
+	NextLocationsY.AddZeroed();
+	NextLocationsZ.AddZeroed();
+	Speeds.Add(aSpeed);
+	StopDistances.Add(aStopDistance);
+	IsSimulating.Add(bIsSimulating);
+	SweepHandles.AddDefaulted();
+	SweepEnds.Add(location);
+	QueryParams.Add(queryParams);
+
+	ActorToPull.Add(FObjectKey(aActor), index);
+	return true;
+}
+
+void UDeftPullSubsystem::StopPull(AActor* aActor)
+{
+	if (const int32* index = ActorToPull.Find(FObjectKey(aActor)))
+		FinishPull(*index, false);
+}
+
+void UDeftPullSubsystem::Tick(float aDeltaTime)
+{
+	Super::Tick(aDeltaTime);
+
+	if (PullActors.Num() == 0)
+		return;
+
+	ApplySweepResults();
+
+	// Anything destroyed since last frame gets dropped, everything else steps from wherever it actually is now
+	for (int32 i = PullActors.Num() - 1; i >= 0; --i)
+	{
+		if (!PullActors[i].IsValid() || !PullRoots[i].IsValid() || !PullPullers[i].IsValid())
+		{
+			FinishPull(i, false);
+			continue;
+		}
+
+		const FVector location = PullRoots[i]->GetComponentLocation();
+		LocationsX[i] = location.X;
+		LocationsY[i] = location.Y;
+		LocationsZ[i] = location.Z;
+
+		const FVector pullerLocation = PullPullers[i]->GetComponentLocation();
+		PullerLocationsX[i] = pullerLocation.X;
+		PullerLocationsY[i] = pullerLocation.Y;
+		PullerLocationsZ[i] = pullerLocation.Z;
+	}
+
+	Integrate(aDeltaTime);
+
+	FinishedPulls.Reset();
+	for (int32 i = 0; i < PullActors.Num(); ++i)
+	{
+		const FVector location(LocationsX[i], LocationsY[i], LocationsZ[i]);
+		const FVector nextLocation(NextLocationsX[i], NextLocationsY[i], NextLocationsZ[i]);
+		const bool bArrived = FVector::DistSquared(location, nextLocation) < FMath::Square(PullMinMove);
+
+		// Physics does its own collision, all it needs from us is which way to go
+		if (IsSimulating[i])
+		{
+			const FVector velocity = bArrived ? FVector::ZeroVector : (nextLocation - location) / aDeltaTime;
+			PullRoots[i]->SetPhysicsLinearVelocity(velocity);
+		}
+
+		if (bArrived)
+			FinishedPulls.Add(i);
+	}
+
+	// Highest index first so swap removing doesn't move any of the others
+	for (int32 i = FinishedPulls.Num() - 1; i >= 0; --i)
+		FinishPull(FinishedPulls[i], true);
+
+	SubmitSweeps();
+}
+
+void UDeftPullSubsystem::ApplySweepResults()
+{
+	UWorld* world = GetWorld();
+	for (int32 i = PullActors.Num() - 1; i >= 0; --i)
+	{
+		if (IsSimulating[i] || !SweepHandles[i].IsValid())
+			continue;
+
+		FTraceDatum sweep;
+		const bool bHasResult = world->QueryTraceData(SweepHandles[i], sweep);
+		SweepHandles[i] = FTraceHandle();
+		if (!bHasResult || !PullRoots[i].IsValid())
+			continue;
+
+		// Sweeps are from where it was when they went out so the hit (or the end) is still where it should be
+		const FHitResult* hit = FHitResult::GetFirstBlockingHit(sweep.OutHits);
+		PullRoots[i]->SetWorldLocation(hit ? hit->Location : SweepEnds[i], false, nullptr, ETeleportType::None);
+
+		if (hit)
+			FinishPull(i, false);
+	}
+}
+
+void UDeftPullSubsystem::Integrate(float aDeltaTime)
+{
+	const int32 numPulls = PullActors.Num();
+	const VectorRegister4Float deltaTime = VectorSetFloat1(aDeltaTime);
+	const VectorRegister4Float smallNumber = VectorSetFloat1(UE_SMALL_NUMBER);
+
+	int32 i = 0;
+	for (; i + 4 <= numPulls; i += 4)
+	{
+		const VectorRegister4Float xs = VectorLoad(LocationsX.GetData() + i);
+		const VectorRegister4Float ys = VectorLoad(LocationsY.GetData() + i);
+		const VectorRegister4Float zs = VectorLoad(LocationsZ.GetData() + i);
+		const VectorRegister4Float toXs = VectorSubtract(VectorLoad(PullerLocationsX.GetData() + i), xs);
+		const VectorRegister4Float toYs = VectorSubtract(VectorLoad(PullerLocationsY.GetData() + i), ys);
+		const VectorRegister4Float toZs = VectorSubtract(VectorLoad(PullerLocationsZ.GetData() + i), zs);
+
+		const VectorRegister4Float distSqs = VectorMultiplyAdd(toZs, toZs, VectorMultiplyAdd(toYs, toYs, VectorMultiply(toXs, toXs)));
+		const VectorRegister4Float dists = VectorMax(VectorSqrt(distSqs), smallNumber);
+		const VectorRegister4Float remaining = VectorMax(VectorSubtract(dists, VectorLoad(StopDistances.GetData() + i)), VectorZeroFloat());
+		const VectorRegister4Float moves = VectorMin(VectorMultiply(VectorLoad(Speeds.GetData() + i), deltaTime), remaining);
+		const VectorRegister4Float scales = VectorDivide(moves, dists);
+
+		VectorStore(VectorMultiplyAdd(toXs, scales, xs), NextLocationsX.GetData() + i);
+		VectorStore(VectorMultiplyAdd(toYs, scales, ys), NextLocationsY.GetData() + i);
+		VectorStore(VectorMultiplyAdd(toZs, scales, zs), NextLocationsZ.GetData() + i);
+	}
+
+	for (; i < numPulls; ++i)
+	{
+		const FVector location(LocationsX[i], LocationsY[i], LocationsZ[i]);
+		const FVector toPuller = FVector(PullerLocationsX[i], PullerLocationsY[i], PullerLocationsZ[i]) - location;
+		const float dist = FMath::Max(toPuller.Length(), UE_SMALL_NUMBER);
+		const float remaining = FMath::Max(dist - StopDistances[i], 0.f);
+		const float move = FMath::Min(Speeds[i] * aDeltaTime, remaining);
+
+		const FVector nextLocation = location + (toPuller * (move / dist));
+		NextLocationsX[i] = nextLocation.X;
+		NextLocationsY[i] = nextLocation.Y;
+		NextLocationsZ[i] = nextLocation.Z;
+	}
+}
+
+void UDeftPullSubsystem::SubmitSweeps()
+{
+	// All queued together, they go out as one batch at the end of the frame
+	UWorld* world = GetWorld();
+	for (int32 i = 0; i < PullActors.Num(); ++i)
+	{
+		if (IsSimulating[i])
+			continue;
+
+		const UPrimitiveComponent* root = PullRoots[i].Get();
+		const FVector start(LocationsX[i], LocationsY[i], LocationsZ[i]);
+		SweepEnds[i] = FVector(NextLocationsX[i], NextLocationsY[i], NextLocationsZ[i]);
+		SweepHandles[i] = world->AsyncSweepByChannel(EAsyncTraceType::Single, start, SweepEnds[i], root->GetComponentQuat(), root->GetCollisionObjectType(), root->GetCollisionShape(), QueryParams[i], FCollisionResponseParams(root->GetCollisionResponseToChannels()));
+	}
+}
+
+void UDeftPullSubsystem::FinishPull(int32 aIndex, bool bArrived)
+{
+	AActor* actor = PullActors[aIndex].Get();
+	if (IsSimulating[aIndex] && PullRoots[aIndex].IsValid())
+		PullRoots[aIndex]->SetPhysicsLinearVelocity(FVector::ZeroVector);
+
+	RemovePull(aIndex);
+	if (actor)
+		OnPullFinished.Broadcast(actor, bArrived);
+}
+
+void UDeftPullSubsystem::RemovePull(int32 aIndex)
+{
+	ActorToPull.Remove(PullKeys[aIndex]);
+
+	const int32 lastIndex = PullActors.Num() - 1;
+	if (aIndex != lastIndex)
+		ActorToPull.Add(PullKeys[lastIndex], aIndex);
+
+	PullActors.RemoveAtSwap(aIndex, 1, false);
+	PullKeys.RemoveAtSwap(aIndex, 1, false);
+	PullRoots.RemoveAtSwap(aIndex, 1, false);
+	PullPullers.RemoveAtSwap(aIndex, 1, false);
+	LocationsX.RemoveAtSwap(aIndex, 1, false);
+	LocationsY.RemoveAtSwap(aIndex, 1, false);
+	LocationsZ.RemoveAtSwap(aIndex, 1, false);
+	PullerLocationsX.RemoveAtSwap(aIndex, 1, false);
+	PullerLocationsY.RemoveAtSwap(aIndex, 1, false);
+	PullerLocationsZ.RemoveAtSwap(aIndex, 1, false);
+	NextLocationsX.RemoveAtSwap(aIndex, 1, false);
+	NextLocationsY.RemoveAtSwap(aIndex, 1, false);
+	NextLocationsZ.RemoveAtSwap(aIndex, 1, false);
+	Speeds.RemoveAtSwap(aIndex, 1, false);
+	StopDistances.RemoveAtSwap(aIndex, 1, false);
+	IsSimulating.RemoveAtSwap(aIndex, 1, false);
+	SweepHandles.RemoveAtSwap(aIndex, 1, false);
+	SweepEnds.RemoveAtSwap(aIndex, 1, false);
+	QueryParams.RemoveAtSwap(aIndex, 1, false);
+}
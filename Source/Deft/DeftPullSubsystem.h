@@ -0,0 +1,73 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "WorldCollision.h"
+#include "DeftPullSubsystem.generated.h"
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnDeftPullFinished, AActor* /*aActor*/, bool /*bArrived*/);
+
+/**
+ * Moves every actor being grappled towards whoever grappled it, all of them in one pass a frame.
+ * Kinematic actors are stepped together and swept with one batch of async sweeps whose results are applied the next frame,
+ * simulated ones are just given a velocity and left to physics to collide
+ */
+UCLASS()
+class DEFT_API UDeftPullSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UDeftPullSubsystem();
+
+	void Deinitialize() override;
+	void Tick(float aDeltaTime) override;
+	TStatId GetStatId() const override;
+
+	// Pulls aActor towards aPuller until it's within aStopDistance of it or runs into something. False if the actor can't be moved
+	bool StartPull(AActor* aActor, class USceneComponent* aPuller, float aSpeed, float aStopDistance);
+	void StopPull(AActor* aActor);
+	bool IsBeingPulled(const AActor* aActor) const { return ActorToPull.Contains(FObjectKey(aActor)); }
+
+	int32 GetNumPulls() const { return PullActors.Num(); }
+
+	FOnDeftPullFinished OnPullFinished;
+
+protected:
+	// Override Reason: Only game worlds have anything to pull
+	bool DoesSupportWorldType(const EWorldType::Type aWorldType) const override;
+
+private:
+	// Moves kinematic pulls to wherever last frame's sweeps said they could get to
+	void ApplySweepResults();
+	// Steps every pull towards its puller 4 at a time, filling NextLocations
+	void Integrate(float aDeltaTime);
+	void SubmitSweeps();
+	void FinishPull(int32 aIndex, bool bArrived);
+	void RemovePull(int32 aIndex);
+
+	// Dense and swap-removed so the step runs straight through them
+	TArray<TWeakObjectPtr<AActor>> PullActors;
+	TArray<FObjectKey> PullKeys;		// still finds the actor in ActorToPull once it's been destroyed
+	TArray<TWeakObjectPtr<class UPrimitiveComponent>> PullRoots;
+	TArray<TWeakObjectPtr<class USceneComponent>> PullPullers;
+	TArray<float> LocationsX;
+	TArray<float> LocationsY;
+	TArray<float> LocationsZ;
+	TArray<float> PullerLocationsX;
+	TArray<float> PullerLocationsY;
+	TArray<float> PullerLocationsZ;
+	TArray<float> NextLocationsX;
+	TArray<float> NextLocationsY;
+	TArray<float> NextLocationsZ;
+	TArray<float> Speeds;
+	TArray<float> StopDistances;
+	TArray<bool> IsSimulating;			// moved by physics, no sweeps
+	TArray<FTraceHandle> SweepHandles;
+	TArray<FVector> SweepEnds;
+	TArray<FCollisionQueryParams> QueryParams;	// ignores the actor and whoever is pulling it
+
+	TMap<FObjectKey, int32> ActorToPull;
+	TArray<int32> FinishedPulls;		// scratch, indices finished this frame
+};
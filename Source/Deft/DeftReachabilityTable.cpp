@@ -0,0 +1,230 @@
+#include "DeftReachabilityTable.h"
+
+#include "HAL/IConsoleManager.h"
+
+namespace
+{
+	const float ReachMinDistance = 1.f;		// straight up/down has no launch angle to speak of, treat it as a hair forward
+	const float ExactSolveCells = 6.f;		// targets this many cells from the launch point are solved instead of looked up
+	const float ExactSolveEdgeFraction = 0.02f;	// same for targets this close to out of reach, as a fraction of the discriminant at the launch point (v^4)
+
+	// The v^4 - g(g*x^2 + 2y*v^2) under the sqrt in SolveClamped, negative when it's out of reach. g is down and > 0
+	float GetReachDiscriminant(float aSpeed, float aGravity, float aDistance, float aHeight)
+	{
+		const float x = FMath::Max(aDistance, ReachMinDistance);
+		const float vSq = aSpeed * aSpeed;
+		return (vSq * vSq) - (aGravity * ((aGravity * x * x) + (2.f * aHeight * vSq)));
+	}
+
+	/*
+		Launching at speed v and angle a with gravity g (pulling down) passes through x forward, y up when
+			y = x*tan(a) - g*x^2 / (2v^2 cos^2(a))
+		which with T = tan(a) and 1/cos^2 = 1 + T^2 is the quadratic
+			(g*x^2 / 2v^2)*T^2 - x*T + (y + g*x^2 / 2v^2) = 0
+			T = (v^2 +- sqrt(v^4 - g(g*x^2 + 2y*v^2))) / (g*x)
+		and the flight time is x / (v*cos(a)) = x*sqrt(1 + T^2) / v.
+		Returns whether it's reachable, when it isn't the discriminant is clamped to 0 so both solutions are the launch that gets the closest
+	*/
+	bool SolveClamped(float aSpeed, float aGravityZ, float aDistance, float aHeight, FDeftLaunchSolution& outLow, FDeftLaunchSolution& outHigh)
+	{
+		const float x = FMath::Max(aDistance, ReachMinDistance);
+		const float g = -aGravityZ;
+		if (aSpeed <= 0.f)
+		{
+			outLow = outHigh = FDeftLaunchSolution();
+			return false;
+		}
+
+		// No gravity, or gravity pushing up, and it's just a straight line
+		if (g <= UE_KINDA_SMALL_NUMBER)
+		{
+			outLow.Angle = FMath::RadiansToDegrees(FMath::Atan2(aHeight, x));
+			outLow.TimeOfFlight = FMath::Sqrt((x * x) + (aHeight * aHeight)) / aSpeed;
+			outHigh = outLow;
+			return true;
+		}
+
+		const float vSq = aSpeed * aSpeed;
+		const float discriminant = GetReachDiscriminant(aSpeed, g, x, aHeight);
+		const float discriminantSqrt = FMath::Sqrt(FMath::Max(discriminant, 0.f));
+
+		const float tanLow = (vSq - discriminantSqrt) / (g * x);
+		const float tanHigh = (vSq + discriminantSqrt) / (g * x);
+
+		outLow.Angle = FMath::RadiansToDegrees(FMath::Atan(tanLow));
+		outLow.TimeOfFlight = x * FMath::Sqrt(1.f + (tanLow * tanLow)) / aSpeed;
+		outHigh.Angle = FMath::RadiansToDegrees(FMath::Atan(tanHigh));
+		outHigh.TimeOfFlight = x * FMath::Sqrt(1.f + (tanHigh * tanHigh)) / aSpeed;
+		return discriminant >= 0.f;
+	}
+}
+
+FDeftReachabilityTable::FDeftReachabilityTable()
+	: LowAngles()
+	, HighAngles()
+	, LowTimes()
+	, HighTimes()
+	, Speed(0.f)
+	, GravityZ(0.f)
+	, MaxDistance(0.f)
+	, MaxHeight(0.f)
+	, SamplesPerDistance(0.f)
+	, SamplesPerHeight(0.f)
+	, ExactSolveRadiusSq(0.f)
+{
+}
+
+bool FDeftReachabilityTable::Solve(float aSpeed, float aGravityZ, float aDistance, float aHeight, FDeftLaunchSolution& outLow, FDeftLaunchSolution& outHigh)
+{
+	return SolveClamped(aSpeed, aGravityZ, aDistance, aHeight, outLow, outHigh);
+}
+
+bool FDeftReachabilityTable::IsReachable(float aSpeed, float aGravityZ, float aDistance, float aHeight)
+{
+	const float g = -aGravityZ;
+	if (aSpeed <= 0.f)
+		return false;
+	if (g <= UE_KINDA_SMALL_NUMBER)
+		return true;
+
+	return GetReachDiscriminant(aSpeed, g, aDistance, aHeight) >= 0.f;
+}
+
+void FDeftReachabilityTable::Build(float aSpeed, float aGravityZ, float aMaxDistance, float aMaxHeight)
+{
+	Speed = aSpeed;
+	GravityZ = aGravityZ;
+	MaxDistance = FMath::Max(aMaxDistance, ReachMinDistance);
+	MaxHeight = FMath::Max(aMaxHeight, ReachMinDistance);
+	SamplesPerDistance = (DistanceSamples - 1) / MaxDistance;
+	SamplesPerHeight = (HeightSamples - 1) / (MaxHeight * 2.f);
+	ExactSolveRadiusSq = FMath::Square(ExactSolveCells / FMath::Min(SamplesPerDistance, SamplesPerHeight));
+
+	const int32 numSamples = DistanceSamples * HeightSamples;
+	LowAngles.SetNumUninitialized(numSamples);
+	HighAngles.SetNumUninitialized(numSamples);
+	LowTimes.SetNumUninitialized(numSamples);
+	HighTimes.SetNumUninitialized(numSamples);
+
+	for (int32 h = 0; h < HeightSamples; ++h)
+	{
+		const float height = -MaxHeight + (h / SamplesPerHeight);
+		for (int32 d = 0; d < DistanceSamples; ++d)
+		{
+			FDeftLaunchSolution low, high;
+			SolveClamped(Speed, GravityZ, d / SamplesPerDistance, height, low, high);
+
+			const int32 index = (h * DistanceSamples) + d;
+			LowAngles[index] = low.Angle;
+			HighAngles[index] = high.Angle;
+			LowTimes[index] = low.TimeOfFlight;
+			HighTimes[index] = high.TimeOfFlight;
+		}
+	}
+}
+
+bool FDeftReachabilityTable::IsBuiltFor(float aSpeed, float aGravityZ, float aMaxDistance, float aMaxHeight) const
+{
+	return IsBuilt() && Speed == aSpeed && GravityZ == aGravityZ && MaxDistance == FMath::Max(aMaxDistance, ReachMinDistance) && MaxHeight == FMath::Max(aMaxHeight, ReachMinDistance);
+}
+
+bool FDeftReachabilityTable::Lookup(float aDistance, float aHeight, FDeftLaunchSolution& outLow, FDeftLaunchSolution& outHigh) const
+{
+	if (!IsBuilt() || aDistance < 0.f || aDistance > MaxDistance || FMath::Abs(aHeight) > MaxHeight)
+		return Solve(Speed, GravityZ, aDistance, aHeight, outLow, outHigh);
+
+	// Whether it's reachable at all doesn't need the table, and interpolating it would smear the edge
+	if (!CanReach(aDistance, aHeight))
+		return false;
+
+	// Near the launch point the angle swings from straight down to straight up within a few cells, and near the edge of reach
+	// the sqrt makes it change too fast between samples. Neither is interpolated well, both get solved exactly
+	const float g = -GravityZ;
+	const bool bIsNearOrigin = (aDistance * aDistance) + (aHeight * aHeight) < ExactSolveRadiusSq;
+	const bool bIsNearEdge = g > UE_KINDA_SMALL_NUMBER && GetReachDiscriminant(Speed, g, aDistance, aHeight) < ExactSolveEdgeFraction * FMath::Square(Speed * Speed);
+	if (bIsNearOrigin || bIsNearEdge)
+		return Solve(Speed, GravityZ, aDistance, aHeight, outLow, outHigh);
+
+	const float sampleDistance = aDistance * SamplesPerDistance;
+	const float sampleHeight = (aHeight + MaxHeight) * SamplesPerHeight;
+	const int32 d = FMath::Min((int32)sampleDistance, DistanceSamples - 2);
+	const int32 h = FMath::Min((int32)sampleHeight, HeightSamples - 2);
+	const float alphaD = sampleDistance - d;
+	const float alphaH = sampleHeight - h;
+
+	const int32 index = (h * DistanceSamples) + d;
+	auto bilerp = [index, alphaD, alphaH](const TArray<float>& aSamples)
+	{
+		const float* samples = aSamples.GetData() + index;
+		const float bottom = FMath::Lerp(samples[0], samples[1], alphaD);
+		const float top = FMath::Lerp(samples[DistanceSamples], samples[DistanceSamples + 1], alphaD);
+		return FMath::Lerp(bottom, top, alphaH);
+	};
+
+	outLow.Angle = bilerp(LowAngles);
+	outLow.TimeOfFlight = bilerp(LowTimes);
+	outHigh.Angle = bilerp(HighAngles);
+	outHigh.TimeOfFlight = bilerp(HighTimes);
+	return true;
+}
+
+#if !UE_BUILD_SHIPPING
+// Times the exact solve against the table over random targets, e.g. "deft.bench.reachability 100000 1500"
+static FAutoConsoleCommand CCmd_BenchReachability(
+	TEXT("deft.bench.reachability"),
+	TEXT("Compare FDeftReachabilityTable::Solve against Lookup. Optional args: number of targets, launch speed"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& aArgs)
+	{
+		const int32 numTargets = aArgs.Num() > 0 ? FMath::Max(FCString::Atoi(*aArgs[0]), 1) : 100000;
+		const float speed = aArgs.Num() > 1 ? FCString::Atof(*aArgs[1]) : 1500.f;
+		const float gravityZ = -980.f;
+		const float range = 1000.f;
+
+		FDeftReachabilityTable table;
+		double startSeconds = FPlatformTime::Seconds();
+		table.Build(speed, gravityZ, range, range);
+		const double buildSeconds = FPlatformTime::Seconds() - startSeconds;
+
+		TArray<FVector2f> targets;
+		targets.SetNumUninitialized(numTargets);
+		FRandomStream random(numTargets);
+		for (FVector2f& target : targets)
+			target = FVector2f(random.FRandRange(0.f, range), random.FRandRange(-range, range));
+
+		float sink = 0.f;
+		startSeconds = FPlatformTime::Seconds();
+		for (const FVector2f& target : targets)
+		{
+			FDeftLaunchSolution low, high;
+			if (FDeftReachabilityTable::Solve(speed, gravityZ, target.X, target.Y, low, high))
+				sink += low.Angle + high.Angle;
+		}
+		const double solveSeconds = FPlatformTime::Seconds() - startSeconds;
+
+		startSeconds = FPlatformTime::Seconds();
+		for (const FVector2f& target : targets)
+		{
+			FDeftLaunchSolution low, high;
+			if (table.Lookup(target.X, target.Y, low, high))
+				sink += low.Angle + high.Angle;
+		}
+		const double lookupSeconds = FPlatformTime::Seconds() - startSeconds;
+
+		float maxLowError = 0.f;
+		float maxHighError = 0.f;
+		int32 numReachable = 0;
+		for (const FVector2f& target : targets)
+		{
+			FDeftLaunchSolution exactLow, exactHigh, low, high;
+			if (FDeftReachabilityTable::Solve(speed, gravityZ, target.X, target.Y, exactLow, exactHigh) && table.Lookup(target.X, target.Y, low, high))
+			{
+				maxLowError = FMath::Max(maxLowError, FMath::Abs(exactLow.Angle - low.Angle));
+				maxHighError = FMath::Max(maxHighError, FMath::Abs(exactHigh.Angle - high.Angle));
+				++numReachable;
+			}
+		}
+
+		UE_LOG(LogTemp, Display, TEXT("Build %.3fms, Solve %.3fms, Lookup %.3fms, max angle error low %f deg high %f deg (%d/%d reachable, sink %f)"),
+			buildSeconds * 1000.0, solveSeconds * 1000.0, lookupSeconds * 1000.0, maxLowError, maxHighError, numReachable, numTargets, sink);
+	}));
+#endif //!UE_BUILD_SHIPPING
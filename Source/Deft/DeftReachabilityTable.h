@@ -0,0 +1,63 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// One way to launch at a target, see FDeftReachabilityTable
+struct FDeftLaunchSolution
+{
+	FDeftLaunchSolution()
+		: Angle(0.f)
+		, TimeOfFlight(0.f)
+	{}
+
+	float Angle;			// degrees up from horizontal
+	float TimeOfFlight;		// seconds until the arc passes through the target
+};
+
+/**
+ * Launch angles and flight times for every (distance forward, height) offset a launch at a fixed speed can be aimed at, on a grid so that
+ * testing a target is a bilinear lookup instead of a sqrt + atan. Good enough for reticles and picking between candidates, fire with Solve.
+ * Built for one speed and gravity, owners check IsBuiltFor and rebuild when either changes
+ */
+struct DEFT_API FDeftReachabilityTable
+{
+	FDeftReachabilityTable();
+
+	// Samples along each axis. Lookup solves exactly near the launch point and the edge of reach, where the angle changes too fast between samples,
+	// which keeps the interpolated angles within ~0.3 degrees of Solve everywhere else at the grapple's speed and range (deft.bench.reachability).
+	// Slower launches over the same range have a steeper edge and get closer to 2 degrees
+	static constexpr int32 DistanceSamples = 64;
+	static constexpr int32 HeightSamples = 64;
+
+	// Exact: both launches at aSpeed which pass through aDistance forward and aHeight up (down when negative), the flatter one first. False if it's out of reach
+	static bool Solve(float aSpeed, float aGravityZ, float aDistance, float aHeight, FDeftLaunchSolution& outLow, FDeftLaunchSolution& outHigh);
+	// Exact as well, only the part of Solve that doesn't need a sqrt
+	static bool IsReachable(float aSpeed, float aGravityZ, float aDistance, float aHeight);
+
+	// Covers distances [0, aMaxDistance] and heights [-aMaxHeight, aMaxHeight]
+	void Build(float aSpeed, float aGravityZ, float aMaxDistance, float aMaxHeight);
+	bool IsBuiltFor(float aSpeed, float aGravityZ, float aMaxDistance, float aMaxHeight) const;
+	bool IsBuilt() const { return LowAngles.Num() > 0; }
+
+	// Interpolated Solve, offsets outside what the table covers (or too close to the launch point or edge of reach to interpolate) are solved exactly instead
+	bool Lookup(float aDistance, float aHeight, FDeftLaunchSolution& outLow, FDeftLaunchSolution& outHigh) const;
+	bool CanReach(float aDistance, float aHeight) const { return IsReachable(Speed, GravityZ, aDistance, aHeight); }
+
+	float GetSpeed() const { return Speed; }
+	float GetGravityZ() const { return GravityZ; }
+
+private:
+	// Flattened [height][distance], unreachable samples hold the furthest reaching launch so interpolating towards them stays sane
+	TArray<float> LowAngles;
+	TArray<float> HighAngles;
+	TArray<float> LowTimes;
+	TArray<float> HighTimes;
+
+	float Speed;
+	float GravityZ;
+	float MaxDistance;
+	float MaxHeight;
+	float SamplesPerDistance;	// turns a distance into a (fractional) sample index
+	float SamplesPerHeight;
+	float ExactSolveRadiusSq;	// Lookup solves anything closer than this to the launch point
+};
@@ -0,0 +1,196 @@
+#include "DeftRootMotionSources.h"
+
+#include "Curves/CurveFloat.h"
+#include "DeftBakedCurve.h"
+#include "GameFramework/Character.h"
+
+//
+// Ledge Up
+//
+
+FRootMotionSource_DeftLedgeUp::FRootMotionSource_DeftLedgeUp()
+	: StartLocation(FVector::ZeroVector)
+	, TargetLocation(FVector::ZeroVector)
+	, HeightBoostCurve(nullptr)
+	, HeightBoostMax(0.f)
+	, HeightBoostCurveBaked(nullptr)
+{
+	// The ledge up decides exactly where we go, nothing else gets a say
+	AccumulateMode = ERootMotionAccumulateMode::Override;
+}
+
+FRootMotionSource* FRootMotionSource_DeftLedgeUp::Clone() const
+{
+	return new FRootMotionSource_DeftLedgeUp(*this);
+}
+
+bool FRootMotionSource_DeftLedgeUp::Matches(const FRootMotionSource* Other) const
+{
+	if (!FRootMotionSource::Matches(Other))
+		return false;
+
+	// Safe since FRootMotionSource::Matches() already checked the ScriptStruct is the same
+	const FRootMotionSource_DeftLedgeUp* otherCast = static_cast<const FRootMotionSource_DeftLedgeUp*>(Other);
+
+	return HeightBoostCurve == otherCast->HeightBoostCurve &&
+		FMath::IsNearlyEqual(HeightBoostMax, otherCast->HeightBoostMax) &&
+		StartLocation.Equals(otherCast->StartLocation, 1.f) &&
+		TargetLocation.Equals(otherCast->TargetLocation, 1.f);
+}
+
+bool FRootMotionSource_DeftLedgeUp::MatchesAndHasSameState(const FRootMotionSource* Other) const
+{
+	// No state beyond what the base tracks
+	return FRootMotionSource::MatchesAndHasSameState(Other);
+}
+
+bool FRootMotionSource_DeftLedgeUp::UpdateStateFrom(const FRootMotionSource* SourceToTakeStateFrom, bool bMarkForSimulatedCatchup)
+{
+	return FRootMotionSource::UpdateStateFrom(SourceToTakeStateFrom, bMarkForSimulatedCatchup);
+}
+
+void FRootMotionSource_DeftLedgeUp::PrepareRootMotion(float SimulationTime, float MovementTickTime, const ACharacter& Character, const UCharacterMovementComponent& MoveComponent)
+{
+	RootMotionParams.Clear();
+
+	if (Duration > SMALL_NUMBER && MovementTickTime > SMALL_NUMBER)
+	{
+		const float lerpTime = FMath::Clamp(GetTime() + SimulationTime, 0.f, Duration);
+
+		if (!HeightBoostCurveBaked.IsValid() && HeightBoostCurve)
+			HeightBoostCurveBaked = FDeftBakedCurve::FindOrBake(HeightBoostCurve);
+
+		// lerp!
+		const float heightBoost = HeightBoostCurveBaked.IsValid() ? HeightBoostCurveBaked->Eval(lerpTime) * HeightBoostMax : 0.f;
+		const float percent = lerpTime / Duration;
+		const FVector ledgeUpLoc = FMath::Lerp(StartLocation, TargetLocation, percent) + (FVector::UpVector * heightBoost);
+
+		// Root motion is the velocity that takes us from where we are to where the lerp wants us by the end of this tick
+		const FVector velocity = (ledgeUpLoc - Character.GetActorLocation()) / MovementTickTime;
+		RootMotionParams.Set(FTransform(velocity));
+	}
+
+	SetTime(GetTime() + SimulationTime);
+}
+
+bool FRootMotionSource_DeftLedgeUp::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	if (!FRootMotionSource::NetSerialize(Ar, Map, bOutSuccess))
+		return false;
+
+	Ar << StartLocation;
+	Ar << TargetLocation;
+	Ar << HeightBoostCurve;
+	Ar << HeightBoostMax;
+
+	bOutSuccess = true;
+	return true;
+}
+
+UScriptStruct* FRootMotionSource_DeftLedgeUp::GetScriptStruct() const
+{
+	return FRootMotionSource_DeftLedgeUp::StaticStruct();
+}
+
+FString FRootMotionSource_DeftLedgeUp::ToSimpleString() const
+{
+	return FString::Printf(TEXT("[ID:%u]FRootMotionSource_DeftLedgeUp %s"), LocalID, *InstanceName.GetPlainNameString());
+}
+
+void FRootMotionSource_DeftLedgeUp::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	Collector.AddReferencedObject(HeightBoostCurve);
+
+	FRootMotionSource::AddReferencedObjects(Collector);
+}
+
+//
+// Grapple Pull
+//
+
+FRootMotionSource_DeftGrapplePull::FRootMotionSource_DeftGrapplePull()
+	: Path()
+	, PathEndDistance(0.f)
+	, PullSpeed(0.f)
+{
+	AccumulateMode = ERootMotionAccumulateMode::Override;
+}
+
+void FRootMotionSource_DeftGrapplePull::SetPath(const FDeftParabolaPath& aPath, float aPullSpeed, float aPathEndDistance)
+{
+	Path = aPath;
+	PathEndDistance = FMath::Clamp(aPathEndDistance, 0.f, Path.GetLength());
+	PullSpeed = aPullSpeed;
+
+	Duration = PullSpeed > 0.f ? PathEndDistance / PullSpeed : 0.f;
+}
+
+FRootMotionSource* FRootMotionSource_DeftGrapplePull::Clone() const
+{
+	return new FRootMotionSource_DeftGrapplePull(*this);
+}
+
+bool FRootMotionSource_DeftGrapplePull::Matches(const FRootMotionSource* Other) const
+{
+	if (!FRootMotionSource::Matches(Other))
+		return false;
+
+	// Safe since FRootMotionSource::Matches() already checked the ScriptStruct is the same
+	const FRootMotionSource_DeftGrapplePull* otherCast = static_cast<const FRootMotionSource_DeftGrapplePull*>(Other);
+
+	return FMath::IsNearlyEqual(PullSpeed, otherCast->PullSpeed) &&
+		FMath::IsNearlyEqual(PathEndDistance, otherCast->PathEndDistance, 1.f) &&
+		Path.GetEndLocation().Equals(otherCast->Path.GetEndLocation(), 1.f);
+}
+
+bool FRootMotionSource_DeftGrapplePull::MatchesAndHasSameState(const FRootMotionSource* Other) const
+{
+	// No state beyond what the base tracks
+	return FRootMotionSource::MatchesAndHasSameState(Other);
+}
+
+bool FRootMotionSource_DeftGrapplePull::UpdateStateFrom(const FRootMotionSource* SourceToTakeStateFrom, bool bMarkForSimulatedCatchup)
+{
+	return FRootMotionSource::UpdateStateFrom(SourceToTakeStateFrom, bMarkForSimulatedCatchup);
+}
+
+void FRootMotionSource_DeftGrapplePull::PrepareRootMotion(float SimulationTime, float MovementTickTime, const ACharacter& Character, const UCharacterMovementComponent& MoveComponent)
+{
+	RootMotionParams.Clear();
+
+	if (Duration > SMALL_NUMBER && MovementTickTime > SMALL_NUMBER && Path.IsValid())
+	{
+		// Constant speed along the arc, however curved it is where we are
+		const float pullTime = FMath::Clamp(GetTime() + SimulationTime, 0.f, Duration);
+		const FVector pullLoc = Path.GetLocationAtDistance(pullTime * PullSpeed);
+
+		const FVector velocity = (pullLoc - Character.GetActorLocation()) / MovementTickTime;
+		RootMotionParams.Set(FTransform(velocity));
+	}
+
+	SetTime(GetTime() + SimulationTime);
+}
+
+bool FRootMotionSource_DeftGrapplePull::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	if (!FRootMotionSource::NetSerialize(Ar, Map, bOutSuccess))
+		return false;
+
+	if (!Path.NetSerialize(Ar, Map, bOutSuccess))
+		return false;
+	Ar << PathEndDistance;
+	Ar << PullSpeed;
+
+	bOutSuccess = true;
+	return true;
+}
+
+UScriptStruct* FRootMotionSource_DeftGrapplePull::GetScriptStruct() const
+{
+	return FRootMotionSource_DeftGrapplePull::StaticStruct();
+}
+
+FString FRootMotionSource_DeftGrapplePull::ToSimpleString() const
+{
+	return FString::Printf(TEXT("[ID:%u]FRootMotionSource_DeftGrapplePull %s"), LocalID, *InstanceName.GetPlainNameString());
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/RootMotionSource.h"
+#include "DeftParabolaPath.h"
+#include "DeftRootMotionSources.generated.h"
+
+/**
+ * Ledge up lerp from where the ledge was grabbed to the top of it, pushed upwards by the height boost curve so the capsule clears the lip
+ */
+USTRUCT()
+struct DEFT_API FRootMotionSource_DeftLedgeUp : public FRootMotionSource
+{
+	GENERATED_USTRUCT_BODY()
+
+	FRootMotionSource_DeftLedgeUp();
+	virtual ~FRootMotionSource_DeftLedgeUp() {}
+
+	UPROPERTY()
+	FVector StartLocation;
+
+	UPROPERTY()
+	FVector TargetLocation;
+
+	UPROPERTY()
+	TObjectPtr<UCurveFloat> HeightBoostCurve;
+
+	UPROPERTY()
+	float HeightBoostMax;
+
+	// Baked HeightBoostCurve, sources that arrive over the network look it up again on their first tick
+	TSharedPtr<const struct FDeftBakedCurve> HeightBoostCurveBaked;
+
+	virtual FRootMotionSource* Clone() const override;
+	virtual bool Matches(const FRootMotionSource* Other) const override;
+	virtual bool MatchesAndHasSameState(const FRootMotionSource* Other) const override;
+	virtual bool UpdateStateFrom(const FRootMotionSource* SourceToTakeStateFrom, bool bMarkForSimulatedCatchup = false) override;
+	virtual void PrepareRootMotion(float SimulationTime, float MovementTickTime, const ACharacter& Character, const UCharacterMovementComponent& MoveComponent) override;
+	virtual bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess) override;
+	virtual UScriptStruct* GetScriptStruct() const override;
+	virtual FString ToSimpleString() const override;
+	virtual void AddReferencedObjects(class FReferenceCollector& Collector) override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FRootMotionSource_DeftLedgeUp> : public TStructOpsTypeTraitsBase2<FRootMotionSource_DeftLedgeUp>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithCopy = true
+	};
+};
+
+/**
+ * Grapple pull along the predicted path at a constant speed
+ */
+USTRUCT()
+struct DEFT_API FRootMotionSource_DeftGrapplePull : public FRootMotionSource
+{
+	GENERATED_USTRUCT_BODY()
+
+	FRootMotionSource_DeftGrapplePull();
+	virtual ~FRootMotionSource_DeftGrapplePull() {}
+
+	// Sets the path to travel and derives Duration from how much of it we travel, aPathEndDistance stops short of the end (i.e. something is in the way)
+	void SetPath(const FDeftParabolaPath& aPath, float aPullSpeed, float aPathEndDistance);
+
+	UPROPERTY()
+	FDeftParabolaPath Path;
+
+	UPROPERTY()
+	float PathEndDistance;
+
+	UPROPERTY()
+	float PullSpeed;
+
+	virtual FRootMotionSource* Clone() const override;
+	virtual bool Matches(const FRootMotionSource* Other) const override;
+	virtual bool MatchesAndHasSameState(const FRootMotionSource* Other) const override;
+	virtual bool UpdateStateFrom(const FRootMotionSource* SourceToTakeStateFrom, bool bMarkForSimulatedCatchup = false) override;
+	virtual void PrepareRootMotion(float SimulationTime, float MovementTickTime, const ACharacter& Character, const UCharacterMovementComponent& MoveComponent) override;
+	virtual bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess) override;
+	virtual UScriptStruct* GetScriptStruct() const override;
+	virtual FString ToSimpleString() const override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FRootMotionSource_DeftGrapplePull> : public TStructOpsTypeTraitsBase2<FRootMotionSource_DeftGrapplePull>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithCopy = true
+	};
+};
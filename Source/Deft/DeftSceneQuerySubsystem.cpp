@@ -0,0 +1,231 @@
+#include "DeftSceneQuerySubsystem.h"
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+TAutoConsoleVariable<int32> CVar_SceneQueryBudget(TEXT("deft.sceneQueries.budget"), 64, TEXT("most scene queries run or sent per frame, immediate ones always run but count against it"), ECVF_Cheat);
+TAutoConsoleVariable<bool> CVar_DebugSceneQueries(TEXT("deft.debug.sceneQueries"), false, TEXT("show how many scene queries ran last frame and how many were held back"), ECVF_Cheat);
+
+FDeftSceneQuery FDeftSceneQuery::LineTrace(const FVector& aStart, const FVector& aEnd, ECollisionChannel aChannel, const FCollisionQueryParams& aParams)
+{
+	FDeftSceneQuery query;
+	query.Start = aStart;
+	query.End = aEnd;
+	query.Rotation = FQuat::Identity;
+	query.Shape = FCollisionShape();
+	query.ProfileName = NAME_None;
+	query.Channel = aChannel;
+	query.Params = aParams;
+	return query;
+}
+
+FDeftSceneQuery FDeftSceneQuery::Sweep(const FVector& aStart, const FVector& aEnd, const FQuat& aRotation, FName aProfileName, const FCollisionShape& aShape, const FCollisionQueryParams& aParams)
+{
+	FDeftSceneQuery query;
+	query.Start = aStart;
+	query.End = aEnd;
+	query.Rotation = aRotation;
+	query.Shape = aShape;
+	query.ProfileName = aProfileName;
+	query.Channel = ECC_Visibility;
+	query.Params = aParams;
+	return query;
+}
+
+UDeftSceneQuerySubsystem::UDeftSceneQuerySubsystem()
+	: PendingQueries()
+	, InFlightQueries()
+	, DroppedQueries()
+	, AsyncTraceDelegate()
+	, NextQueryID(1)
+	, QueriesThisFrame(0)
+	, BestEffortMaxFrames(8)
+#if !UE_BUILD_SHIPPING
+	, Debug_Immediate(0)
+	, Debug_NextFrame(0)
+	, Debug_BestEffort(0)
+	, Debug_Deferred(0)
+	, Debug_Dropped(0)
+#endif //!UE_BUILD_SHIPPING
+{
+}
+
+void UDeftSceneQuerySubsystem::Initialize(FSubsystemCollectionBase& aCollection)
+{
+	Super::Initialize(aCollection);
+
+	AsyncTraceDelegate.BindUObject(this, &UDeftSceneQuerySubsystem::OnAsyncTraceDone);
+}
+
+TStatId UDeftSceneQuerySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDeftSceneQuerySubsystem, STATGROUP_Tickables);
+}
+
+bool UDeftSceneQuerySubsystem::DoesSupportWorldType(const EWorldType::Type aWorldType) const
+{
+	return aWorldType == EWorldType::Game || aWorldType == EWorldType::PIE;
+}
+
+bool UDeftSceneQuerySubsystem::QueryNow(const FDeftSceneQuery& aQuery, FHitResult& outHit)
+{
+	++QueriesThisFrame;
+#if !UE_BUILD_SHIPPING
+	++Debug_Immediate;
+#endif //!UE_BUILD_SHIPPING
+
+	if (aQuery.IsSweep())
+		return GetWorld()->SweepSingleByProfile(outHit, aQuery.Start, aQuery.End, aQuery.Rotation, aQuery.ProfileName, aQuery.Shape, aQuery.Params);
+	return GetWorld()->LineTraceSingleByChannel(outHit, aQuery.Start, aQuery.End, aQuery.Channel, aQuery.Params);
+}
+
+uint32 UDeftSceneQuerySubsystem::Submit(const FDeftSceneQuery& aQuery, EDeftSceneQueryLatency aLatency, int32 aPriority, FOnDeftSceneQueryDone aOnDone)
+{
+	const uint32 queryID = NextQueryID++;
+	if (NextQueryID == 0)
+		NextQueryID = 1;	// 0 is never a query
+
+	// Nothing to wait for, answer straight away
+	if (aLatency == EDeftSceneQueryLatency::Immediate)
+	{
+		FDeftSceneQueryResult result;
+		result.Start = aQuery.Start;
+		result.End = aQuery.End;
+		result.bBlockingHit = QueryNow(aQuery, result.Hit);
+		aOnDone.ExecuteIfBound(result);
+		return 0;
+	}
+
+	PendingQueries.Add({ queryID, aQuery, aLatency, aPriority, GFrameCounter, MoveTemp(aOnDone) });
+	return queryID;
+}
+
+void UDeftSceneQuerySubsystem::Cancel(uint32& aQueryID)
+{
+	if (aQueryID == 0)
+		return;
+
+	// Sent ones still run, there's no taking back an async trace, their results just go nowhere
+	if (InFlightQueries.Remove(aQueryID) == 0)
+	{
+		const auto isQuery = [aQueryID](const FPendingQuery& aPendingQuery) { return aPendingQuery.ID == aQueryID; };
+		if (PendingQueries.RemoveAll(isQuery) == 0)
+			DroppedQueries.RemoveAll(isQuery);
+	}
+	aQueryID = 0;
+}
+
+void UDeftSceneQuerySubsystem::Tick(float aDeltaTime)
+{
+	Super::Tick(aDeltaTime);
+
+#if !UE_BUILD_SHIPPING
+	Debug_NextFrame = 0;
+	Debug_BestEffort = 0;
+	Debug_Deferred = 0;
+	Debug_Dropped = 0;
+#endif //!UE_BUILD_SHIPPING
+
+	// Next frame queries were promised, they go out whatever the budget says. Best effort gets what's left, most important and then oldest first
+	PendingQueries.StableSort([](const FPendingQuery& aLhs, const FPendingQuery& aRhs)
+	{
+		if (aLhs.Latency != aRhs.Latency)
+			return aLhs.Latency < aRhs.Latency;
+		if (aLhs.Priority != aRhs.Priority)
+			return aLhs.Priority > aRhs.Priority;
+		return aLhs.SubmitFrame < aRhs.SubmitFrame;
+	});
+
+	const int32 budget = CVar_SceneQueryBudget.GetValueOnGameThread();
+	int32 numKept = 0;
+	for (int32 i = 0; i < PendingQueries.Num(); ++i)
+	{
+		FPendingQuery& pendingQuery = PendingQueries[i];
+		if (pendingQuery.Latency == EDeftSceneQueryLatency::NextFrame || QueriesThisFrame < budget)
+		{
+#if !UE_BUILD_SHIPPING
+			if (pendingQuery.Latency == EDeftSceneQueryLatency::NextFrame)
+				++Debug_NextFrame;
+			else
+				++Debug_BestEffort;
+#endif //!UE_BUILD_SHIPPING
+			IssueQuery(pendingQuery);
+			continue;
+		}
+
+		if (GFrameCounter - pendingQuery.SubmitFrame >= BestEffortMaxFrames)
+		{
+#if !UE_BUILD_SHIPPING
+			++Debug_Dropped;
+#endif //!UE_BUILD_SHIPPING
+			DroppedQueries.Add(MoveTemp(pendingQuery));
+			continue;
+		}
+
+#if !UE_BUILD_SHIPPING
+		++Debug_Deferred;
+#endif //!UE_BUILD_SHIPPING
+		if (numKept != i)
+			PendingQueries[numKept] = MoveTemp(pendingQuery);
+		++numKept;
+	}
+	PendingQueries.SetNum(numKept, false);
+
+	// Only once we're done with PendingQueries, whoever gets told might want to submit again right away (or cancel one of the others being dropped)
+	while (DroppedQueries.Num() > 0)
+	{
+		const FPendingQuery droppedQuery = DroppedQueries.Pop(false);
+		FDeftSceneQueryResult result;
+		result.Start = droppedQuery.Query.Start;
+		result.End = droppedQuery.Query.End;
+		result.bDropped = true;
+		droppedQuery.OnDone.ExecuteIfBound(result);
+	}
+
+#if !UE_BUILD_SHIPPING
+	if (CVar_DebugSceneQueries.GetValueOnGameThread())
+		DrawDebug();
+	Debug_Immediate = 0;
+#endif //!UE_BUILD_SHIPPING
+
+	QueriesThisFrame = 0;
+}
+
+void UDeftSceneQuerySubsystem::IssueQuery(FPendingQuery& aPendingQuery)
+{
+	++QueriesThisFrame;
+
+	const FDeftSceneQuery& query = aPendingQuery.Query;
+	if (query.IsSweep())
+		GetWorld()->AsyncSweepByProfile(EAsyncTraceType::Single, query.Start, query.End, query.Rotation, query.ProfileName, query.Shape, query.Params, &AsyncTraceDelegate, aPendingQuery.ID);
+	else
+		GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, query.Start, query.End, query.Channel, query.Params, FCollisionResponseParams::DefaultResponseParam, &AsyncTraceDelegate, aPendingQuery.ID);
+
+	InFlightQueries.Add(aPendingQuery.ID, MoveTemp(aPendingQuery));
+}
+
+void UDeftSceneQuerySubsystem::OnAsyncTraceDone(const FTraceHandle& aTraceHandle, FTraceDatum& aTraceDatum)
+{
+	FPendingQuery pendingQuery;
+	if (!InFlightQueries.RemoveAndCopyValue(aTraceDatum.UserData, pendingQuery))
+		return;
+
+	FDeftSceneQueryResult result;
+	result.Start = aTraceDatum.Start;
+	result.End = aTraceDatum.End;
+	if (const FHitResult* hit = FHitResult::GetFirstBlockingHit(aTraceDatum.OutHits))
+	{
+		result.Hit = *hit;
+		result.bBlockingHit = true;
+	}
+	pendingQuery.OnDone.ExecuteIfBound(result);
+}
+
+#if !UE_BUILD_SHIPPING
+void UDeftSceneQuerySubsystem::DrawDebug() const
+{
+	GEngine->AddOnScreenDebugMessage(-1, 0.005, FColor::White, FString::Printf(TEXT("\tImmediate: %d\n\tNext frame: %d\n\tBest effort: %d (%d held back, %d dropped)\n\tBudget: %d"),
+		Debug_Immediate, Debug_NextFrame, Debug_BestEffort, Debug_Deferred, Debug_Dropped, CVar_SceneQueryBudget.GetValueOnGameThread()));
+	GEngine->AddOnScreenDebugMessage(-1, 0.005, FColor::Yellow, TEXT("\n-Scene Queries-"));
+}
+#endif //!UE_BUILD_SHIPPING
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CollisionQueryParams.h"
+#include "Engine/EngineTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WorldCollision.h"
+#include "DeftSceneQuerySubsystem.generated.h"
+
+// How long whoever asked can wait for an answer
+enum class EDeftSceneQueryLatency : uint8
+{
+	Immediate,		// run right now on the game thread, never held back
+	NextFrame,		// goes out with this frame's batch, answered before anything ticks next frame
+	BestEffort,		// goes out when there's budget left, highest priority first, and is dropped if there isn't for too long
+};
+
+// A single line trace or sweep, made with the static helpers
+struct DEFT_API FDeftSceneQuery
+{
+	static FDeftSceneQuery LineTrace(const FVector& aStart, const FVector& aEnd, ECollisionChannel aChannel, const FCollisionQueryParams& aParams);
+	static FDeftSceneQuery Sweep(const FVector& aStart, const FVector& aEnd, const FQuat& aRotation, FName aProfileName, const FCollisionShape& aShape, const FCollisionQueryParams& aParams);
+
+	bool IsSweep() const { return !ProfileName.IsNone(); }
+
+	FVector Start;
+	FVector End;
+	FQuat Rotation;
+	FCollisionShape Shape;
+	FName ProfileName;				// sweeps go by profile
+	ECollisionChannel Channel;		// line traces go by channel
+	FCollisionQueryParams Params;
+};
+
+struct FDeftSceneQueryResult
+{
+	FDeftSceneQueryResult()
+		: Hit()
+		, Start(FVector::ZeroVector)
+		, End(FVector::ZeroVector)
+		, bBlockingHit(false)
+		, bDropped(false)
+	{}
+
+	FHitResult Hit;
+	FVector Start;
+	FVector End;
+	bool bBlockingHit;
+	bool bDropped;		// never ran, there wasn't budget for it in time
+};
+
+DECLARE_DELEGATE_OneParam(FOnDeftSceneQueryDone, const FDeftSceneQueryResult& /*aResult*/);
+
+/**
+ * Every scene query the character components can wait for goes through here, so how many run a frame is under one budget (deft.sceneQueries.budget).
+ * Immediate queries run when asked and count against it, the rest go out together as async traces at the end of the frame with whatever budget is left.
+ * Best effort queries (previews, speculative probes) are what get held back when there are too many, so lots of characters slow those down instead of the frame
+ */
+UCLASS()
+class DEFT_API UDeftSceneQuerySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UDeftSceneQuerySubsystem();
+
+	void Initialize(FSubsystemCollectionBase& aCollection) override;
+	void Tick(float aDeltaTime) override;
+	TStatId GetStatId() const override;
+
+	// Blocking query right now, same as calling the world directly
+	bool QueryNow(const FDeftSceneQuery& aQuery, FHitResult& outHit);
+	// aOnDone is called once with the result (or dropped), unless the query is cancelled first. Higher aPriority goes first among best effort queries
+	uint32 Submit(const FDeftSceneQuery& aQuery, EDeftSceneQueryLatency aLatency, int32 aPriority, FOnDeftSceneQueryDone aOnDone);
+	// Nothing gets called for it, whether it ran already or not. Clears aQueryID
+	void Cancel(uint32& aQueryID);
+
+protected:
+	// Override Reason: Only game worlds have characters querying anything
+	bool DoesSupportWorldType(const EWorldType::Type aWorldType) const override;
+
+private:
+	struct FPendingQuery
+	{
+		uint32 ID;
+		FDeftSceneQuery Query;
+		EDeftSceneQueryLatency Latency;
+		int32 Priority;
+		uint64 SubmitFrame;
+		FOnDeftSceneQueryDone OnDone;
+	};
+
+	void IssueQuery(FPendingQuery& aPendingQuery);
+	void OnAsyncTraceDone(const FTraceHandle& aTraceHandle, FTraceDatum& aTraceDatum);
+
+	TArray<FPendingQuery> PendingQueries;		// submitted, not sent yet
+	TMap<uint32, FPendingQuery> InFlightQueries;	// sent, results come in at the start of next frame
+	TArray<FPendingQuery> DroppedQueries;		// held back too long, waiting to be told so
+	FTraceDelegate AsyncTraceDelegate;
+	uint32 NextQueryID;
+	int32 QueriesThisFrame;						// everything run or sent since the last batch, immediate ones included
+	uint64 BestEffortMaxFrames;					// how long a best effort query can be held back before it's dropped
+
+#if !UE_BUILD_SHIPPING
+	void DrawDebug() const;
+
+	int32 Debug_Immediate;
+	int32 Debug_NextFrame;
+	int32 Debug_BestEffort;
+	int32 Debug_Deferred;
+	int32 Debug_Dropped;
+#endif //!UE_BUILD_SHIPPING
+};
@@ -0,0 +1,550 @@
+#include "DeftStaticBVH.h"
+
+namespace
+{
+	const int32 BVHMaxLeafTriangles = 4;
+	const int32 BVHMaxDepth = 64;
+	const int32 CapsuleSegments = 8;		// around the axis
+	const int32 CapsuleCapRings = 3;		// per hemisphere, not counting the pole
+
+	// Segment from aStart along aDelta (scaled by 1/aDelta) against [aMin, aMax], overlapping before aTMax
+	bool SegmentOverlapsBox(const FVector3f& aStart, const FVector3f& aInvDelta, const FVector3f& aMin, const FVector3f& aMax, float aTMax)
+	{
+		float tMin = 0.f;
+		float tMax = aTMax;
+		for (int32 axis = 0; axis < 3; ++axis)
+		{
+			float t0 = (aMin[axis] - aStart[axis]) * aInvDelta[axis];
+			float t1 = (aMax[axis] - aStart[axis]) * aInvDelta[axis];
+			if (t0 > t1)
+				Swap(t0, t1);
+
+			tMin = FMath::Max(tMin, t0);
+			tMax = FMath::Min(tMax, t1);
+			if (tMin > tMax)
+				return false;
+		}
+		return true;
+	}
+
+	// Real-Time Collision Detection 5.1.5
+	FVector3f ClosestPointOnTriangle(const FVector3f& aPoint, const FVector3f& aA, const FVector3f& aB, const FVector3f& aC)
+	{
+		const FVector3f ab = aB - aA;
+		const FVector3f ac = aC - aA;
+		const FVector3f ap = aPoint - aA;
+		const float d1 = ab | ap;
+		const float d2 = ac | ap;
+		if (d1 <= 0.f && d2 <= 0.f)
+			return aA;
+
+		const FVector3f bp = aPoint - aB;
+		const float d3 = ab | bp;
+		const float d4 = ac | bp;
+		if (d3 >= 0.f && d4 <= d3)
+			return aB;
+
+		const float vc = (d1 * d4) - (d3 * d2);
+		if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f)
+			return aA + (ab * (d1 / (d1 - d3)));
+
+		const FVector3f cp = aPoint - aC;
+		const float d5 = ab | cp;
+		const float d6 = ac | cp;
+		if (d6 >= 0.f && d5 <= d6)
+			return aC;
+
+		const float vb = (d5 * d2) - (d1 * d6);
+		if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f)
+			return aA + (ac * (d2 / (d2 - d6)));
+
+		const float va = (d3 * d6) - (d5 * d4);
+		if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f)
+			return aB + ((aC - aB) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))));
+
+		const float denom = 1.f / (va + vb + vc);
+		return aA + (ab * (vb * denom)) + (ac * (vc * denom));
+	}
+
+	bool IsInsideTriangle(const FVector3f& aPoint, const FVector3f& aA, const FVector3f& aB, const FVector3f& aC, const FVector3f& aNormal)
+	{
+		return ((FVector3f::CrossProduct(aB - aA, aPoint - aA) | aNormal) >= 0.f)
+			&& ((FVector3f::CrossProduct(aC - aB, aPoint - aB) | aNormal) >= 0.f)
+			&& ((FVector3f::CrossProduct(aA - aC, aPoint - aC) | aNormal) >= 0.f);
+	}
+
+	// Moller-Trumbore, either side
+	bool RayTriangle(const FVector3f& aStart, const FVector3f& aDelta, const FVector3f& aA, const FVector3f& aB, const FVector3f& aC, float& outT)
+	{
+		const FVector3f ab = aB - aA;
+		const FVector3f ac = aC - aA;
+		const FVector3f p = FVector3f::CrossProduct(aDelta, ac);
+		const float det = ab | p;
+		if (FMath::Abs(det) < UE_SMALL_NUMBER)
+			return false;
+
+		const float invDet = 1.f / det;
+		const FVector3f s = aStart - aA;
+		const float u = (s | p) * invDet;
+		if (u < 0.f || u > 1.f)
+			return false;
+
+		const FVector3f q = FVector3f::CrossProduct(s, ab);
+		const float v = (aDelta | q) * invDet;
+		if (v < 0.f || u + v > 1.f)
+			return false;
+
+		outT = (ac | q) * invDet;
+		return outT >= 0.f && outT <= 1.f;
+	}
+
+	struct FSphereContact
+	{
+		float Time;
+		FVector3f Point;
+		FVector3f Normal;
+		bool bStartPenetrating;
+	};
+
+	/*
+		Sphere of aRadius moving from aStart along aDelta against one triangle, the first contact before aTMax.
+		Touching the face first means that's the first contact, otherwise it's the first of the edges (ray against a cylinder) and corners (ray against a sphere)
+	*/
+	bool SweepSphereTriangle(const FVector3f& aStart, const FVector3f& aDelta, float aRadius, const FVector3f& aA, const FVector3f& aB, const FVector3f& aC, const FVector3f& aNormal, float aTMax, FSphereContact& outContact)
+	{
+		const float radiusSq = aRadius * aRadius;
+
+		const FVector3f closest = ClosestPointOnTriangle(aStart, aA, aB, aC);
+		const FVector3f fromClosest = aStart - closest;
+		const float distSq = fromClosest.SizeSquared();
+		if (distSq < radiusSq)
+		{
+			const FVector3f faceNormal = ((aStart - aA) | aNormal) >= 0.f ? aNormal : -aNormal;
+			outContact.Time = 0.f;
+			outContact.Point = closest;
+			outContact.Normal = distSq > UE_SMALL_NUMBER ? fromClosest * FMath::InvSqrt(distSq) : faceNormal;
+			outContact.bStartPenetrating = true;
+			return true;
+		}
+
+		if (aNormal.IsNearlyZero())
+			return false;
+
+		// The face, from whichever side we're on
+		const float startDist = (aStart - aA) | aNormal;
+		const FVector3f faceNormal = startDist >= 0.f ? aNormal : -aNormal;
+		const float approach = aDelta | faceNormal;
+		if (approach < 0.f)
+		{
+			const float t = (aRadius - FMath::Abs(startDist)) / approach;
+			if (t >= 0.f && t <= aTMax)
+			{
+				const FVector3f point = aStart + (aDelta * t) - (faceNormal * aRadius);
+				if (IsInsideTriangle(point, aA, aB, aC, aNormal))
+				{
+					outContact.Time = t;
+					outContact.Point = point;
+					outContact.Normal = faceNormal;
+					outContact.bStartPenetrating = false;
+					return true;
+				}
+			}
+		}
+
+		bool bHit = false;
+		float bestT = aTMax;
+		const float deltaSq = aDelta.SizeSquared();
+		if (deltaSq < UE_SMALL_NUMBER)
+			return false;
+
+		const FVector3f corners[3] = { aA, aB, aC };
+		for (int32 i = 0; i < 3; ++i)
+		{
+			// Edge, ray against the infinite cylinder around it and then whether that's within the edge
+			const FVector3f& edgeStart = corners[i];
+			const FVector3f edge = corners[(i + 1) % 3] - edgeStart;
+			const FVector3f m = aStart - edgeStart;
+			const float ee = edge | edge;
+			const float ed = edge | aDelta;
+			const float em = edge | m;
+			const float a = (ee * deltaSq) - (ed * ed);
+			if (a > UE_SMALL_NUMBER)
+			{
+				const float b = (ee * (m | aDelta)) - (em * ed);
+				const float c = (ee * ((m | m) - radiusSq)) - (em * em);
+				const float discriminant = (b * b) - (a * c);
+				if (discriminant >= 0.f)
+				{
+					const float t = (-b - FMath::Sqrt(discriminant)) / a;
+					const float s = (em + (t * ed)) / ee;
+					if (t >= 0.f && t <= bestT && s >= 0.f && s <= 1.f)
+					{
+						bestT = t;
+						outContact.Point = edgeStart + (edge * s);
+						bHit = true;
+					}
+				}
+			}
+
+			// Corner
+			const FVector3f fromCorner = aStart - edgeStart;
+			const float b = fromCorner | aDelta;
+			const float c = (fromCorner | fromCorner) - radiusSq;
+			const float discriminant = (b * b) - (deltaSq * c);
+			if (b < 0.f && discriminant >= 0.f)
+			{
+				const float t = (-b - FMath::Sqrt(discriminant)) / deltaSq;
+				if (t >= 0.f && t <= bestT)
+				{
+					bestT = t;
+					outContact.Point = edgeStart;
+					bHit = true;
+				}
+			}
+		}
+
+		if (bHit)
+		{
+			outContact.Time = bestT;
+			outContact.Normal = ((aStart + (aDelta * bestT)) - outContact.Point) / aRadius;
+			outContact.bStartPenetrating = false;
+		}
+		return bHit;
+	}
+}
+
+FDeftStaticBVH::FDeftStaticBVH()
+	: Triangles()
+	, Nodes()
+	, Bounds(ForceInit)
+{
+}
+
+void FDeftStaticBVH::AddTriangle(const FVector& aA, const FVector& aB, const FVector& aC)
+{
+	FTriangle& triangle = Triangles.AddDefaulted_GetRef();
+	triangle.A = FVector3f(aA);
+	triangle.B = FVector3f(aB);
+	triangle.C = FVector3f(aC);
+	triangle.Normal = FVector3f::CrossProduct(triangle.B - triangle.A, triangle.C - triangle.A).GetSafeNormal();
+}
+
+void FDeftStaticBVH::AddMesh(const FTransform& aTransform, const TArray<FVector>& aVertices, const TArray<int32>& aIndices)
+{
+	for (int32 i = 0; i + 2 < aIndices.Num(); i += 3)
+		AddTriangle(aTransform.TransformPosition(aVertices[aIndices[i]]), aTransform.TransformPosition(aVertices[aIndices[i + 1]]), aTransform.TransformPosition(aVertices[aIndices[i + 2]]));
+}
+
+void FDeftStaticBVH::AddBox(const FTransform& aTransform, const FVector& aExtent)
+{
+	TArray<FVector> corners;
+	corners.Reserve(8);
+	for (int32 i = 0; i < 8; ++i)
+		corners.Add(FVector((i & 1) ? aExtent.X : -aExtent.X, (i & 2) ? aExtent.Y : -aExtent.Y, (i & 4) ? aExtent.Z : -aExtent.Z));
+
+	// Two per side, corner i has bit 0 for +X, bit 1 for +Y, bit 2 for +Z
+	static const TArray<int32> boxIndices = {
+		0, 2, 3, 0, 3, 1,	// -Z
+		4, 5, 7, 4, 7, 6,	// +Z
+		0, 1, 5, 0, 5, 4,	// -Y
+		2, 6, 7, 2, 7, 3,	// +Y
+		0, 4, 6, 0, 6, 2,	// -X
+		1, 3, 7, 1, 7, 5,	// +X
+	};
+	AddMesh(aTransform, corners, boxIndices);
+}
+
+void FDeftStaticBVH::AddCapsule(const FTransform& aTransform, float aRadius, float aHalfLength)
+{
+	// Rings from the top down, the top hemisphere's around +aHalfLength and the bottom's around -aHalfLength, both poles at the end
+	TArray<FVector> vertices;
+	for (int32 hemisphere = 0; hemisphere < 2; ++hemisphere)
+	{
+		const float centerZ = hemisphere == 0 ? aHalfLength : -aHalfLength;
+		for (int32 ring = 0; ring < CapsuleCapRings; ++ring)
+		{
+			// Top: 60, 30, 0 degrees up. Bottom: 0, -30, -60
+			const int32 step = hemisphere == 0 ? CapsuleCapRings - 1 - ring : -ring;
+			const float latitude = HALF_PI * step / CapsuleCapRings;
+			for (int32 segment = 0; segment < CapsuleSegments; ++segment)
+			{
+				const float longitude = TWO_PI * segment / CapsuleSegments;
+				vertices.Add(FVector(aRadius * FMath::Cos(latitude) * FMath::Cos(longitude), aRadius * FMath::Cos(latitude) * FMath::Sin(longitude), centerZ + (aRadius * FMath::Sin(latitude))));
+			}
+		}
+	}
+	const int32 numRings = CapsuleCapRings * 2;
+	const int32 topPole = vertices.Add(FVector(0.f, 0.f, aHalfLength + aRadius));
+	const int32 bottomPole = vertices.Add(FVector(0.f, 0.f, -aHalfLength - aRadius));
+
+	TArray<int32> indices;
+	for (int32 segment = 0; segment < CapsuleSegments; ++segment)
+	{
+		const int32 next = (segment + 1) % CapsuleSegments;
+		indices.Append({ topPole, next, segment });
+		for (int32 ring = 0; ring + 1 < numRings; ++ring)
+		{
+			const int32 upper = ring * CapsuleSegments;
+			const int32 lower = upper + CapsuleSegments;
+			indices.Append({ upper + segment, upper + next, lower + next, upper + segment, lower + next, lower + segment });
+		}
+		const int32 lastRing = (numRings - 1) * CapsuleSegments;
+		indices.Append({ bottomPole, lastRing + segment, lastRing + next });
+	}
+	AddMesh(aTransform, vertices, indices);
+}
+
+void FDeftStaticBVH::Build()
+{
+	Nodes.Reset();
+	Bounds.Init();
+
+	// Degenerate triangles can't be hit by anything
+	Triangles.RemoveAllSwap([](const FTriangle& aTriangle) { return aTriangle.Normal.IsNearlyZero(); }, false);
+	if (Triangles.Num() == 0)
+		return;
+
+	TArray<FVector3f> centroids;
+	TArray<int32> order;
+	centroids.SetNumUninitialized(Triangles.Num());
+	order.SetNumUninitialized(Triangles.Num());
+	for (int32 i = 0; i < Triangles.Num(); ++i)
+	{
+		centroids[i] = (Triangles[i].A + Triangles[i].B + Triangles[i].C) / 3.f;
+		order[i] = i;
+	}
+
+	// Depth first so an inner node's first child always lands right after it, the second child's index gets patched in once it's made
+	struct FBuildEntry
+	{
+		int32 Begin;
+		int32 End;
+		int32 Parent;	// waiting on this to be its second child, -1 if it's a first child (or the root)
+	};
+	TArray<FBuildEntry, TInlineAllocator<BVHMaxDepth * 2>> pending;
+	pending.Add({ 0, Triangles.Num(), INDEX_NONE });
+	Nodes.Reserve((Triangles.Num() / BVHMaxLeafTriangles) * 2 + 1);
+
+	while (pending.Num() > 0)
+	{
+		const FBuildEntry entry = pending.Pop(false);
+		const int32 nodeIndex = Nodes.AddDefaulted();
+		if (entry.Parent != INDEX_NONE)
+			Nodes[entry.Parent].FirstTriangleOrSecondChild = nodeIndex;
+
+		FBox3f nodeBounds(ForceInit);
+		FBox3f centroidBounds(ForceInit);
+		for (int32 i = entry.Begin; i < entry.End; ++i)
+		{
+			const FTriangle& triangle = Triangles[order[i]];
+			nodeBounds += triangle.A;
+			nodeBounds += triangle.B;
+			nodeBounds += triangle.C;
+			centroidBounds += centroids[order[i]];
+		}
+
+		FNode& node = Nodes[nodeIndex];
+		node.Min = nodeBounds.Min;
+		node.Max = nodeBounds.Max;
+
+		const int32 count = entry.End - entry.Begin;
+		const FVector3f centroidExtent = centroidBounds.GetSize();
+		const int32 axis = centroidExtent.X >= centroidExtent.Y ? (centroidExtent.X >= centroidExtent.Z ? 0 : 2) : (centroidExtent.Y >= centroidExtent.Z ? 1 : 2);
+		if (count <= BVHMaxLeafTriangles || centroidExtent[axis] <= UE_KINDA_SMALL_NUMBER || pending.Num() >= BVHMaxDepth)
+		{
+			node.FirstTriangleOrSecondChild = entry.Begin;
+			node.Count = count;
+			continue;
+		}
+
+		// Median along the longest axis, both halves always get something so it can't go on forever
+		TArrayView<int32>(order.GetData() + entry.Begin, count).Sort([&centroids, axis](int32 aLhs, int32 aRhs) { return centroids[aLhs][axis] < centroids[aRhs][axis]; });
+		const int32 middle = entry.Begin + (count / 2);
+
+		node.Count = 0;
+		pending.Add({ middle, entry.End, nodeIndex });
+		pending.Add({ entry.Begin, middle, INDEX_NONE });
+	}
+
+	// Leaves point into a range of the build order, put the triangles in that order
+	TArray<FTriangle> orderedTriangles;
+	orderedTriangles.Reserve(Triangles.Num());
+	for (int32 index : order)
+		orderedTriangles.Add(Triangles[index]);
+	Triangles = MoveTemp(orderedTriangles);
+
+	Bounds = FBox(FVector(Nodes[0].Min), FVector(Nodes[0].Max));
+}
+
+template<typename TriangleTestType>
+bool FDeftStaticBVH::Traverse(const FVector3f& aStart, const FVector3f& aDelta, const FVector3f& aExtent, FDeftStaticHit& outHit, TriangleTestType aTest) const
+{
+	if (Nodes.Num() == 0)
+		return false;
+
+	const FVector3f invDelta(
+		FMath::Abs(aDelta.X) > UE_SMALL_NUMBER ? 1.f / aDelta.X : UE_BIG_NUMBER,
+		FMath::Abs(aDelta.Y) > UE_SMALL_NUMBER ? 1.f / aDelta.Y : UE_BIG_NUMBER,
+		FMath::Abs(aDelta.Z) > UE_SMALL_NUMBER ? 1.f / aDelta.Z : UE_BIG_NUMBER);
+
+	bool bHit = false;
+	int32 stack[BVHMaxDepth + 1];
+	int32 stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0 && outHit.Time > 0.f)
+	{
+		const int32 nodeIndex = stack[--stackSize];
+		const FNode& node = Nodes[nodeIndex];
+		if (!SegmentOverlapsBox(aStart, invDelta, node.Min - aExtent, node.Max + aExtent, outHit.Time))
+			continue;
+
+		if (node.Count > 0)
+		{
+			for (int32 i = node.FirstTriangleOrSecondChild, end = node.FirstTriangleOrSecondChild + node.Count; i < end; ++i)
+				bHit |= aTest(Triangles[i], outHit);
+			continue;
+		}
+
+		stack[stackSize++] = node.FirstTriangleOrSecondChild;
+		stack[stackSize++] = nodeIndex + 1;
+	}
+	return bHit;
+}
+
+bool FDeftStaticBVH::Raycast(const FVector& aStart, const FVector& aEnd, FDeftStaticHit& outHit) const
+{
+	outHit = FDeftStaticHit();
+
+	const FVector3f start(aStart);
+	const FVector3f delta(aEnd - aStart);
+	const bool bHit = Traverse(start, delta, FVector3f::ZeroVector, outHit, [&start, &delta](const FTriangle& aTriangle, FDeftStaticHit& ioHit)
+	{
+		float t;
+		if (!RayTriangle(start, delta, aTriangle.A, aTriangle.B, aTriangle.C, t) || t >= ioHit.Time)
+			return false;
+
+		ioHit.Time = t;
+		ioHit.Normal = FVector((delta | aTriangle.Normal) <= 0.f ? aTriangle.Normal : -aTriangle.Normal);
+		return true;
+	});
+
+	if (bHit)
+		outHit.Location = outHit.ImpactPoint = aStart + ((aEnd - aStart) * outHit.Time);
+	return bHit;
+}
+
+bool FDeftStaticBVH::SweepSphere(const FVector& aStart, const FVector& aEnd, float aRadius, FDeftStaticHit& outHit) const
+{
+	outHit = FDeftStaticHit();
+	if (aRadius <= 0.f)
+		return Raycast(aStart, aEnd, outHit);
+
+	const FVector3f start(aStart);
+	const FVector3f delta(aEnd - aStart);
+	return Traverse(start, delta, FVector3f(aRadius), outHit, [&start, &delta, aRadius](const FTriangle& aTriangle, FDeftStaticHit& ioHit)
+	{
+		FSphereContact contact;
+		if (!SweepSphereTriangle(start, delta, aRadius, aTriangle.A, aTriangle.B, aTriangle.C, aTriangle.Normal, ioHit.Time, contact) || (contact.Time >= ioHit.Time && !contact.bStartPenetrating))
+			return false;
+
+		ioHit.Time = contact.Time;
+		ioHit.Location = FVector(start + (delta * contact.Time));
+		ioHit.ImpactPoint = FVector(contact.Point);
+		ioHit.Normal = FVector(contact.Normal);
+		ioHit.bStartPenetrating = contact.bStartPenetrating;
+		return true;
+	});
+}
+
+bool FDeftStaticBVH::SweepCapsule(const FVector& aStart, const FVector& aEnd, float aRadius, float aHalfHeight, FDeftStaticHit& outHit) const
+{
+	outHit = FDeftStaticHit();
+
+	const float halfLength = aHalfHeight - aRadius;
+	if (halfLength <= UE_KINDA_SMALL_NUMBER)
+		return SweepSphere(aStart, aEnd, aRadius, outHit);
+
+	/*
+		The capsule touches a triangle when its center is within aRadius of the triangle stretched halfLength up and down, i.e. the prism between
+		the triangle moved up and moved down. So it's a sphere sweep against the prism: the two caps and the two triangles of each side
+	*/
+	const FVector3f start(aStart);
+	const FVector3f delta(aEnd - aStart);
+	const FVector3f up(0.f, 0.f, halfLength);
+	return Traverse(start, delta, FVector3f(aRadius, aRadius, aHalfHeight), outHit, [&start, &delta, &up, aRadius, halfLength](const FTriangle& aTriangle, FDeftStaticHit& ioHit)
+	{
+		// Center inside the prism, the capsule's axis is through the triangle
+		float axisT;
+		if (RayTriangle(start - up, up * 2.f, aTriangle.A, aTriangle.B, aTriangle.C, axisT))
+		{
+			ioHit.Time = 0.f;
+			ioHit.Location = FVector(start);
+			ioHit.ImpactPoint = FVector(start - up + (up * (2.f * axisT)));
+			ioHit.Normal = FVector((aTriangle.Normal.Z >= 0.f) == (axisT <= 0.5f) ? aTriangle.Normal : -aTriangle.Normal);
+			ioHit.bStartPenetrating = true;
+			return true;
+		}
+
+		const FVector3f corners[3] = { aTriangle.A, aTriangle.B, aTriangle.C };
+		FVector3f prism[8][3] = {
+			{ aTriangle.A + up, aTriangle.B + up, aTriangle.C + up },
+			{ aTriangle.A - up, aTriangle.B - up, aTriangle.C - up },
+		};
+		for (int32 i = 0; i < 3; ++i)
+		{
+			const FVector3f& edgeStart = corners[i];
+			const FVector3f& edgeEnd = corners[(i + 1) % 3];
+			prism[2 + (i * 2)][0] = edgeStart + up;
+			prism[2 + (i * 2)][1] = edgeEnd + up;
+			prism[2 + (i * 2)][2] = edgeEnd - up;
+			prism[3 + (i * 2)][0] = edgeStart + up;
+			prism[3 + (i * 2)][1] = edgeEnd - up;
+			prism[3 + (i * 2)][2] = edgeStart - up;
+		}
+
+		bool bHit = false;
+		int32 bestFace = 0;
+		FSphereContact best;
+		best.Time = ioHit.Time;
+		for (int32 face = 0; face < 8; ++face)
+		{
+			const FVector3f normal = face < 2 ? aTriangle.Normal : FVector3f::CrossProduct(prism[face][1] - prism[face][0], prism[face][2] - prism[face][0]).GetSafeNormal();
+			FSphereContact contact;
+			if (SweepSphereTriangle(start, delta, aRadius, prism[face][0], prism[face][1], prism[face][2], normal, best.Time, contact) && (contact.Time < best.Time || contact.bStartPenetrating))
+			{
+				best = contact;
+				bestFace = face;
+				bHit = true;
+				if (contact.bStartPenetrating)
+					break;
+			}
+		}
+		if (!bHit)
+			return false;
+
+		// Back from the prism to the triangle, every point on the prism is a point on the triangle moved straight up or down
+		FVector3f impact;
+		if (bestFace < 2)
+		{
+			impact = bestFace == 0 ? best.Point - up : best.Point + up;
+		}
+		else
+		{
+			const int32 edgeIndex = (bestFace - 2) / 2;
+			const FVector3f& edgeStart = corners[edgeIndex];
+			const FVector3f edge = corners[(edgeIndex + 1) % 3] - edgeStart;
+			const float edgeSizeSq2D = (edge.X * edge.X) + (edge.Y * edge.Y);
+			const float along = edgeSizeSq2D > UE_SMALL_NUMBER
+				? (((best.Point.X - edgeStart.X) * edge.X) + ((best.Point.Y - edgeStart.Y) * edge.Y)) / edgeSizeSq2D
+				: ((best.Point.Z - edgeStart.Z) / edge.Z);
+			impact = edgeStart + (edge * FMath::Clamp(along, 0.f, 1.f));
+		}
+
+		ioHit.Time = best.Time;
+		ioHit.Location = FVector(start + (delta * best.Time));
+		ioHit.ImpactPoint = FVector(impact);
+		ioHit.Normal = FVector(best.Normal);
+		ioHit.bStartPenetrating = best.bStartPenetrating;
+		return true;
+	});
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// What a FDeftStaticBVH query ran into
+struct FDeftStaticHit
+{
+	FDeftStaticHit()
+		: Time(1.f)
+		, Location(FVector::ZeroVector)
+		, ImpactPoint(FVector::ZeroVector)
+		, Normal(FVector::ZeroVector)
+		, bStartPenetrating(false)
+	{}
+
+	float Time;				// 0 at the start of the query, 1 at the end
+	FVector Location;		// where the shape (its center) stopped
+	FVector ImpactPoint;	// where it touched the geometry
+	FVector Normal;			// away from the geometry, towards the shape
+	bool bStartPenetrating;	// already overlapping at the start, Normal is the quickest way out
+};
+
+/**
+ * Bounding volume hierarchy over a fixed set of triangles, built once and never changed after.
+ * Queries only read it so any number of threads can run them at once, without the physics scene or any UObject involved.
+ * Triangles are two sided, whatever side a query comes from it hits the same as it would from the other
+ */
+class DEFT_API FDeftStaticBVH
+{
+public:
+	FDeftStaticBVH();
+
+	// Filling it up, nothing can be queried until Build
+	void AddTriangle(const FVector& aA, const FVector& aB, const FVector& aC);
+	void AddMesh(const FTransform& aTransform, const TArray<FVector>& aVertices, const TArray<int32>& aIndices);
+	void AddBox(const FTransform& aTransform, const FVector& aExtent);
+	// Tessellated, the facets sit at most ~8% of the radius inside the real surface
+	void AddCapsule(const FTransform& aTransform, float aRadius, float aHalfLength);
+	void Build();
+
+	bool IsEmpty() const { return Triangles.Num() == 0; }
+	int32 GetNumTriangles() const { return Triangles.Num(); }
+	const FBox& GetBounds() const { return Bounds; }
+	SIZE_T GetAllocatedSize() const { return Triangles.GetAllocatedSize() + Nodes.GetAllocatedSize(); }
+
+	// Closest hit along each, false if nothing was hit
+	bool Raycast(const FVector& aStart, const FVector& aEnd, FDeftStaticHit& outHit) const;
+	bool SweepSphere(const FVector& aStart, const FVector& aEnd, float aRadius, FDeftStaticHit& outHit) const;
+	// The capsule is always upright, same as the character's
+	bool SweepCapsule(const FVector& aStart, const FVector& aEnd, float aRadius, float aHalfHeight, FDeftStaticHit& outHit) const;
+
+private:
+	struct FTriangle
+	{
+		FVector3f A;
+		FVector3f B;
+		FVector3f C;
+		FVector3f Normal;
+	};
+
+	// Children of an inner node are the node right after it and SecondChild, a leaf is Count triangles from FirstTriangle
+	struct FNode
+	{
+		FVector3f Min;
+		int32 FirstTriangleOrSecondChild;
+		FVector3f Max;
+		int32 Count;	// 0 for inner nodes
+	};
+
+	// Visits every leaf triangle whose node bounds, grown by aExtent, the segment passes through before outHit.Time. aTest narrows outHit itself
+	template<typename TriangleTestType>
+	bool Traverse(const FVector3f& aStart, const FVector3f& aDelta, const FVector3f& aExtent, FDeftStaticHit& outHit, TriangleTestType aTest) const;
+
+	TArray<FTriangle> Triangles;
+	TArray<FNode> Nodes;
+	FBox Bounds;
+};
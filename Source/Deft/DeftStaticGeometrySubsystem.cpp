@@ -0,0 +1,315 @@
+#include "DeftStaticGeometrySubsystem.h"
+
+#include "Chaos/TriangleMeshImplicitObject.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/ModelComponent.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "PhysicsEngine/BodySetup.h"
+
+#if !UE_BUILD_SHIPPING
+#include "Async/ParallelFor.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#endif //!UE_BUILD_SHIPPING
+
+namespace
+{
+	// What a pawn would walk on or into and what can never move out of the way
+	bool IsStaticTraversalCollision(const UPrimitiveComponent& aComponent)
+	{
+		return aComponent.Mobility == EComponentMobility::Static
+			&& aComponent.IsQueryCollisionEnabled()
+			&& aComponent.GetCollisionResponseToChannel(ECC_Pawn) == ECR_Block
+			&& aComponent.GetBodySetup() != nullptr;
+	}
+
+	// The same shapes the physics scene would make out of aBodySetup, placed at aTransform
+	void AddBodySetup(FDeftStaticBVH& aBVH, const UBodySetup& aBodySetup, const FTransform& aTransform)
+	{
+		if (aBodySetup.GetCollisionTraceFlag() == CTF_UseComplexAsSimple)
+		{
+			for (const TSharedPtr<Chaos::FTriangleMeshImplicitObject, ESPMode::ThreadSafe>& triMesh : aBodySetup.ChaosTriMeshes)
+			{
+				if (!triMesh.IsValid())
+					continue;
+
+				const auto& particles = triMesh->Particles();
+				auto addTriangles = [&aBVH, &aTransform, &particles](const auto& aIndexBuffer)
+				{
+					for (const auto& indices : aIndexBuffer)
+						aBVH.AddTriangle(aTransform.TransformPosition(FVector(particles.X(indices[0]))), aTransform.TransformPosition(FVector(particles.X(indices[1]))), aTransform.TransformPosition(FVector(particles.X(indices[2]))));
+				};
+
+				const Chaos::FTrimeshIndexBuffer& elements = triMesh->Elements();
+				if (elements.RequiresLargeIndices())
+					addTriangles(elements.GetLargeIndexBuffer());
+				else
+					addTriangles(elements.GetSmallIndexBuffer());
+			}
+			return;
+		}
+
+		const FKAggregateGeom& aggGeom = aBodySetup.AggGeom;
+		for (const FKBoxElem& box : aggGeom.BoxElems)
+			aBVH.AddBox(box.GetTransform() * aTransform, FVector(box.X, box.Y, box.Z) * 0.5f);
+
+		for (const FKSphereElem& sphere : aggGeom.SphereElems)
+			aBVH.AddCapsule(FTransform(sphere.Center) * aTransform, sphere.Radius, 0.f);
+
+		for (const FKSphylElem& sphyl : aggGeom.SphylElems)
+			aBVH.AddCapsule(sphyl.GetTransform() * aTransform, sphyl.Radius, sphyl.Length * 0.5f);
+
+		for (const FKConvexElem& convex : aggGeom.ConvexElems)
+		{
+			// Hulls cooked without their triangles are rare enough that their bounds will do
+			if (convex.IndexData.Num() > 0)
+				aBVH.AddMesh(convex.GetTransform() * aTransform, convex.VertexData, convex.IndexData);
+			else
+				aBVH.AddBox(FTransform(convex.ElemBox.GetCenter()) * convex.GetTransform() * aTransform, convex.ElemBox.GetExtent());
+		}
+	}
+
+	void AddComponent(FDeftStaticBVH& aBVH, const UPrimitiveComponent& aComponent)
+	{
+		if (!IsStaticTraversalCollision(aComponent))
+			return;
+
+		// Every instance has its own body but they all share the mesh's body setup
+		const UBodySetup& bodySetup = *aComponent.GetBodySetup();
+		if (const UInstancedStaticMeshComponent* instancedComponent = Cast<UInstancedStaticMeshComponent>(&aComponent))
+		{
+			FTransform instanceTransform;
+			for (int32 i = 0; i < instancedComponent->GetInstanceCount(); ++i)
+			{
+				if (instancedComponent->GetInstanceTransform(i, instanceTransform, true))
+					AddBodySetup(aBVH, bodySetup, instanceTransform);
+			}
+			return;
+		}
+
+		AddBodySetup(aBVH, bodySetup, aComponent.GetComponentTransform());
+	}
+
+	template<typename QueryType>
+	bool QueryLevels(const TArray<TSharedRef<const FDeftStaticBVH, ESPMode::ThreadSafe>>& aLevels, FDeftStaticHit& outHit, QueryType aQuery)
+	{
+		outHit = FDeftStaticHit();
+
+		bool bHit = false;
+		FDeftStaticHit levelHit;
+		for (const TSharedRef<const FDeftStaticBVH, ESPMode::ThreadSafe>& level : aLevels)
+		{
+			if (aQuery(*level, levelHit) && (!bHit || levelHit.Time < outHit.Time))
+			{
+				outHit = levelHit;
+				bHit = true;
+			}
+		}
+		return bHit;
+	}
+}
+
+bool FDeftStaticGeometrySnapshot::Raycast(const FVector& aStart, const FVector& aEnd, FDeftStaticHit& outHit) const
+{
+	return QueryLevels(Levels, outHit, [&](const FDeftStaticBVH& aBVH, FDeftStaticHit& outLevelHit) { return aBVH.Raycast(aStart, aEnd, outLevelHit); });
+}
+
+bool FDeftStaticGeometrySnapshot::SweepSphere(const FVector& aStart, const FVector& aEnd, float aRadius, FDeftStaticHit& outHit) const
+{
+	return QueryLevels(Levels, outHit, [&](const FDeftStaticBVH& aBVH, FDeftStaticHit& outLevelHit) { return aBVH.SweepSphere(aStart, aEnd, aRadius, outLevelHit); });
+}
+
+bool FDeftStaticGeometrySnapshot::SweepCapsule(const FVector& aStart, const FVector& aEnd, float aRadius, float aHalfHeight, FDeftStaticHit& outHit) const
+{
+	return QueryLevels(Levels, outHit, [&](const FDeftStaticBVH& aBVH, FDeftStaticHit& outLevelHit) { return aBVH.SweepCapsule(aStart, aEnd, aRadius, aHalfHeight, outLevelHit); });
+}
+
+UDeftStaticGeometrySubsystem::UDeftStaticGeometrySubsystem()
+	: LevelBVHs()
+	, Snapshot(MakeShared<FDeftStaticGeometrySnapshot, ESPMode::ThreadSafe>())
+	, LevelAddedHandle()
+	, LevelRemovedHandle()
+{
+}
+
+void UDeftStaticGeometrySubsystem::Initialize(FSubsystemCollectionBase& aCollection)
+{
+	Super::Initialize(aCollection);
+
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UDeftStaticGeometrySubsystem::OnLevelAddedToWorld);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UDeftStaticGeometrySubsystem::OnLevelRemovedFromWorld);
+}
+
+void UDeftStaticGeometrySubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+
+	// Anyone still holding a snapshot keeps what they have, we just stop handing it out
+	LevelBVHs.Reset();
+	RefreshSnapshot();
+
+	Super::Deinitialize();
+}
+
+void UDeftStaticGeometrySubsystem::OnWorldBeginPlay(UWorld& aWorld)
+{
+	Super::OnWorldBeginPlay(aWorld);
+
+	// Whatever is loaded already, from here on streaming tells us
+	for (ULevel* level : aWorld.GetLevels())
+	{
+		if (level && level->bIsVisible)
+			AddLevel(level);
+	}
+	RefreshSnapshot();
+}
+
+bool UDeftStaticGeometrySubsystem::DoesSupportWorldType(const EWorldType::Type aWorldType) const
+{
+	return aWorldType == EWorldType::Game || aWorldType == EWorldType::PIE;
+}
+
+TSharedRef<FDeftStaticBVH, ESPMode::ThreadSafe> UDeftStaticGeometrySubsystem::BuildLevelBVH(const ULevel& aLevel)
+{
+	const double startSeconds = FPlatformTime::Seconds();
+
+	TSharedRef<FDeftStaticBVH, ESPMode::ThreadSafe> bvh = MakeShared<FDeftStaticBVH, ESPMode::ThreadSafe>();
+	for (const AActor* actor : aLevel.Actors)
+	{
+		if (!actor)
+			continue;
+
+		actor->ForEachComponent<UPrimitiveComponent>(false, [&bvh](const UPrimitiveComponent* aComponent) { AddComponent(*bvh, *aComponent); });
+	}
+
+	// BSP isn't owned by any actor
+	for (const UModelComponent* modelComponent : aLevel.ModelComponents)
+	{
+		if (modelComponent)
+			AddComponent(*bvh, *modelComponent);
+	}
+
+	bvh->Build();
+
+	UE_LOG(LogTemp, Display, TEXT("Static geometry BVH for %s: %d triangles, %.1fKB, built in %.2fms"),
+		*aLevel.GetOuter()->GetName(), bvh->GetNumTriangles(), bvh->GetAllocatedSize() / 1024.0, (FPlatformTime::Seconds() - startSeconds) * 1000.0);
+	return bvh;
+}
+
+void UDeftStaticGeometrySubsystem::OnLevelAddedToWorld(ULevel* aLevel, UWorld* aWorld)
+{
+	if (aWorld != GetWorld() || !aLevel)
+		return;
+
+	AddLevel(aLevel);
+	RefreshSnapshot();
+}
+
+void UDeftStaticGeometrySubsystem::OnLevelRemovedFromWorld(ULevel* aLevel, UWorld* aWorld)
+{
+	if (aWorld != GetWorld())
+		return;
+
+	// No level means they're all going
+	if (aLevel)
+		LevelBVHs.Remove(FObjectKey(aLevel));
+	else
+		LevelBVHs.Reset();
+	RefreshSnapshot();
+}
+
+void UDeftStaticGeometrySubsystem::AddLevel(ULevel* aLevel)
+{
+	// Already built when play began
+	if (LevelBVHs.Contains(FObjectKey(aLevel)))
+		return;
+
+	TSharedRef<FDeftStaticBVH, ESPMode::ThreadSafe> bvh = BuildLevelBVH(*aLevel);
+	if (!bvh->IsEmpty())
+		LevelBVHs.Add(FObjectKey(aLevel), bvh);
+}
+
+void UDeftStaticGeometrySubsystem::RefreshSnapshot()
+{
+	TSharedRef<FDeftStaticGeometrySnapshot, ESPMode::ThreadSafe> snapshot = MakeShared<FDeftStaticGeometrySnapshot, ESPMode::ThreadSafe>();
+	LevelBVHs.GenerateValueArray(snapshot->Levels);
+	Snapshot = snapshot;
+}
+
+#if !UE_BUILD_SHIPPING
+// Random capsule sweeps around the player through the snapshot (spread over worker threads) and through the physics scene, e.g. "deft.bench.staticGeometry 10000"
+static FAutoConsoleCommandWithWorldAndArgs CCmd_BenchStaticGeometry(
+	TEXT("deft.bench.staticGeometry"),
+	TEXT("Compare UDeftStaticGeometrySubsystem capsule sweeps against the physics scene. Optional args: number of sweeps, sweep length"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& aArgs, UWorld* aWorld)
+	{
+		const UDeftStaticGeometrySubsystem* subsystem = aWorld ? aWorld->GetSubsystem<UDeftStaticGeometrySubsystem>() : nullptr;
+		const APlayerController* playerController = aWorld ? aWorld->GetFirstPlayerController() : nullptr;
+		const APawn* pawn = playerController ? playerController->GetPawn() : nullptr;
+		if (!subsystem || !pawn)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("deft.bench.staticGeometry needs a game world with a player pawn"));
+			return;
+		}
+
+		const int32 numSweeps = aArgs.Num() > 0 ? FMath::Max(FCString::Atoi(*aArgs[0]), 1) : 10000;
+		const float sweepLength = aArgs.Num() > 1 ? FCString::Atof(*aArgs[1]) : 500.f;
+		const float radius = 34.f;
+		const float halfHeight = 88.f;
+
+		TArray<FVector> starts;
+		TArray<FVector> ends;
+		starts.SetNumUninitialized(numSweeps);
+		ends.SetNumUninitialized(numSweeps);
+		FRandomStream random(numSweeps);
+		for (int32 i = 0; i < numSweeps; ++i)
+		{
+			starts[i] = pawn->GetActorLocation() + (random.GetUnitVector() * random.FRandRange(0.f, 1000.f));
+			ends[i] = starts[i] + (random.GetUnitVector() * sweepLength);
+		}
+
+		TArray<FDeftStaticHit> snapshotHits;
+		TArray<bool> snapshotBlocked;
+		snapshotHits.SetNum(numSweeps);
+		snapshotBlocked.SetNumZeroed(numSweeps);
+		const TSharedRef<const FDeftStaticGeometrySnapshot, ESPMode::ThreadSafe> snapshot = subsystem->GetSnapshot();
+		double startSeconds = FPlatformTime::Seconds();
+		ParallelFor(numSweeps, [&](int32 aIndex)
+		{
+			snapshotBlocked[aIndex] = snapshot->SweepCapsule(starts[aIndex], ends[aIndex], radius, halfHeight, snapshotHits[aIndex]);
+		});
+		const double snapshotSeconds = FPlatformTime::Seconds() - startSeconds;
+
+		TArray<FHitResult> sceneHits;
+		TArray<bool> sceneBlocked;
+		sceneHits.SetNum(numSweeps);
+		sceneBlocked.SetNumZeroed(numSweeps);
+		const FCollisionShape capsule = FCollisionShape::MakeCapsule(radius, halfHeight);
+		const FCollisionQueryParams queryParams(SCENE_QUERY_STAT(DeftBenchStaticGeometry), false, pawn);
+		startSeconds = FPlatformTime::Seconds();
+		for (int32 i = 0; i < numSweeps; ++i)
+			sceneBlocked[i] = aWorld->SweepSingleByObjectType(sceneHits[i], starts[i], ends[i], FQuat::Identity, FCollisionObjectQueryParams(ECC_WorldStatic), capsule, queryParams);
+		const double sceneSeconds = FPlatformTime::Seconds() - startSeconds;
+
+		// The scene also has whatever static objects don't block pawns, so only count the ones where both agree there's something
+		int32 numAgree = 0;
+		int32 numBothHit = 0;
+		float maxTimeError = 0.f;
+		for (int32 i = 0; i < numSweeps; ++i)
+		{
+			numAgree += snapshotBlocked[i] == sceneBlocked[i] ? 1 : 0;
+			if (snapshotBlocked[i] && sceneBlocked[i] && !snapshotHits[i].bStartPenetrating && !sceneHits[i].bStartPenetrating)
+			{
+				maxTimeError = FMath::Max(maxTimeError, FMath::Abs(snapshotHits[i].Time - sceneHits[i].Time) * sweepLength);
+				++numBothHit;
+			}
+		}
+
+		UE_LOG(LogTemp, Display, TEXT("Snapshot %.3fms (%d levels, parallel), physics scene %.3fms, %d/%d agree on hitting, max distance error %.2f over %d hits"),
+			snapshotSeconds * 1000.0, snapshot->Levels.Num(), sceneSeconds * 1000.0, numAgree, numSweeps, maxTimeError, numBothHit);
+	}));
+#endif //!UE_BUILD_SHIPPING
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DeftStaticBVH.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DeftStaticGeometrySubsystem.generated.h"
+
+/**
+ * The static collision of every loaded level at one point in time. Never changes once it's made, levels streaming in or out make a new one,
+ * so whoever holds on to it can keep querying it from any thread for as long as they like
+ */
+struct DEFT_API FDeftStaticGeometrySnapshot
+{
+	// Closest hit across every level, see FDeftStaticBVH
+	bool Raycast(const FVector& aStart, const FVector& aEnd, FDeftStaticHit& outHit) const;
+	bool SweepSphere(const FVector& aStart, const FVector& aEnd, float aRadius, FDeftStaticHit& outHit) const;
+	bool SweepCapsule(const FVector& aStart, const FVector& aEnd, float aRadius, float aHalfHeight, FDeftStaticHit& outHit) const;
+
+	TArray<TSharedRef<const FDeftStaticBVH, ESPMode::ThreadSafe>> Levels;
+};
+
+/**
+ * Keeps a BVH of each loaded level's static collision (whatever blocks pawns and never moves), built as the level is added to the world.
+ * The BVHs only have triangles in them, no physics scene or UObjects, so prediction and probing work can run on task threads with GetSnapshot
+ */
+UCLASS()
+class DEFT_API UDeftStaticGeometrySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UDeftStaticGeometrySubsystem();
+
+	void Initialize(FSubsystemCollectionBase& aCollection) override;
+	void Deinitialize() override;
+	void OnWorldBeginPlay(UWorld& aWorld) override;
+
+	// Game thread only, what it returns can go anywhere
+	TSharedRef<const FDeftStaticGeometrySnapshot, ESPMode::ThreadSafe> GetSnapshot() const { return Snapshot; }
+
+	static TSharedRef<FDeftStaticBVH, ESPMode::ThreadSafe> BuildLevelBVH(const ULevel& aLevel);
+
+protected:
+	// Override Reason: Only game worlds query traversal
+	bool DoesSupportWorldType(const EWorldType::Type aWorldType) const override;
+
+private:
+	void OnLevelAddedToWorld(ULevel* aLevel, UWorld* aWorld);
+	void OnLevelRemovedFromWorld(ULevel* aLevel, UWorld* aWorld);
+	void AddLevel(ULevel* aLevel);
+	void RefreshSnapshot();
+
+	TMap<FObjectKey, TSharedRef<const FDeftStaticBVH, ESPMode::ThreadSafe>> LevelBVHs;
+	TSharedRef<const FDeftStaticGeometrySnapshot, ESPMode::ThreadSafe> Snapshot;
+
+	FDelegateHandle LevelAddedHandle;
+	FDelegateHandle LevelRemovedHandle;
+};
@@ -0,0 +1,205 @@
+#include "DeftVerletRope.h"
+
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+
+namespace
+{
+	const float RopeDamping = 0.98f;
+}
+
+FDeftVerletRope::FDeftVerletRope()
+	: NumParticles(0)
+	, NumPadded(0)
+	, SegmentLength(0.f)
+	, X()
+	, Y()
+	, Z()
+	, PrevX()
+	, PrevY()
+	, PrevZ()
+	, InvMasses()
+	, GravityScales()
+	, Dampings()
+	, TetherLengths()
+	, SegmentWeights()
+	, CorrectionsX()
+	, CorrectionsY()
+	, CorrectionsZ()
+{
+}
+
+void FDeftVerletRope::Init(const FVector& aAnchor, const FVector& aEnd, int32 aNumSegments, float aEndInvMass)
+{
+	const int32 numSegments = FMath::Clamp(aNumSegments, 1, MaxSegments);
+	NumParticles = numSegments + 1;
+	NumPadded = Align(NumParticles, 4);
+	SegmentLength = FVector::Dist(aAnchor, aEnd) / numSegments;
+
+	// Room for reading one past the last block, everything past NumParticles stays 0
+	const int32 arraySize = NumPadded + 4;
+	for (TArray<float>* values : { &X, &Y, &Z, &PrevX, &PrevY, &PrevZ, &InvMasses, &GravityScales, &Dampings, &TetherLengths, &SegmentWeights, &CorrectionsX, &CorrectionsY, &CorrectionsZ })
+	{
+		values->Reset();
+		values->SetNumZeroed(arraySize);
+	}
+
+	const int32 last = NumParticles - 1;
+	for (int32 i = 0; i < arraySize; ++i)
+	{
+		const bool bIsParticle = i < NumParticles;
+		const FVector location = bIsParticle ? FMath::Lerp(aAnchor, aEnd, (float)i / numSegments) : FVector::ZeroVector;
+		X[i] = PrevX[i] = location.X;
+		Y[i] = PrevY[i] = location.Y;
+		Z[i] = PrevZ[i] = location.Z;
+
+		InvMasses[i] = !bIsParticle || i == 0 ? 0.f : (i == last ? aEndInvMass : 1.f);
+		GravityScales[i] = !bIsParticle || i == 0 ? 0.f : 1.f;
+		Dampings[i] = !bIsParticle || i == last ? 1.f : RopeDamping;
+		TetherLengths[i] = bIsParticle ? SegmentLength * i : UE_BIG_NUMBER;
+	}
+
+	for (int32 i = 0; i < numSegments; ++i)
+	{
+		const float invMassSum = InvMasses[i] + InvMasses[i + 1];
+		SegmentWeights[i] = invMassSum > 0.f ? 1.f / invMassSum : 0.f;
+	}
+}
+
+void FDeftVerletRope::Reset()
+{
+	*this = FDeftVerletRope();
+}
+
+void FDeftVerletRope::SetEnd(const FVector& aLocation, const FVector& aVelocity, float aDeltaTime)
+{
+	const int32 last = NumParticles - 1;
+	const FVector prevLocation = aLocation - (aVelocity * aDeltaTime);
+	X[last] = aLocation.X;
+	Y[last] = aLocation.Y;
+	Z[last] = aLocation.Z;
+	PrevX[last] = prevLocation.X;
+	PrevY[last] = prevLocation.Y;
+	PrevZ[last] = prevLocation.Z;
+}
+
+void FDeftVerletRope::Simulate(float aDeltaTime, float aGravityZ, int32 aIterations)
+{
+	checkSlow(IsValid());
+
+	// x' = x + (x - prev) * damping + g * dt^2
+	const VectorRegister4Float gravityStep = VectorSetFloat1(aGravityZ * aDeltaTime * aDeltaTime);
+	for (int32 i = 0; i < NumPadded; i += 4)
+	{
+		const VectorRegister4Float dampings = VectorLoad(Dampings.GetData() + i);
+		const VectorRegister4Float xs = VectorLoad(X.GetData() + i);
+		const VectorRegister4Float ys = VectorLoad(Y.GetData() + i);
+		const VectorRegister4Float zs = VectorLoad(Z.GetData() + i);
+
+		VectorStore(VectorMultiplyAdd(VectorSubtract(xs, VectorLoad(PrevX.GetData() + i)), dampings, xs), X.GetData() + i);
+		VectorStore(VectorMultiplyAdd(VectorSubtract(ys, VectorLoad(PrevY.GetData() + i)), dampings, ys), Y.GetData() + i);
+		VectorStore(VectorMultiplyAdd(VectorSubtract(zs, VectorLoad(PrevZ.GetData() + i)), dampings, VectorMultiplyAdd(VectorLoad(GravityScales.GetData() + i), gravityStep, zs)), Z.GetData() + i);
+		VectorStore(xs, PrevX.GetData() + i);
+		VectorStore(ys, PrevY.GetData() + i);
+		VectorStore(zs, PrevZ.GetData() + i);
+	}
+
+	for (int32 iteration = 0; iteration < aIterations; ++iteration)
+	{
+		SolveSegments();
+		SolveTether();
+	}
+}
+
+void FDeftVerletRope::SolveSegments()
+{
+	const VectorRegister4Float segmentLength = VectorSetFloat1(SegmentLength);
+	const VectorRegister4Float smallNumber = VectorSetFloat1(UE_SMALL_NUMBER);
+
+	// Every segment against the positions from before any of them moved, a rope only ever pulls so slack segments do nothing
+	for (int32 i = 0; i < NumPadded; i += 4)
+	{
+		const VectorRegister4Float toXs = VectorSubtract(VectorLoad(X.GetData() + i + 1), VectorLoad(X.GetData() + i));
+		const VectorRegister4Float toYs = VectorSubtract(VectorLoad(Y.GetData() + i + 1), VectorLoad(Y.GetData() + i));
+		const VectorRegister4Float toZs = VectorSubtract(VectorLoad(Z.GetData() + i + 1), VectorLoad(Z.GetData() + i));
+
+		const VectorRegister4Float lengths = VectorMax(VectorSqrt(VectorMultiplyAdd(toZs, toZs, VectorMultiplyAdd(toYs, toYs, VectorMultiply(toXs, toXs)))), smallNumber);
+		const VectorRegister4Float stretches = VectorMax(VectorSubtract(lengths, segmentLength), VectorZeroFloat());
+		const VectorRegister4Float scales = VectorMultiply(VectorDivide(stretches, lengths), VectorLoad(SegmentWeights.GetData() + i));
+
+		VectorStore(VectorMultiply(toXs, scales), CorrectionsX.GetData() + i + 1);
+		VectorStore(VectorMultiply(toYs, scales), CorrectionsY.GetData() + i + 1);
+		VectorStore(VectorMultiply(toZs, scales), CorrectionsZ.GetData() + i + 1);
+	}
+
+	// Particle j is the start of segment j (pulled forward) and the end of segment j - 1 (pulled back)
+	for (int32 j = 0; j < NumPadded; j += 4)
+	{
+		const VectorRegister4Float invMasses = VectorLoad(InvMasses.GetData() + j);
+		VectorStore(VectorMultiplyAdd(VectorSubtract(VectorLoad(CorrectionsX.GetData() + j + 1), VectorLoad(CorrectionsX.GetData() + j)), invMasses, VectorLoad(X.GetData() + j)), X.GetData() + j);
+		VectorStore(VectorMultiplyAdd(VectorSubtract(VectorLoad(CorrectionsY.GetData() + j + 1), VectorLoad(CorrectionsY.GetData() + j)), invMasses, VectorLoad(Y.GetData() + j)), Y.GetData() + j);
+		VectorStore(VectorMultiplyAdd(VectorSubtract(VectorLoad(CorrectionsZ.GetData() + j + 1), VectorLoad(CorrectionsZ.GetData() + j)), invMasses, VectorLoad(Z.GetData() + j)), Z.GetData() + j);
+	}
+}
+
+void FDeftVerletRope::SolveTether()
+{
+	// Nothing can be further from the anchor than the rope between them is long, this is what actually holds the end up with few iterations
+	const VectorRegister4Float anchorX = VectorSetFloat1(X[0]);
+	const VectorRegister4Float anchorY = VectorSetFloat1(Y[0]);
+	const VectorRegister4Float anchorZ = VectorSetFloat1(Z[0]);
+	const VectorRegister4Float smallNumber = VectorSetFloat1(UE_SMALL_NUMBER);
+
+	for (int32 j = 0; j < NumPadded; j += 4)
+	{
+		const VectorRegister4Float toXs = VectorSubtract(VectorLoad(X.GetData() + j), anchorX);
+		const VectorRegister4Float toYs = VectorSubtract(VectorLoad(Y.GetData() + j), anchorY);
+		const VectorRegister4Float toZs = VectorSubtract(VectorLoad(Z.GetData() + j), anchorZ);
+
+		const VectorRegister4Float lengths = VectorMax(VectorSqrt(VectorMultiplyAdd(toZs, toZs, VectorMultiplyAdd(toYs, toYs, VectorMultiply(toXs, toXs)))), smallNumber);
+		const VectorRegister4Float scales = VectorMin(VectorDivide(VectorLoad(TetherLengths.GetData() + j), lengths), VectorOneFloat());
+
+		VectorStore(VectorMultiplyAdd(toXs, scales, anchorX), X.GetData() + j);
+		VectorStore(VectorMultiplyAdd(toYs, scales, anchorY), Y.GetData() + j);
+		VectorStore(VectorMultiplyAdd(toZs, scales, anchorZ), Z.GetData() + j);
+	}
+}
+
+void FDeftVerletRope::Collide(const UWorld& aWorld, const FCollisionQueryParams& aQueryParams, const FCollisionObjectQueryParams& aObjectParams, float aRadius)
+{
+	checkSlow(IsValid());
+
+	// The anchor is stuck to whatever it hit and whoever is on the end handles their own collision
+	const int32 last = NumParticles - 1;
+	if (last < 2)
+		return;
+
+	FBox bounds(ForceInit);
+	for (int32 i = 1; i < last; ++i)
+		bounds += GetParticle(i);
+	bounds = bounds.ExpandBy(aRadius);
+
+	TArray<FOverlapResult> overlaps;
+	if (!aWorld.OverlapMultiByObjectType(overlaps, bounds.GetCenter(), FQuat::Identity, aObjectParams, FCollisionShape::MakeBox(bounds.GetExtent()), aQueryParams))
+		return;
+
+	const FCollisionShape particleShape = FCollisionShape::MakeSphere(aRadius);
+	for (const FOverlapResult& overlap : overlaps)
+	{
+		UPrimitiveComponent* component = overlap.GetComponent();
+		if (!component)
+			continue;
+
+		for (int32 i = 1; i < last; ++i)
+		{
+			FMTDResult mtd;
+			if (!component->ComputePenetration(mtd, particleShape, GetParticle(i), FQuat::Identity))
+				continue;
+
+			const FVector push = mtd.Direction * mtd.Distance;
+			X[i] += push.X;
+			Y[i] += push.Y;
+			Z[i] += push.Z;
+		}
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CollisionQueryParams.h"
+
+/**
+ * Rope of equal segments between a fixed anchor and a driven end (i.e. whoever is swinging on it), simulated with verlet integration.
+ * Particles are stored per axis and every pass goes over 4 of them at a time: segment constraints are solved all at once (Jacobi)
+ * instead of one after the other so they vectorize, and a tether to the anchor keeps the rope from stretching however few iterations it gets
+ */
+struct DEFT_API FDeftVerletRope
+{
+	FDeftVerletRope();
+
+	static constexpr int32 MaxSegments = 64;
+
+	// Straight rope from aAnchor to aEnd, aEndInvMass is how easily the rope drags the end around compared to one of its own particles (1)
+	void Init(const FVector& aAnchor, const FVector& aEnd, int32 aNumSegments, float aEndInvMass);
+	void Reset();
+	bool IsValid() const { return NumParticles >= 2; }
+
+	// The end goes wherever it's driven to, moving at aVelocity so the rope carries it along from there
+	void SetEnd(const FVector& aLocation, const FVector& aVelocity, float aDeltaTime);
+	// Always the same amount of work no matter the frame rate, aIterations constraint passes per call
+	void Simulate(float aDeltaTime, float aGravityZ, int32 aIterations);
+	// Pushes particles out of whatever they ended up inside of. One overlap around the whole rope finds what's near it, each particle is then only tested against that
+	void Collide(const class UWorld& aWorld, const FCollisionQueryParams& aQueryParams, const FCollisionObjectQueryParams& aObjectParams, float aRadius);
+
+	int32 GetNumParticles() const { return NumParticles; }
+	FVector GetParticle(int32 aIndex) const { return FVector(X[aIndex], Y[aIndex], Z[aIndex]); }
+	FVector GetAnchor() const { return GetParticle(0); }
+	FVector GetEnd() const { return GetParticle(NumParticles - 1); }
+	float GetLength() const { return SegmentLength * (NumParticles - 1); }
+
+private:
+	void SolveSegments();
+	void SolveTether();
+
+	int32 NumParticles;
+	int32 NumPadded;		// rounded up to a multiple of 4, padding particles are pinned at the origin and never constrained
+	float SegmentLength;
+
+	TArray<float> X;
+	TArray<float> Y;
+	TArray<float> Z;
+	TArray<float> PrevX;
+	TArray<float> PrevY;
+	TArray<float> PrevZ;
+	TArray<float> InvMasses;			// 0 for anything the rope doesn't get to move
+	TArray<float> GravityScales;		// 0 for the anchor, it doesn't fall
+	TArray<float> Dampings;				// fraction of velocity kept each step, 1 for the end so it keeps whatever speed it's driven at
+	TArray<float> TetherLengths;		// furthest each particle can be from the anchor, the length of rope between them
+	TArray<float> SegmentWeights;		// 1 / (invMassA + invMassB) for segment i (particles i and i+1), 0 if it isn't a segment
+
+	// Segment i's correction is stored at i + 1 so a particle finds the segments on either side of it at j and j + 1
+	TArray<float> CorrectionsX;
+	TArray<float> CorrectionsY;
+	TArray<float> CorrectionsZ;
+};
@@ -4,14 +4,22 @@
 #include "Components/SphereComponent.h"
 #include "Components/SceneComponent.h"
 #include "DeftCharacterMovementComponent.h"
+#include "DeftGrappleTargetSubsystem.h"
 #include "DeftPlayerCharacter.h"
+#include "DeftPullSubsystem.h"
+#include "DeftRootMotionSources.h"
+#include "DeftSceneQuerySubsystem.h"
 #include "GameFramework/SpringArmComponent.h"
-#include "Kismet/KismetSystemLibrary.h"
-#include "Kismet/KismetMathLibrary.h"
 #include "PredictPathComponent.h"
 
 #include "Camera/CameraComponent.h"
 
+TAutoConsoleVariable<bool> CVar_Feature_GrappleFireTimeHit(TEXT("deft.feature.grappleFireTimeHit"), true, TEXT("true=resolve what the grapple hits when it's fired and just animate the hook there, false=sweep the hook forward every frame"), ECVF_Cheat);
+
+TAutoConsoleVariable<bool> CVar_Feature_GrappleAimPreview(TEXT("deft.feature.grappleAimPreview"), true, TEXT("true=keep a preview of where the grapple would hit and the arc it'd pull us along, false=off"), ECVF_Cheat);
+
+TAutoConsoleVariable<bool> CVar_Feature_GrappleSwing(TEXT("deft.feature.grappleSwing"), false, TEXT("true=swing on a rope from whatever the grapple hits, false=get pulled to it"), ECVF_Cheat);
+
 TAutoConsoleVariable<bool> CVar_DebugGrapple(TEXT("deft.debug.grapple"), true, TEXT(""), ECVF_Cheat);
 
 // Sets default values for this component's properties
@@ -19,13 +27,51 @@ UGrappleComponent::UGrappleComponent()
 	: GrappleAnchor(nullptr)
 	, Grapple(nullptr)
 	, DeftCharacter(nullptr)
+	, DeftMovementComponent(nullptr)
+	, CameraComponent(nullptr)
+	, GrappleHookLocation(FVector::ZeroVector)
+	, GrappleHookProfileName(NAME_None)
+	, GrappleHookRadius(0.f)
 	, GrappleMaxReachPoint(FVector::ZeroVector)
 	, GrappleReachThreshold(0.f)
 	, GrappleDistanceMax(0.f)
 	, GrappleExtendSpeed(0.f)
 	, GrapplePullSpeed(0.f)
+	, GrapplePullTravelSpeed(0.f)
+	, GrapplePullObjectSpeed(0.f)
+	, GrapplePullObjectStopDistance(0.f)
+	, GrappleReachabilityTable()
+	, GrapplePullRootMotionID((uint16)ERootMotionSourceID::Invalid)
+	, GrapplePullClearDistance(0.f)
+	, GrapplePullValidationStep(0.f)
+	, GrapplePullValidationSweepsMax(0)
+	, GrappleRope()
+	, GrappleSwingRootMotionID((uint16)ERootMotionSourceID::Invalid)
+	, GrappleRopeSegments(0)
+	, GrappleRopeIterations(0)
+	, GrappleRopeEndInvMass(0.f)
+	, GrappleRopeRadius(0.f)
 	, GrappleState(GrappleStateEnum::None)
 	, bIsGrappleExtendActive(false)
+	, GrappleFireHit()
+	, GrappleFlightStart(FVector::ZeroVector)
+	, GrappleFlightEnd(FVector::ZeroVector)
+	, GrappleFireHitLocalLoc(FVector::ZeroVector)
+	, GrappleFlightTime(0.f)
+	, GrappleFlightElapsed(0.f)
+	, bHasGrappleFireHit(false)
+	, bIsGrappleFireTimeHit(false)
+	, GrappleAimTarget(nullptr)
+	, GrappleAimAssistAngle(0.f)
+	, GrappleAimAssistCandidatesMax(0)
+	, GrappleAimPreview()
+	, GrappleAimPreviewQueryID(0)
+	, GrappleAimPreviewQueryPriority(0)
+	, GrappleAimPreviewSolvedDir(FVector::ZeroVector)
+	, GrappleAimPreviewSolvedActorLoc(FVector::ZeroVector)
+	, GrappleAimPreviewAngleThreshold(0.f)
+	, GrappleAimPreviewMoveThreshold(0.f)
+	, bHasGrappleAimPreviewSolve(false)
 {
 	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
 	// off to improve performance if you don't need them.
@@ -49,30 +95,49 @@ void UGrappleComponent::BeginPlay()
 
 	DeftCharacter = Cast<ADeftPlayerCharacter>(GetOwner());
 	if (!DeftCharacter.IsValid())
+	{
 		UE_LOG(LogTemp, Error, TEXT("Failed to find DeftPlayerCharacter!"));
+		return;
+	}
 
-	GrappleDistanceMax = 1000.f;
-	GrappleExtendSpeed = 1100.f;
-	GrapplePullSpeed = 1500.f;
-	GrappleReachThreshold = 5.f;
-}
+	DeftMovementComponent = Cast<UDeftCharacterMovementComponent>(DeftCharacter->GetCharacterMovement());
+	if (!DeftMovementComponent.IsValid())
+		UE_LOG(LogTemp, Error, TEXT("Failed to find DeftCharacterMovementComponent"));
 
-void UGrappleComponent::UpdateGrappleAnchorLocation()
-{
-	if (UCameraComponent* cameraComponent = DeftCharacter->FindComponentByClass<UCameraComponent>())
+	// Rides along with the camera instead of being moved to it every frame
+	CameraComponent = DeftCharacter->GetCameraComponent();
+	if (CameraComponent.IsValid() && GrappleAnchor)
 	{
-		FHitResult empty;
-		FVector camLocation = cameraComponent->GetComponentLocation();
-		camLocation += cameraComponent->GetRightVector() * 10.f;		// move it off to the side
-		//camLocation += cameraComponent->GetForwardVector() * 20.f;	// shift it forward for viewing TODO: take out, just for debug viewing
-		GrappleAnchor->K2_SetWorldLocation(camLocation, false, empty, true);
+		GrappleAnchor->AttachToComponent(CameraComponent.Get(), FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+		GrappleAnchor->SetRelativeLocation(FVector(0.f, 10.f, 0.f));	// move it off to the side
 	}
+	else
+		UE_LOG(LogTemp, Error, TEXT("Failed to find the camera to attach the Grapple Anchor to"));
 
-	if (!bIsGrappleExtendActive)
-	{
-		FHitResult empty;
-		Grapple->K2_SetWorldLocation(GrappleAnchor->GetComponentLocation(), false, empty, true);
-	}
+	// The profile turns into "Custom" once collision is turned off so grab it first. Nothing ever needs to collide with the sphere itself,
+	// without collision moving it doesn't touch physics or overlaps
+	GrappleHookProfileName = Grapple->GetCollisionProfileName();
+	GrappleHookRadius = Grapple->GetScaledSphereRadius();
+	Grapple->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	GrappleDistanceMax = 1000.f;
+	GrappleExtendSpeed = 1100.f;
+	GrapplePullSpeed = 1500.f;
+	GrapplePullTravelSpeed = 1000.f;
+	GrapplePullObjectSpeed = 1000.f;
+	GrapplePullObjectStopDistance = 150.f;
+	GrappleRopeSegments = 16;
+	GrappleRopeIterations = 8;
+	GrappleRopeEndInvMass = 0.1f;
+	GrappleRopeRadius = 5.f;
+	GrapplePullValidationStep = 100.f;
+	GrapplePullValidationSweepsMax = 32;
+	GrappleReachThreshold = 5.f;
+	GrappleAimAssistAngle = 4.f;
+	GrappleAimAssistCandidatesMax = 3;
+	GrappleAimPreviewAngleThreshold = 0.5f;
+	GrappleAimPreviewMoveThreshold = 10.f;
+	GrappleAimPreviewQueryPriority = 0;
 }
 
 void UGrappleComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
@@ -81,7 +146,9 @@ void UGrappleComponent::TickComponent(float DeltaTime, ELevelTick TickType, FAct
 
 	// TODO if we attach the object that we hit to the anchor and just move the anchor back then that could be how we pull things to the player
 	// TODO conversely if just move the grapple origin to the attachment that could be how we pull the player to the anchor
-	UpdateGrappleAnchorLocation();
+	RefreshReachabilityTable();
+	UpdateAimTarget();
+	UpdateAimPreview();
 	ProcessGrapple(DeltaTime);
 
 #if !UE_BUILD_SHIPPING
@@ -91,37 +158,201 @@ void UGrappleComponent::TickComponent(float DeltaTime, ELevelTick TickType, FAct
 
 void UGrappleComponent::DoGrapple()
 {
+	// Letting go of the rope
+	if (GrappleState == GrappleStateEnum::Swinging)
+	{
+		EndSwing();
+		return;
+	}
+
 	if (bIsGrappleExtendActive)
 		return;
 
 	bIsGrappleExtendActive = true;
 	GrappleState = GrappleStateEnum::Extending;
 
-	if (UCameraComponent* cameraComponent = DeftCharacter->FindComponentByClass<UCameraComponent>())
+	// The hook sits on the anchor until it's fired
+	GrappleHookLocation = GrappleAnchor->GetComponentLocation();
+	FHitResult empty;
+	Grapple->K2_SetWorldLocation(GrappleHookLocation, false, empty, true);
+
+	if (CameraComponent.IsValid())
+		GrappleMaxReachPoint = GrappleHookLocation + (GetGrappleDir(GrappleHookLocation) * GrappleDistanceMax);
+
+	bIsGrappleFireTimeHit = CVar_Feature_GrappleFireTimeHit.GetValueOnGameThread();
+	if (bIsGrappleFireTimeHit)
+		ResolveFireTimeHit();
+}
+
+void UGrappleComponent::ResolveFireTimeHit()
+{
+	// One sweep over the whole reach now instead of one per frame of hook flight, the flight itself is just for show
+	GrappleFlightStart = GrappleHookLocation;
+	GrappleFlightElapsed = 0.f;
+
+	GrappleFireHit = FHitResult();
+	bHasGrappleFireHit = GetWorld()->SweepSingleByProfile(GrappleFireHit, GrappleFlightStart, GrappleMaxReachPoint, FQuat::Identity, GrappleHookProfileName, FCollisionShape::MakeSphere(GrappleHookRadius), DeftCharacter->GetCollisionContext().QueryParams);
+
+	GrappleFlightEnd = bHasGrappleFireHit ? GrappleFireHit.Location : GrappleMaxReachPoint;
+	GrappleFlightTime = GrappleExtendSpeed > 0.f ? FVector::Dist(GrappleFlightStart, GrappleFlightEnd) / GrappleExtendSpeed : 0.f;
+
+	const USceneComponent* hitComponent = GrappleFireHit.GetComponent();
+	GrappleFireHitLocalLoc = hitComponent ? hitComponent->GetComponentTransform().InverseTransformPosition(GrappleFireHit.Location) : GrappleFireHit.Location;
+}
+
+void UGrappleComponent::UpdateAimTarget()
+{
+	GrappleAimTarget = nullptr;
+	if (GrappleState != GrappleStateEnum::None)
+		return;
+
+	const UDeftGrappleTargetSubsystem* grappleTargetSubsystem = GetWorld()->GetSubsystem<UDeftGrappleTargetSubsystem>();
+	if (!grappleTargetSubsystem || !CameraComponent.IsValid())
+		return;
+
+	const FVector aimStart = GrappleAnchor->GetComponentLocation();
+	TArray<FDeftGrappleTarget> candidates;
+	grappleTargetSubsystem->QueryCone(aimStart, CameraComponent->GetForwardVector(), GrappleDistanceMax, GrappleAimAssistAngle, candidates, GrappleAimAssistCandidatesMax);
+
+	// Snapping to something behind a wall would bend the grapple straight into the wall, take the best one the hook could actually get to
+	for (const FDeftGrappleTarget& candidate : candidates)
 	{
-		GrappleMaxReachPoint = Grapple->GetComponentLocation() + (cameraComponent->GetForwardVector() * GrappleDistanceMax);
+		USceneComponent* candidateComponent = candidate.Component.Get();
+		if (!candidateComponent)
+			continue;
+
+		FHitResult hit;
+		const bool bIsBlocked = GetWorld()->LineTraceSingleByProfile(hit, aimStart, candidate.Location, GrappleHookProfileName, DeftCharacter->GetCollisionContext().QueryParams)
+			&& hit.GetActor() != candidateComponent->GetOwner();
+		if (!bIsBlocked)
+		{
+			GrappleAimTarget = candidateComponent;
+			return;
+		}
 	}
 }
 
-void UGrappleComponent::ProcessGrapple(float aDeltaTime)
+void UGrappleComponent::UpdateAimPreview()
 {
-	// Seems redundant if the UpdateGrappleAnchorLocation is also doing this
-	if (!bIsGrappleExtendActive)
+	if (!CVar_Feature_GrappleAimPreview.GetValueOnGameThread() || GrappleState != GrappleStateEnum::None || !CameraComponent.IsValid())
 	{
-		FHitResult empty;
-		Grapple->K2_SetWorldLocation(GrappleAnchor->GetComponentLocation(), false, empty, true);
+		ResetAimPreview();
+		return;
 	}
 
+	// Under load best effort sweeps come back slower, the preview just keeps showing the last one until then
+	UDeftSceneQuerySubsystem* sceneQuerySubsystem = GetWorld()->GetSubsystem<UDeftSceneQuerySubsystem>();
+	if (!sceneQuerySubsystem || GrappleAimPreviewQueryID != 0)
+		return;
+
+	const FVector aimStart = GrappleAnchor->GetComponentLocation();
+	const FVector aimEnd = aimStart + (GetGrappleDir(aimStart) * GrappleDistanceMax);
+	const FDeftSceneQuery aimSweep = FDeftSceneQuery::Sweep(aimStart, aimEnd, FQuat::Identity, GrappleHookProfileName, FCollisionShape::MakeSphere(GrappleHookRadius), DeftCharacter->GetCollisionContext().QueryParams);
+	GrappleAimPreviewQueryID = sceneQuerySubsystem->Submit(aimSweep, EDeftSceneQueryLatency::BestEffort, GrappleAimPreviewQueryPriority, FOnDeftSceneQueryDone::CreateUObject(this, &UGrappleComponent::OnAimPreviewSweepDone));
+}
+
+void UGrappleComponent::OnAimPreviewSweepDone(const FDeftSceneQueryResult& aResult)
+{
+	GrappleAimPreviewQueryID = 0;
+	if (aResult.bDropped || !DeftCharacter.IsValid())
+		return;
+
+	const bool bWillHit = aResult.bBlockingHit;
+	const FVector aimDir = (aResult.End - aResult.Start).GetSafeNormal();
+	GrappleAimPreview.HitLocation = bWillHit ? aResult.Hit.Location : aResult.End;
+
+	// The hit itself is fresh every sweep, the solve + arc only get redone once the aim or character moved enough to see the difference
+	const bool bAimMoved = aimDir.Dot(GrappleAimPreviewSolvedDir) < FMath::Cos(FMath::DegreesToRadians(GrappleAimPreviewAngleThreshold));
+	const bool bCharacterMoved = FVector::DistSquared(DeftCharacter->GetActorLocation(), GrappleAimPreviewSolvedActorLoc) > FMath::Square(GrappleAimPreviewMoveThreshold);
+	if (!bHasGrappleAimPreviewSolve || bWillHit != GrappleAimPreview.bWillHit || bAimMoved || bCharacterMoved)
+	{
+		GrappleAimPreview.bWillHit = bWillHit;
+		SolveAimPreview(aimDir);
+	}
+}
+
+void UGrappleComponent::SolveAimPreview(const FVector& aAimDir)
+{
+	GrappleAimPreviewSolvedDir = aAimDir;
+	GrappleAimPreviewSolvedActorLoc = DeftCharacter->GetActorLocation();
+	bHasGrappleAimPreviewSolve = true;
+
+	GrappleAimPreview.Arc.Reset();
+	GrappleAimPreview.LaunchAngle = 0.f;
+	GrappleAimPreview.bCanReach = false;
+	if (!GrappleAimPreview.bWillHit)
+		return;
+
+	// Just for show, the table is close enough
+	FDeftLaunchSolution low, high;
+	GrappleAimPreview.bCanReach = LookupLaunchToReach(GrappleAimPreview.HitLocation, low, high);
+	if (!GrappleAimPreview.bCanReach)
+		return;
+
+	GrappleAimPreview.LaunchAngle = PickLaunchAngle(low, high);
+	GrappleAimPreview.TimeOfFlight = GrappleAimPreview.LaunchAngle == low.Angle ? low.TimeOfFlight : high.TimeOfFlight;
+	if (UPredictPathComponent* predictPathComponent = DeftCharacter->GetPredictPathComponent())
+	{
+		const FVector grappleDir = GrappleAimPreview.HitLocation - GrappleAimPreviewSolvedActorLoc;
+		predictPathComponent->PredictPath_Parabola(GrapplePullSpeed, GrappleAimPreview.LaunchAngle, grappleDir, GrappleAimPreview.HitLocation, GrappleAimPreview.Arc);
+	}
+}
+
+void UGrappleComponent::ResetAimPreview()
+{
+	if (UDeftSceneQuerySubsystem* sceneQuerySubsystem = GetWorld()->GetSubsystem<UDeftSceneQuerySubsystem>())
+		sceneQuerySubsystem->Cancel(GrappleAimPreviewQueryID);
+	bHasGrappleAimPreviewSolve = false;
+	GrappleAimPreview = FGrappleAimPreview();
+}
+
+void UGrappleComponent::RefreshReachabilityTable()
+{
+	const float gravityZ = GetWorld()->GetGravityZ();
+	if (!GrappleReachabilityTable.IsBuiltFor(GrapplePullSpeed, gravityZ, GrappleDistanceMax, GrappleDistanceMax))
+		GrappleReachabilityTable.Build(GrapplePullSpeed, gravityZ, GrappleDistanceMax, GrappleDistanceMax);
+}
+
+bool UGrappleComponent::LookupLaunchToReach(const FVector& aTargetLocation, FDeftLaunchSolution& outLow, FDeftLaunchSolution& outHigh) const
+{
+	if (!DeftCharacter.IsValid())
+		return false;
+
+	float distance, height;
+	GetReachOffsets(aTargetLocation, distance, height);
+	return GrappleReachabilityTable.Lookup(distance, height, outLow, outHigh);
+}
+
+FVector UGrappleComponent::GetGrappleDir(const FVector& aFrom) const
+{
+	// Players miss by a few pixels, fire straight at whatever target is close enough to where they're looking
+	if (GrappleAimTarget.IsValid())
+		return (GrappleAimTarget->GetComponentLocation() - aFrom).GetSafeNormal();
+
+	return CameraComponent.IsValid() ? CameraComponent->GetForwardVector() : FVector::ZeroVector;
+}
+
+void UGrappleComponent::ProcessGrapple(float aDeltaTime)
+{
 	if (GrappleState == GrappleStateEnum::Extending)
 		ExtendGrapple(aDeltaTime);
 
 	if (GrappleState == GrappleStateEnum::Pulling)
 		PullGrapple(aDeltaTime);
+
+	if (GrappleState == GrappleStateEnum::Swinging)
+		SwingGrapple(aDeltaTime);
 }
 
 void UGrappleComponent::ExtendGrapple(float aDeltaTime)
 {
-	const FVector grappleLoc = Grapple->GetComponentLocation();
+	if (bIsGrappleFireTimeHit)
+	{
+		ExtendGrappleToFireTimeHit(aDeltaTime);
+		return;
+	}
+
+	const FVector grappleLoc = GrappleHookLocation;
 	FVector direction = GrappleMaxReachPoint - grappleLoc;
 
 #if !UE_BUILD_SHIPPING
@@ -142,13 +373,9 @@ void UGrappleComponent::ExtendGrapple(float aDeltaTime)
 #endif //!UE_BUILD_SHIPPING
 
 	// Collision check
-	FCollisionQueryParams collisionParams;
-	collisionParams.AddIgnoredActor(DeftCharacter.Get());
-	collisionParams.AddIgnoredComponent(Grapple);
-	FCollisionShape sphereShape = FCollisionShape::MakeSphere(5.f);
-
+	// Ignoring the character ignores the grapple sphere too since it belongs to the character
 	FHitResult hit;
-	const bool bIsBlockingHit = GetWorld()->SweepSingleByProfile(hit, grappleLoc, destination, Grapple->GetComponentRotation().Quaternion(), Grapple->GetCollisionProfileName(), sphereShape, collisionParams);
+	const bool bIsBlockingHit = GetWorld()->SweepSingleByProfile(hit, grappleLoc, destination, FQuat::Identity, GrappleHookProfileName, FCollisionShape::MakeSphere(GrappleHookRadius), DeftCharacter->GetCollisionContext().QueryParams);
 	if (bIsBlockingHit)
 	{
 		Debug_GrappleMaxLocReached = hit.Location;
@@ -156,177 +383,230 @@ void UGrappleComponent::ExtendGrapple(float aDeltaTime)
 		return;
 	}
 
-	FLatentActionInfo latentInfo;
-	latentInfo.CallbackTarget = this;
-	UKismetSystemLibrary::MoveComponentTo((USceneComponent*)Grapple, destination, Grapple->GetComponentRotation(), false, false, 0.f, true, EMoveComponentAction::Move, latentInfo);
+	GrappleHookLocation = destination;
+	FHitResult empty;
+	Grapple->K2_SetWorldLocation(GrappleHookLocation, false, empty, true);
 }
 
-void UGrappleComponent::PullGrapple(float aDeltaTime) //TODO: need to just tell the main DeftCharacterMovementComponent that we are in something that overrides the movement
+void UGrappleComponent::ExtendGrappleToFireTimeHit(float aDeltaTime)
 {
-	if (!bIsGrapplePullActive)
-	{
-		UE_LOG(LogTemp, Warning, TEXT("Grapple pull not active"));
-		GrappleState = GrappleStateEnum::None;
-		OnGrapplePullDelegate.Broadcast(false);
-		return;
-	}
+	GrappleFlightElapsed += aDeltaTime;
+	const float flightAlpha = GrappleFlightTime > 0.f ? FMath::Min(GrappleFlightElapsed / GrappleFlightTime, 1.f) : 1.f;
+
+	GrappleHookLocation = FMath::Lerp(GrappleFlightStart, GrappleFlightEnd, flightAlpha);
+	FHitResult empty;
+	Grapple->K2_SetWorldLocation(GrappleHookLocation, false, empty, true);
+
+#if !UE_BUILD_SHIPPING
+	Debug_GrappleDistance = FVector::Dist(GrappleHookLocation, GrappleFlightEnd);
+	Debug_GrappleMaxLocReached = GrappleHookLocation;
+#endif //!UE_BUILD_SHIPPING
 
-	// TODO: assuming we're being pulled to the attachment here
+	if (flightAlpha < 1.f)
+		return;
 
-	// Given a path of points, travel along the path at a set speed
-	if (GrapplePullIndex >= GrapplePullPath.Num())
+	if (!bHasGrappleFireHit)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Reached end of grapple path"));
-		bIsGrapplePullActive = false;
+		EndGrapple(false);
 		return;
 	}
 
-	// have a current waypoint, and a theshold of 
-	const FVector attachedActorLoc = AttachedActor->GetActorLocation();
-	FVector direction = GrapplePullPath[GrapplePullIndex] - attachedActorLoc;
+	// Static geometry is still exactly where it was when we fired, anything else gets one sweep to where the hit point has moved to
+	const UPrimitiveComponent* hitComponent = GrappleFireHit.GetComponent();
+	if (hitComponent && hitComponent->Mobility != EComponentMobility::Static)
+	{
+		const FVector hitLoc = hitComponent->GetComponentTransform().TransformPosition(GrappleFireHitLocalLoc);
+		const FVector overReach = (hitLoc - GrappleFlightStart).GetSafeNormal() * GrappleReachThreshold;
 
-	UE_LOG(LogTemp, Warning, TEXT("Pulling from %s -> %s"), *attachedActorLoc.ToString(), *GrapplePullPath[GrapplePullIndex].ToString());
-//#if !UE_BUILD_SHIPPING
-//	Debug_GrappleDistance = direction.Length();
-//#endif //!UE_BUILD_SHIPPING
+		FHitResult hit;
+		if (!GetWorld()->SweepSingleByProfile(hit, GrappleFlightStart, hitLoc + overReach, FQuat::Identity, GrappleHookProfileName, FCollisionShape::MakeSphere(GrappleHookRadius), DeftCharacter->GetCollisionContext().QueryParams))
+		{
+			EndGrapple(false);
+			return;
+		}
+		GrappleFireHit = hit;
+		GrappleHookLocation = GrappleFireHit.Location;
+		Grapple->K2_SetWorldLocation(GrappleHookLocation, false, empty, true);
+	}
 
-	direction /= direction.Length();
-	const FVector destination = attachedActorLoc + (direction * 1000.f * aDeltaTime);
-//#if !UE_BUILD_SHIPPING
-//	Debug_GrappleLocThisFrame = destination;
-//	Debug_GrappleMaxLocReached = Debug_GrappleLocThisFrame;
-//#endif //!UE_BUILD_SHIPPING
+#if !UE_BUILD_SHIPPING
+	Debug_GrappleMaxLocReached = GrappleFireHit.Location;
+#endif //!UE_BUILD_SHIPPING
+	EndGrapple(true, GrappleFireHit.GetActor());
+}
 
-	// Collision check
-	//FCollisionQueryParams floorCheckCollisionParams;
-	//floorCheckCollisionParams.AddIgnoredActor(AttachedActor.Get());
-	//const UCapsuleComponent* capsulComponent = DeftCharacter->GetCapsuleComponent();
-	//FCollisionShape capsulShape = FCollisionShape::MakeCapsule(capsulComponent->GetScaledCapsuleRadius(), capsulComponent->GetScaledCapsuleHalfHeight());
-
-	//FHitResult hit;
-	//const bool bIsBlockingHit = GetWorld()->SweepSingleByChannel(hit, attachedActorLoc, destination, AttachedActor->GetActorRotation().Quaternion(), ECollisionChannel::ECC_WorldStatic, );
-	//if (bIsBlockingHit)
-	//{
-	//	bIsGrapplePullActive = false;
-	//	return;
-	//}
-
-	//TODO: Collision Checks because if we get inside geometry we'll fall to our doom
-
-	//TODO: I need to be more specific than just actor here because we need to use the capsul component for movement
-	FLatentActionInfo latentInfo;
-	latentInfo.CallbackTarget = this;
-	UKismetSystemLibrary::MoveComponentTo((USceneComponent*)DeftCharacter->GetCapsuleComponent(), destination, AttachedActor->GetActorRotation(), false, false, 0.f, true, EMoveComponentAction::Move, latentInfo);
-
-	const FVector distToPoint = GrapplePullPath[GrapplePullIndex] - attachedActorLoc;
-
-	// if the point is not between the player and the final point disregard it.
-	const FVector playerToPos = (GrapplePullPath[GrapplePullIndex] - attachedActorLoc).GetSafeNormal();
-	const FVector originToPos = (GrapplePullPath[GrapplePullIndex] - GrapplePullPath[0]).GetSafeNormal();
-	const float dot = playerToPos.Dot(originToPos);
-
-	if (dot <= 0 || distToPoint.Length() <= GrappleReachThreshold)
+void UGrappleComponent::PullGrapple(float aDeltaTime)
+{
+	// Something being pulled to us is moved by the pull subsystem along with everything else anyone's pulling
+	if (AttachedActor != DeftCharacter)
 	{
-		UE_LOG(LogTemp, Log, TEXT("Moving to next pos"));
-		++GrapplePullIndex;
+		const UDeftPullSubsystem* pullSubsystem = GetWorld()->GetSubsystem<UDeftPullSubsystem>();
+		if (pullSubsystem && AttachedActor.IsValid() && pullSubsystem->IsBeingPulled(AttachedActor.Get()))
+			return;
 	}
-	else
+	// The movement component carries us along GrapplePullPath, we just wait for it to finish
+	else if (DeftMovementComponent.IsValid() && DeftMovementComponent->IsForcedMovementActive(GrapplePullRootMotionID))
 	{
-		UE_LOG(LogTemp, Warning, TEXT("dist between %s - %s of %.2f not close enough"), *attachedActorLoc.ToString(), *GrapplePullPath[GrapplePullIndex].ToString(), distToPoint.Length());
+		// Everything along the path was swept when we fired, only something moving in since then can get in the way
+		if (!IsPullBlockedByDynamicObject(aDeltaTime))
+			return;
+
+		DeftMovementComponent->StopForcedMovement(GrapplePullRootMotionID);
 	}
+
+	GrapplePullRootMotionID = (uint16)ERootMotionSourceID::Invalid;
+	AttachedActor = nullptr;
+	GrappleState = GrappleStateEnum::None;
+	OnGrapplePullDelegate.Broadcast(false);
 }
 
 void UGrappleComponent::EndGrapple(bool aApplyImpulse, AActor* aHitActor/* = nullptr*/)
 {
 	bIsGrappleExtendActive = false;
+	GrappleState = GrappleStateEnum::None;
 
-	// TODO: conditionally pull TO the player or PLAYER to the thing depending on what you hit
 	if (aApplyImpulse)
 	{
-		if (aHitActor->ActorHasTag(FName("Pullable")))
+		UDeftPullSubsystem* pullSubsystem = GetWorld()->GetSubsystem<UDeftPullSubsystem>();
+		if (aHitActor && aHitActor->ActorHasTag(UDeftGrappleTargetSubsystem::PullableTag) && pullSubsystem
+			&& pullSubsystem->StartPull(aHitActor, GrappleAnchor, GrapplePullObjectSpeed, GrapplePullObjectStopDistance))
 		{
 			// pull attachment to the player
 			AttachedActor = TWeakObjectPtr<AActor>(aHitActor);
 			UE_LOG(LogTemp, Log, TEXT("Pulling attachment to the player"));
+
+			GrappleState = GrappleStateEnum::Pulling;
+			OnGrapplePullDelegate.Broadcast(true);
+			return;
 		}
-		else
+
+		if (CVar_Feature_GrappleSwing.GetValueOnGameThread())
 		{
-			// pull actor to the attachment
-			AttachedActor = DeftCharacter;
-			UE_LOG(LogTemp, Log, TEXT("Pulling player to the attachment"));
+			StartSwing();
+			return;
 		}
 
-		const float impulseAngle = CalculateAngleToReach(Grapple->GetComponentLocation());
+		// pull actor to the attachment, pullables that can't be moved are just something else to grapple to
+		AttachedActor = DeftCharacter;
+		UE_LOG(LogTemp, Log, TEXT("Pulling player to the attachment"));
+
+		const float impulseAngle = CalculateAngleToReach(GrappleHookLocation);
 		CalculatePath(impulseAngle);
-		UE_LOG(LogTemp, Warning, TEXT("Predicted Path contains %d points"), GrapplePullPath.Num());
 
+		if (!GrapplePullPath.IsValid() || !DeftMovementComponent.IsValid())
+			return;
+
+		// Stop short of whatever is in the way rather than getting pulled into geometry and falling to our doom
+		GrapplePullClearDistance = FindPullPathClearDistance();
 
-		GrapplePullIndex = 0;
+		TSharedPtr<FRootMotionSource_DeftGrapplePull> pullSource = MakeShared<FRootMotionSource_DeftGrapplePull>();
+		pullSource->InstanceName = TEXT("DeftGrapplePull");
+		pullSource->SetPath(GrapplePullPath, GrapplePullTravelSpeed, GrapplePullClearDistance);
+		pullSource->FinishVelocityParams.Mode = ERootMotionFinishVelocityMode::SetVelocity;
+		pullSource->FinishVelocityParams.SetVelocity = FVector::ZeroVector;
+
+		GrapplePullRootMotionID = DeftMovementComponent->ApplyForcedMovement(pullSource);
 		GrappleState = GrappleStateEnum::Pulling;
-		bIsGrapplePullActive = true;
 		OnGrapplePullDelegate.Broadcast(true);
 	}
 }
 
-float UGrappleComponent::CalculateAngleToReach(const FVector& aTargetLocation)
+void UGrappleComponent::StartSwing()
 {
-	const FVector actorLoc = DeftCharacter->GetActorLocation();
-	const FVector dirToGrapple = aTargetLocation - actorLoc; // vector from actor to grapple
+	if (!DeftMovementComponent.IsValid())
+		return;
 
-	// the distance in the actors forward direction = the X component of the total distance
-	FVector xBasis = DeftCharacter->GetActorForwardVector();
-	const FVector projX = (dirToGrapple.Dot(xBasis) / xBasis.Dot(xBasis)) * xBasis;
+	GrappleRope.Init(GrappleHookLocation, DeftCharacter->GetActorLocation(), GrappleRopeSegments, GrappleRopeEndInvMass);
 
-	const float v0 = GrapplePullSpeed;							// initial velocity (i.e. speed)
-	const float y0 = 0.f;										// actors starting vertical height
-	const float y = FMath::Abs(aTargetLocation.Z - actorLoc.Z);	// vertical height of the grapple
-	const float x = projX.Length();								// horizontal distance to the grapple
-	const float g = -980.f;										//TODO: either take in, or read from WorldSettings on ctor
+	// Flying without gravity, the rope applies it so the swing is all in one place. The source's velocity is replaced every frame by SwingGrapple
+	TSharedPtr<FRootMotionSource_ConstantForce> swingSource = MakeShared<FRootMotionSource_ConstantForce>();
+	swingSource->InstanceName = TEXT("DeftGrappleSwing");
+	swingSource->AccumulateMode = ERootMotionAccumulateMode::Override;
+	swingSource->Duration = -1.f;
+	swingSource->Force = DeftMovementComponent->Velocity;
+	swingSource->FinishVelocityParams.Mode = ERootMotionFinishVelocityMode::MaintainLastRootMotionVelocity;
 
-	// x = x0 + (v0x * t)
-	// y = y0 + (v0y * t) + 1/2gt^2
-	
-	const float xSq = x * x;
-	const float vSq = v0 * v0;
-	const float gHalf = g * 0.5f;
+	GrappleSwingRootMotionID = DeftMovementComponent->ApplyForcedMovement(swingSource);
+	AttachedActor = DeftCharacter;
+	GrappleState = GrappleStateEnum::Swinging;
+	OnGrapplePullDelegate.Broadcast(true);
+}
 
-	const float a = gHalf * (xSq / vSq);
-	const float b = x;
-	const float c = (y0 - y) + a;
+void UGrappleComponent::SwingGrapple(float aDeltaTime)
+{
+	// Something else took over moving us
+	if (!DeftMovementComponent.IsValid() || !DeftMovementComponent->IsForcedMovementActive(GrappleSwingRootMotionID) || aDeltaTime <= 0.f)
+	{
+		EndSwing();
+		return;
+	}
 
-	UE_LOG(LogTemp, Warning, TEXT("horizontal distance %.2f"), projX.Length());
-	UE_LOG(LogTemp, Warning, TEXT("anchor height %2.f, relative height %.2f"), GrappleAnchor->GetComponentLocation().Z, GrappleAnchor->GetRelativeLocation().Z);
+	// We're the end of the rope, wherever the last move left us and going as fast as it did
+	const FVector actorLoc = DeftCharacter->GetActorLocation();
+	GrappleRope.SetEnd(actorLoc, DeftMovementComponent->Velocity, aDeltaTime);
+	GrappleRope.Simulate(aDeltaTime, GetWorld()->GetGravityZ(), GrappleRopeIterations);
+
+	const FDeftCollisionContext& collisionContext = DeftCharacter->GetCollisionContext();
+	FCollisionObjectQueryParams ropeObjectParams = collisionContext.DynamicObjectParams;
+	ropeObjectParams.AddObjectTypesToQuery(ECC_WorldStatic);
+	GrappleRope.Collide(*GetWorld(), collisionContext.QueryParams, ropeObjectParams, GrappleRopeRadius);
 
-	// [ -b +- sqrt (b^2 - 4ac) ] / 2a
-	const float bSsq = b * b;
-	const float fourAC = 4 * a * c;
-	const float twoA = 2 * a;
+	// The movement component sweeps us to where the rope wants us next frame
+	TSharedPtr<FRootMotionSource> swingSource = DeftMovementComponent->GetRootMotionSourceByID(GrappleSwingRootMotionID);
+	static_cast<FRootMotionSource_ConstantForce*>(swingSource.Get())->Force = (GrappleRope.GetEnd() - actorLoc) / aDeltaTime;
+}
 
-	UE_LOG(LogTemp, Warning, TEXT("bSsq, fourAC, twoA: %.2f, %.2f, %.2f"), bSsq, fourAC, twoA);
+void UGrappleComponent::EndSwing()
+{
+	if (DeftMovementComponent.IsValid())
+		DeftMovementComponent->StopForcedMovement(GrappleSwingRootMotionID);
+
+	GrappleSwingRootMotionID = (uint16)ERootMotionSourceID::Invalid;
+	GrappleRope.Reset();
+	AttachedActor = nullptr;
+	GrappleState = GrappleStateEnum::None;
+	OnGrapplePullDelegate.Broadcast(false);
+}
 
-	if (bSsq - fourAC < 0)
+float UGrappleComponent::CalculateAngleToReach(const FVector& aTargetLocation)
+{
+	FDeftLaunchSolution low, high;
+	if (!SolveAngleToReach(aTargetLocation, low, high))
 	{
-		UE_LOG(LogTemp, Warning, TEXT("no solution due to negative under the radical"));
+		UE_LOG(LogTemp, Log, TEXT("Grapple out of reach at velocity %.2f"), GrapplePullSpeed);
 		return 0.f;
 	}
 
-	const float thetaPos = (-b + FMath::Sqrt(bSsq - fourAC)) / twoA;
-	const float thetaNeg = (-b - FMath::Sqrt(bSsq - fourAC)) / twoA;
-
-	const float rads1 = UKismetMathLibrary::Atan(thetaPos);
-	const float rads2 = UKismetMathLibrary::Atan(thetaNeg);
-
-	const float deg1 = FMath::RadiansToDegrees(rads1);
-	const float deg2 = FMath::RadiansToDegrees(rads2);
-
 #if !UE_BUILD_SHIPPING
-	UE_LOG(LogTemp, Warning, TEXT("Angle %.2f or %.2f needed to reach grapple at velocity %.2f"), deg1, deg2, v0);
+	UE_LOG(LogTemp, Log, TEXT("Angle %.2f or %.2f needed to reach grapple at velocity %.2f"), low.Angle, high.Angle, GrapplePullSpeed);
 	
-	Debug_GrappleLaunchDeg1 = deg1;
-	Debug_GrappleLaunchDeg2 = deg2;
+	Debug_GrappleLaunchDeg1 = low.Angle;
+	Debug_GrappleLaunchDeg2 = high.Angle;
 #endif//!UE_BUILD_SHIPPING
 
-	return deg1;
+	return PickLaunchAngle(low, high);
+}
+
+bool UGrappleComponent::SolveAngleToReach(const FVector& aTargetLocation, FDeftLaunchSolution& outLow, FDeftLaunchSolution& outHigh) const
+{
+	float distance, height;
+	GetReachOffsets(aTargetLocation, distance, height);
+	return FDeftReachabilityTable::Solve(GrapplePullSpeed, GetWorld()->GetGravityZ(), distance, height, outLow, outHigh);
+}
+
+void UGrappleComponent::GetReachOffsets(const FVector& aTargetLocation, float& outDistance, float& outHeight) const
+{
+	const FVector actorLoc = DeftCharacter->GetActorLocation();
+	const FVector dirToGrapple = aTargetLocation - actorLoc; // vector from actor to grapple
+
+	// the distance in the actors forward direction = the X component of the total distance
+	outDistance = FMath::Abs(dirToGrapple.Dot(DeftCharacter->GetActorForwardVector()));
+	outHeight = aTargetLocation.Z - actorLoc.Z;
+}
+
+float UGrappleComponent::PickLaunchAngle(const FDeftLaunchSolution& aLow, const FDeftLaunchSolution& aHigh)
+{
+	return aLow.Angle >= 0.f ? aLow.Angle : aHigh.Angle;
 }
 
 bool UGrappleComponent::CalculatePath(float aImpulseAngle)
@@ -338,10 +618,82 @@ bool UGrappleComponent::CalculatePath(float aImpulseAngle)
 		return false;
 	}
 
-	const FVector grappleLoc = Grapple->GetComponentLocation();
+	const FVector grappleLoc = GrappleHookLocation;
 	const FVector grappleDir = grappleLoc - DeftCharacter->GetActorLocation(); // vector from actor to grapple
 
-	return predictPathComponent->PredictPath_Parabola(GrapplePullSpeed, aImpulseAngle, grappleDir, grappleLoc, GrapplePullPath);
+	return predictPathComponent->PredictPath_Arc(GrapplePullSpeed, aImpulseAngle, grappleDir, grappleLoc, GrapplePullPath);
+}
+
+float UGrappleComponent::FindPullPathClearDistance()
+{
+	const float pathLength = GrapplePullPath.GetLength();
+	if (pathLength <= 0.f || GrapplePullValidationStep <= 0.f)
+		return pathLength;
+
+	// Each sweep is a chord of the arc, short enough that the capsule covers whatever the arc bulges out between its ends
+	const FDeftCollisionContext& collisionContext = DeftCharacter->GetCollisionContext();
+	const int numSweeps = FMath::Clamp(FMath::CeilToInt(pathLength / GrapplePullValidationStep), 1, GrapplePullValidationSweepsMax);
+	const float sweepLength = pathLength / numSweeps;
+
+	auto sweepChord = [this, &collisionContext](const FVector& aStart, const FVector& aEnd, const FCollisionQueryParams& aParams, FHitResult& outHit)
+	{
+		return GetWorld()->SweepSingleByProfile(outHit, aStart, aEnd, collisionContext.GetCapsuleRotation(), collisionContext.CapsuleProfileName, collisionContext.CapsuleShape, aParams);
+	};
+
+	FVector sweepStart = GrapplePullPath.GetLocationAtDistance(0.f);
+	for (int i = 0; i < numSweeps; ++i)
+	{
+		const FVector sweepEnd = GrapplePullPath.GetLocationAtDistance(sweepLength * (i + 1));
+
+		FHitResult hit;
+		bool bIsBlocked = sweepChord(sweepStart, sweepEnd, collisionContext.QueryParams, hit);
+		if (i == 0)
+		{
+			// Whatever we're standing against when we fire touches us from the start. Pull out of it so anything further along the first chord still counts
+			if (bIsBlocked && hit.bStartPenetrating)
+			{
+				sweepStart += hit.Normal * (hit.PenetrationDepth + 1.f);
+				bIsBlocked = sweepChord(sweepStart, sweepEnd, collisionContext.QueryParams, hit);
+			}
+
+			// Wedged in somewhere pulling out of one thing doesn't clear, the path only leaves what we're touching so that's all the first chord ignores
+			if (bIsBlocked && hit.bStartPenetrating)
+			{
+				FCollisionQueryParams firstChordParams = collisionContext.QueryParams;
+				firstChordParams.AddIgnoredComponent(hit.GetComponent());
+				bIsBlocked = sweepChord(sweepStart, sweepEnd, firstChordParams, hit);
+			}
+		}
+
+		if (bIsBlocked)
+		{
+#if !UE_BUILD_SHIPPING
+			Debug_GrapplePullBlockedLoc = hit.Location;
+#endif //!UE_BUILD_SHIPPING
+			return (i + hit.Time) * sweepLength;
+		}
+
+		sweepStart = sweepEnd;
+	}
+
+#if !UE_BUILD_SHIPPING
+	Debug_GrapplePullBlockedLoc = GrapplePullPath.GetEndLocation();
+#endif //!UE_BUILD_SHIPPING
+	return pathLength;
+}
+
+bool UGrappleComponent::IsPullBlockedByDynamicObject(float aDeltaTime) const
+{
+	if (!DeftMovementComponent.IsValid())
+		return false;
+
+	// Where the pull takes us this frame, shrunk a touch so things we're only brushing against don't count
+	const FDeftCollisionContext& collisionContext = DeftCharacter->GetCollisionContext();
+	const FVector nextLocation = DeftCharacter->GetActorLocation() + (DeftMovementComponent->Velocity * aDeltaTime);
+	const float shrink = 2.f;
+	const FCollisionShape capsuleShape = FCollisionShape::MakeCapsule(FMath::Max(collisionContext.CapsuleShape.GetCapsuleRadius() - shrink, 1.f), FMath::Max(collisionContext.CapsuleShape.GetCapsuleHalfHeight() - shrink, 1.f));
+
+	return GetWorld()->OverlapAnyTestByObjectType(nextLocation, collisionContext.GetCapsuleRotation(), collisionContext.DynamicObjectParams, capsuleShape, collisionContext.QueryParams);
 }
 
 #if !UE_BUILD_SHIPPING
@@ -356,20 +708,36 @@ void UGrappleComponent::DrawDebug()
 
 	//DrawDebugLine(GetWorld(), GrappleAnchor->GetComponentLocation(), GrappleMaxReachPoint, FColor::Yellow);
 
-	DrawDebugSphere(GetWorld(), Grapple->GetComponentLocation(), Grapple->GetUnscaledSphereRadius(), 12, FColor::Blue);
+	DrawDebugSphere(GetWorld(), bIsGrappleExtendActive ? GrappleHookLocation : GrappleAnchor->GetComponentLocation(), GrappleHookRadius, 12, FColor::Blue);
 	DrawDebugSphere(GetWorld(), GrappleAnchor->GetComponentLocation(), 10.f, 12, FColor::White);
 	DrawDebugSphere(GetWorld(), GrappleMaxReachPoint, 10.f, 12, FColor::Yellow);
 
+	if (GrappleAimTarget.IsValid())
+		DrawDebugSphere(GetWorld(), GrappleAimTarget->GetComponentLocation(), 30.f, 12, FColor::Orange);
+
+	if (GrappleAimPreview.bWillHit)
+	{
+		DrawDebugSphere(GetWorld(), GrappleAimPreview.HitLocation, 15.f, 8, GrappleAimPreview.bCanReach ? FColor::Cyan : FColor::Red);
+		for (int i = 1; i < GrappleAimPreview.Arc.Num(); ++i)
+			DrawDebugLine(GetWorld(), GrappleAimPreview.Arc[i - 1], GrappleAimPreview.Arc[i], FColor::Cyan);
+	}
+
+	for (int i = 1; i < GrappleRope.GetNumParticles(); ++i)
+		DrawDebugLine(GetWorld(), GrappleRope.GetParticle(i - 1), GrappleRope.GetParticle(i), FColor::Emerald);
+
+	if (GrappleState == GrappleStateEnum::Pulling)
+		DrawDebugSphere(GetWorld(), Debug_GrapplePullBlockedLoc, 10.f, 12, GrapplePullClearDistance < GrapplePullPath.GetLength() ? FColor::Red : FColor::Green);
+
 	if (!bIsGrappleExtendActive)
 	{
-		DrawDebugSphere(GetWorld(), Debug_GrappleMaxLocReached, Grapple->GetUnscaledSphereRadius(), 12, FColor::Red);
+		DrawDebugSphere(GetWorld(), Debug_GrappleMaxLocReached, GrappleHookRadius, 12, FColor::Red);
 		GEngine->AddOnScreenDebugMessage(-1, 0.005f, bIsGrappleExtendActive ? FColor::Green : FColor::White, FString::Printf(TEXT("Attachment Loc: (%.2f, %.2f, %.2f)"), Debug_GrappleMaxLocReached.X, Debug_GrappleMaxLocReached.Y, Debug_GrappleMaxLocReached.Z));
 		//DrawDebugSphere(GetWorld(), Debug_GrappleLocThisFrame, 5.f, 8, FColor::Purple, false, 0.5f);
 	}
 
-	if (UCameraComponent* cameraComponent = DeftCharacter->FindComponentByClass<UCameraComponent>())
+	if (CameraComponent.IsValid())
 	{
-		//DrawDebugLine(GetWorld(), DeftCharacter->GetActorLocation(), DeftCharacter->GetActorLocation() + (cameraComponent->GetForwardVector() * 100.f), FColor::Cyan);
+		//DrawDebugLine(GetWorld(), DeftCharacter->GetActorLocation(), DeftCharacter->GetActorLocation() + (CameraComponent->GetForwardVector() * 100.f), FColor::Cyan);
 	}
 }
 #endif //!UE_BUILD_SHIPPING
@@ -2,11 +2,54 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "DeftParabolaPath.h"
+#include "DeftReachabilityTable.h"
+#include "DeftVerletRope.h"
+#include "WorldCollision.h"
 
 #include "GrappleComponent.generated.h"
 
 DECLARE_MULTICAST_DELEGATE_OneParam(FOnGrapplePull, bool/*bStarted*/);
 
+// What firing the grapple right now would do, a frame behind since the sweep behind it is async
+USTRUCT(BlueprintType)
+struct FGrappleAimPreview
+{
+	GENERATED_BODY()
+
+	FGrappleAimPreview()
+		: HitLocation(FVector::ZeroVector)
+		, LaunchAngle(0.f)
+		, TimeOfFlight(0.f)
+		, Arc()
+		, bWillHit(false)
+		, bCanReach(false)
+	{}
+
+	// Where the hook would stop, the max reach if it won't hit anything
+	UPROPERTY(BlueprintReadOnly, Category = "Grapple")
+	FVector HitLocation;
+
+	// Degrees, what CalculateAngleToReach gives for HitLocation
+	UPROPERTY(BlueprintReadOnly, Category = "Grapple")
+	float LaunchAngle;
+
+	// Seconds along the arc until we get there
+	UPROPERTY(BlueprintReadOnly, Category = "Grapple")
+	float TimeOfFlight;
+
+	// The path we'd get pulled along, empty if there's nothing to be pulled to
+	UPROPERTY(BlueprintReadOnly, Category = "Grapple")
+	TArray<FVector> Arc;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Grapple")
+	bool bWillHit;
+
+	// Whether there's a launch angle which gets us to HitLocation at all
+	UPROPERTY(BlueprintReadOnly, Category = "Grapple")
+	bool bCanReach;
+};
+
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class DEFT_API UGrappleComponent : public UActorComponent
 {
@@ -18,7 +61,8 @@ protected:
 		None,
 		Extending,
 		Retracting,
-		Pulling
+		Pulling,
+		Swinging
 	};
 
 public:	
@@ -29,20 +73,55 @@ public:
 
 	FOnGrapplePull OnGrapplePullDelegate;
 
+	// What the grapple would snap to if fired now, for highlighting
+	class USceneComponent* GetAimTarget() const { return GrappleAimTarget.Get(); }
+	// For the crosshair/arc UI, see deft.feature.grappleAimPreview
+	UFUNCTION(BlueprintCallable)
+	const FGrappleAimPreview& GetAimPreview() const { return GrappleAimPreview; }
+	// Cheap enough to test lots of candidates a frame (i.e. AI picking what to grapple to), the launch actually fired is solved exactly
+	bool LookupLaunchToReach(const FVector& aTargetLocation, FDeftLaunchSolution& outLow, FDeftLaunchSolution& outHigh) const;
+
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
-	void UpdateGrappleAnchorLocation();
+	void UpdateAimTarget();
+	// Asks the scene query subsystem for the next aim sweep once the last one came back
+	void UpdateAimPreview();
+	void OnAimPreviewSweepDone(const struct FDeftSceneQueryResult& aResult);
+	// Re-solves the launch angle and arc for the preview hit, only called once the aim or character has moved far enough to matter
+	void SolveAimPreview(const FVector& aAimDir);
+	void ResetAimPreview();
+	// Rebuilds the reachability table if the pull speed or gravity changed since it was built
+	void RefreshReachabilityTable();
+	// Where the hook goes if fired from aFrom, snapping to the aim target if there is one
+	FVector GetGrappleDir(const FVector& aFrom) const;
 	void ProcessGrapple(float aDeltaTime);
 
 
 	void ExtendGrapple(float aDeltaTime);
+	// Hook flight when what it hits was already resolved as it was fired (see deft.feature.grappleFireTimeHit)
+	void ExtendGrappleToFireTimeHit(float aDeltaTime);
+	void ResolveFireTimeHit();
 	void PullGrapple(float aDeltaTime);
+	// Rope swing from the hook instead of a pull (see deft.feature.grappleSwing)
+	void StartSwing();
+	void SwingGrapple(float aDeltaTime);
+	void EndSwing();
 	void EndGrapple(bool aApplyImpulse, AActor* aHitActor = nullptr);
 
 	float CalculateAngleToReach(const FVector& aTargetLocation);
+	// Both launches which land on aTargetLocation, false if it's out of reach at GrapplePullSpeed
+	bool SolveAngleToReach(const FVector& aTargetLocation, FDeftLaunchSolution& outLow, FDeftLaunchSolution& outHigh) const;
+	// aTargetLocation as distance along our forward and height above us, how the pull path is laid out
+	void GetReachOffsets(const FVector& aTargetLocation, float& outDistance, float& outHeight) const;
+	// The low arc unless it'd launch us downwards, the pull path only goes up from where we are
+	static float PickLaunchAngle(const FDeftLaunchSolution& aLow, const FDeftLaunchSolution& aHigh);
 	bool CalculatePath(float aImpulseAngle);
+	// How far along GrapplePullPath the capsule gets before hitting anything, the whole path if nothing is in the way
+	float FindPullPathClearDistance();
+	// Whether something movable has come into the path right ahead of us since we validated it
+	bool IsPullBlockedByDynamicObject(float aDeltaTime) const;
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = Collision)
 	class USceneComponent* GrappleAnchor;
@@ -51,6 +130,13 @@ protected:
 	class USphereComponent* Grapple;
 
 	TWeakObjectPtr<class ADeftPlayerCharacter> DeftCharacter;
+	TWeakObjectPtr<class UDeftCharacterMovementComponent> DeftMovementComponent;
+	TWeakObjectPtr<class UCameraComponent> CameraComponent;
+
+	// Hook: only ever swept for, the Grapple sphere just shows where it is while it's out
+	FVector GrappleHookLocation;
+	FName GrappleHookProfileName;
+	float GrappleHookRadius;
 
 	// Extending
 	FVector GrappleMaxReachPoint;
@@ -59,15 +145,52 @@ protected:
 	float GrappleExtendSpeed;		// speed at which the grapple moves
 	bool bIsGrappleExtendActive;
 
+	// Fire Time Hit
+	FHitResult GrappleFireHit;
+	FVector GrappleFlightStart;
+	FVector GrappleFlightEnd;				// where the hook is headed, the hit or the max reach
+	FVector GrappleFireHitLocalLoc;			// hit location relative to what we hit, in case it moves while the hook is flying
+	float GrappleFlightTime;
+	float GrappleFlightElapsed;
+	bool bHasGrappleFireHit;
+	bool bIsGrappleFireTimeHit;				// whether the shot in flight resolved its hit when it was fired
+
+	// Aim Assist
+	TWeakObjectPtr<class USceneComponent> GrappleAimTarget;
+	float GrappleAimAssistAngle;	// how far off the crosshair (in degrees) a target can be and still be snapped to
+	int32 GrappleAimAssistCandidatesMax;	// best scoring targets checked for line of sight before giving up on snapping
+
+	// Aim Preview
+	FGrappleAimPreview GrappleAimPreview;
+	uint32 GrappleAimPreviewQueryID;				// best effort sweep waiting on its result, 0 if there isn't one
+	int32 GrappleAimPreviewQueryPriority;			// against everyone else's best effort queries, it's only cosmetic so it goes last
+	FVector GrappleAimPreviewSolvedDir;				// aim direction the current angle/arc were solved for
+	FVector GrappleAimPreviewSolvedActorLoc;		// and where the character was
+	float GrappleAimPreviewAngleThreshold;			// degrees the aim has to swing before re-solving
+	float GrappleAimPreviewMoveThreshold;			// distance the character has to move before re-solving
+	bool bHasGrappleAimPreviewSolve;
+
 	// Pulling
-	TArray<FVector> GrapplePullPath;				// the entire path we should travel for the grapple
-	int GrapplePullIndex;							// the current point in the path we're travelling to
+	FDeftParabolaPath GrapplePullPath;				// the entire path we should travel for the grapple
 	TWeakObjectPtr<class AActor> AttachedActor;		// who/what is being pulled (player, enemy, box...etc)
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Collision)
-	float GrapplePullSpeed;							// speed at which the player is pulled by the grapple
-	float PullTime;
-	float PullTimeMaxTime;
-	bool bIsGrapplePullActive;
+	float GrapplePullSpeed;							// launch speed used to predict the grapple path
+	float GrapplePullTravelSpeed;					// speed at which the player actually travels along the path
+	float GrapplePullObjectSpeed;					// speed at which pullables are pulled to us
+	float GrapplePullObjectStopDistance;			// how far from the anchor pullables stop
+	FDeftReachabilityTable GrappleReachabilityTable;	// launch angles at GrapplePullSpeed for anything within GrappleDistanceMax
+	uint16 GrapplePullRootMotionID;					// forced movement currently pulling us along the path
+	float GrapplePullClearDistance;					// how far along the path we're pulled, short of the end if something was in the way when we fired
+	float GrapplePullValidationStep;				// length of each sweep validating the path
+	int GrapplePullValidationSweepsMax;
+
+	// Swinging
+	FDeftVerletRope GrappleRope;
+	uint16 GrappleSwingRootMotionID;				// forced movement carrying us wherever the rope swings us
+	int GrappleRopeSegments;
+	int GrappleRopeIterations;						// constraint passes a frame, the same at any frame rate
+	float GrappleRopeEndInvMass;					// how much the rope drags us compared to a bit of itself, lower is a heavier swinger
+	float GrappleRopeRadius;
 
 	GrappleStateEnum GrappleState;
 
@@ -79,5 +202,6 @@ protected:
 	float Debug_GrappleDistance;
 	float Debug_GrappleLaunchDeg1;
 	float Debug_GrappleLaunchDeg2;
+	FVector Debug_GrapplePullBlockedLoc;	// where the pull stops
 #endif //!UE_BUILD_SHIPPING
 };
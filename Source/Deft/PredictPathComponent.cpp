@@ -1,9 +1,16 @@
 #include "PredictPathComponent.h"
 
+#include "DeftParabolaPath.h"
 #include "DeftPlayerCharacter.h"
 
 TAutoConsoleVariable<bool> CVar_DebugPredictPath(TEXT("deft.debug.predictPath"), true, TEXT(""), ECVF_Cheat);
 
+namespace
+{
+	const float ParabolaStepTime = 0.05f;	// time between points on the path
+	const int32 ParabolaMaxSamples = 512;
+}
+
 
 // Sets default values for this component's properties
 UPredictPathComponent::UPredictPathComponent()
@@ -44,117 +51,114 @@ void UPredictPathComponent::TickComponent(float DeltaTime, ELevelTick TickType,
 
 bool UPredictPathComponent::PredictPath_Parabola(float aSpeed, float aAngle, const FVector& aDir, const FVector& aPathEnd, TArray<FVector>& outPath)
 {
-	// Velocity is in the actors forward with a local pitch rotated by an aAngle 
-	FVector localRight = DeftCharacter->GetActorRightVector();
-	FVector velocity = DeftCharacter->GetActorForwardVector().GetSafeNormal();
-	velocity = velocity.RotateAngleAxis(aAngle, -localRight) * aSpeed; // for some reason we have to give the 'left' axis to get correct CW positive rotation
+	PredictPaths_Parabola(aSpeed, MakeArrayView(&aAngle, 1), aDir, aPathEnd, MakeArrayView(&outPath, 1));
+	return !outPath.IsEmpty();
+}
 
-#if !UE_BUILD_SHIPPING
-	PredictedOrigin = DeftCharacter->GetActorLocation();
-	PredictedDir = aDir; //TODO: we need to rotate to face aDir because that's actually where the grapple was shot
-	PredictedEnd = aPathEnd;
-	FVector localUp = DeftCharacter->GetActorUpVector();
-	float angleCos = velocity.Dot(localUp);
-	float angleDeg = 90.f - FMath::RadiansToDegrees(FMath::Acos(angleCos));
-	GEngine->AddOnScreenDebugMessage(-1, 0.005f, FColor::Yellow, FString::Printf(TEXT("angle between XY plane and vector: %.2f degrees"), angleDeg));
-#endif//!UE_BUILD_SHIPPING
+void UPredictPathComponent::PredictPaths_Parabola(float aSpeed, TConstArrayView<float> aAngles, const FVector& aDir, const FVector& aPathEnd, TArrayView<TArray<FVector>> outPaths)
+{
+	check(outPaths.Num() >= aAngles.Num());
 
+	for (TArray<FVector>& path : outPaths)
+		path.Reset();
 
-	// find the total horizontal displacement
-	const float gravity = -980.f; //TODO: either take in, or read from WorldSettings on ctor
+	if (!DeftCharacter.IsValid())
+		return;
 
-	//TODO: We can use trig for 2/3 of the axes but unsure which ones.
-	// Obviously projecting works but is a little less efficient than just simple trig multiplication
+	/*
+		Launching at aAngle up from the actor's forward gives the local arc
+			x = vx*t, z = vz*t + 1/2gt^2	with vx = speed*cos(angle), vz = speed*sin(angle)
+		which only needs the actor's forward/up once to put in the world, then 4 times go through it at once.
+		A point is past aPathEnd once it's further along origin->end than the end itself:
+			toEnd.(origin + forward*x + up*z - end) = -|toEnd|^2 + (toEnd.forward)*x + (toEnd.up)*z > 0
+	*/
+	const FTransform& actorTransform = DeftCharacter->GetActorTransform();
+	const FVector origin = actorTransform.GetLocation();
+	const FVector forward = actorTransform.GetUnitAxis(EAxis::X);
+	const FVector up = actorTransform.GetUnitAxis(EAxis::Z);
+
+	const FVector toEnd = aPathEnd - origin;
+	const VectorRegister4Float pastEndOffset = VectorSetFloat1(-toEnd.SizeSquared());
+	const VectorRegister4Float pastEndPerX = VectorSetFloat1(toEnd.Dot(forward));
+	const VectorRegister4Float pastEndPerZ = VectorSetFloat1(toEnd.Dot(up));
+	const float gravityZ = GetWorld()->GetGravityZ();
+	const VectorRegister4Float halfGravity = VectorSetFloat1(gravityZ * 0.5f);
+	const VectorRegister4Float laneSteps = MakeVectorRegisterFloat(0.f, ParabolaStepTime, ParabolaStepTime * 2.f, ParabolaStepTime * 3.f);
+
+	for (int32 angleIndex = 0; angleIndex < aAngles.Num(); ++angleIndex)
+	{
+		float angleSin, angleCos;
+		FMath::SinCos(&angleSin, &angleCos, FMath::DegreesToRadians(aAngles[angleIndex]));
+		const float velocityX = aSpeed * angleCos;
+		const float velocityZ = aSpeed * angleSin;
 
-	// vertical velocity
-	//float vY = aSpeed * FMath::Sin(rads);
-	FVector zBasis = DeftCharacter->GetActorUpVector();
-	const FVector projZ = (velocity.Dot(zBasis) / zBasis.Dot(zBasis)) * zBasis;
-	const float velocityZ = projZ.Length();
-	float deltaVZ = -(velocityZ * 2);
+		// time until we're back at the height we started from, launching downwards never gets there
+		const float airTime = gravityZ < 0.f ? (velocityZ * 2.f) / -gravityZ : -1.f;
+		if (airTime < 0.f)
+			continue;
 
-	// time
-	float deltaT = deltaVZ / gravity;
+		const int32 numSamples = FMath::Min(FMath::FloorToInt32(airTime / ParabolaStepTime) + 1, ParabolaMaxSamples);
+		TArray<FVector>& path = outPaths[angleIndex];
+		path.Reserve(numSamples);
 
-	// horizontal velocity
-	//float vX = aSpeed * FMath::Cos(rads);
-	FVector xBasis = DeftCharacter->GetActorForwardVector();
-	const FVector projX = (velocity.Dot(xBasis) / xBasis.Dot(xBasis)) * xBasis;
-	const float velocityX = projX.Length();
-	// displacement
-	float displacement = velocityX * deltaT;
+		const VectorRegister4Float velocityXs = VectorSetFloat1(velocityX);
+		const VectorRegister4Float velocityZs = VectorSetFloat1(velocityZ);
 
-	// y velocity
-	FVector yBasis = DeftCharacter->GetActorRightVector();
-	const FVector projY = (velocity.Dot(yBasis) / yBasis.Dot(yBasis)) * yBasis;
-	const float velocityY = projY.Length();
+		bool isPastEnd = false;
+		for (int32 i = 0; i < numSamples && !isPastEnd; i += 4)
+		{
+			const VectorRegister4Float times = VectorAdd(VectorSetFloat1(i * ParabolaStepTime), laneSteps);
+			const VectorRegister4Float xs = VectorMultiply(velocityXs, times);
+			const VectorRegister4Float zs = VectorMultiplyAdd(VectorMultiply(halfGravity, times), times, VectorMultiply(velocityZs, times));
+			const VectorRegister4Float pastEnd = VectorMultiplyAdd(pastEndPerZ, zs, VectorMultiplyAdd(pastEndPerX, xs, pastEndOffset));
+
+			alignas(16) float laneXs[4];
+			alignas(16) float laneZs[4];
+			alignas(16) float lanePastEnd[4];
+			VectorStoreAligned(xs, laneXs);
+			VectorStoreAligned(zs, laneZs);
+			VectorStoreAligned(pastEnd, lanePastEnd);
+
+			// the moment we go further than the end we can stop
+			for (int32 lane = 0, laneEnd = FMath::Min(4, numSamples - i); lane < laneEnd; ++lane)
+			{
+				if (lanePastEnd[lane] > 0.f)
+				{
+					isPastEnd = true;
+					break;
+				}
+				path.Emplace(origin + (forward * laneXs[lane]) + (up * laneZs[lane]));
+			}
+		}
+	}
 
 #if !UE_BUILD_SHIPPING
-	GEngine->AddOnScreenDebugMessage(-1, 0.005f, FColor::Yellow, FString::Printf(TEXT("horizontal displacement: %.2f\nair time: %.2f"), displacement, deltaT));
-	GEngine->AddOnScreenDebugMessage(-1, 0.005f, FColor::Yellow, FString::Printf(TEXT("Velocity in x: %.2f, y: %.2f, z: %.2f"), velocityX, velocityY, velocityZ));
-	DrawDebugLine(GetWorld(), PredictedOrigin, PredictedOrigin + (DeftCharacter->GetActorForwardVector() * displacement), FColor::Cyan);
-#endif//UE_BUILD_SHIPPING
-
-	// plot the trajectory
-	const float stepSize = 0.05f;
-	float time = 0.f;
-
-	outPath.Empty();
-	
-	const FVector pathEnd2D = aPathEnd * FVector(1.f, 1.f, 0.f);
-	const FVector origin2D = PredictedOrigin * FVector(1.f, 1.f, 0.f);
-	// Used to compare with each point since since will be past our attachment point which we can ignore
-	const float distToEnd2D = FMath::Abs((aPathEnd - origin2D).Length());
+	PredictedOrigin = origin;
+	PredictedDir = aDir; //TODO: we need to rotate to face aDir because that's actually where the grapple was shot
+	PredictedEnd = aPathEnd;
+	PredictedPathPoints = outPaths.Num() > 0 ? outPaths[0] : TArray<FVector>();
+#endif//!UE_BUILD_SHIPPING
+}
 
-	while (time <= deltaT)
+bool UPredictPathComponent::PredictPath_Arc(float aSpeed, float aAngle, const FVector& aDir, const FVector& aPathEnd, FDeftParabolaPath& outPath)
+{
+	if (!DeftCharacter.IsValid())
 	{
-		const float xPos = velocityX * time;
-		const float yPos = velocityY * time;
-		// NOTICE: gravity needs to be positive in this formula (for whatever reason...)
-		const float zPos = (velocityZ * time) - ((-gravity * (time * time)) / 2.f);
-		FVector pos = FVector(xPos, yPos, zPos);
-		// this ^ is the local agents position forward, so make sure we rotate it however the agent is rotated.
-		// TODO: we actually need to rotate again by the difference between agent's rotation and where the grapple actually hit
-		const FRotator actorRotation = DeftCharacter->GetActorRotation();
-		pos = pos.RotateAngleAxis(actorRotation.Pitch, -FVector::RightVector);
-		pos = pos.RotateAngleAxis(actorRotation.Yaw, FVector::UpVector);
-		pos = pos.RotateAngleAxis(actorRotation.Roll, -FVector::ForwardVector);
-		// Finally we need to translate the path to originate at our player
-		pos += PredictedOrigin;
-
-		// need to start measuring from the origin versus 0,0,0
-		const FVector pos2D = (pos) * FVector(1.f, 1.f, 0.f);
-		const float distToPos2D = FMath::Abs((pos2D - origin2D).Length());
-
-		// if the point is not between the player and the final point disregard it.
-		const FVector endToPoint = (pos - aPathEnd).GetSafeNormal();
-		const FVector playerToEnd = (aPathEnd - PredictedOrigin).GetSafeNormal();
-		const float dot = playerToEnd.Dot(endToPoint);
-
-		//DrawDebugSphere(GetWorld(), aPathEnd + (endToPoint * 100.f), 8.f, 12, FColor::Cyan, true);
-		//DrawDebugLine(GetWorld(), aPathEnd, aPathEnd + (endToPoint * 100.f), FColor::Cyan, true);
-		//DrawDebugLine(GetWorld(), PredictedOrigin, PredictedOrigin + (playerToEnd * 100.f), FColor::Magenta, true);
-
-		// Only add the path up until the end
-		if (dot <= 0)
-		{
-			UE_LOG(LogTemp, Warning, TEXT("adding pos: %s cuz %.2f"), *pos.ToString(), dot);
-			outPath.Add(pos);
-		}
-		else // the moment we go further than the end we can stop
-		{
-			UE_LOG(LogTemp, Error, TEXT("Ignoring point %s because it's %.2f, past the end"), *pos.ToString(), dot);
-			break;
-		}
-
-		time += stepSize;
+		outPath.Reset();
+		return false;
 	}
 
+	const FTransform& actorTransform = DeftCharacter->GetActorTransform();
+	const bool isValidPath = outPath.Init(actorTransform.GetLocation(), actorTransform.GetUnitAxis(EAxis::X), actorTransform.GetUnitAxis(EAxis::Z), aSpeed, aAngle, GetWorld()->GetGravityZ(), aPathEnd);
+
 #if !UE_BUILD_SHIPPING
-	PredictedPathPoints = outPath;
-#endif//UE_BUILD_SHIPPING
+	PredictedOrigin = actorTransform.GetLocation();
+	PredictedDir = aDir;
+	PredictedEnd = aPathEnd;
+	outPath.Sample(ParabolaStepTime, PredictedPathPoints);
+#endif//!UE_BUILD_SHIPPING
 
-	return false;
+	return isValidPath;
 }
 
 #if !UE_BUILD_SHIPPING
@@ -23,7 +23,12 @@ public:
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
+	// Points along the arc launched aAngle degrees up from our forward, cut off at aPathEnd. outPath keeps its allocation between calls
 	bool PredictPath_Parabola(float aSpeed, float aAngle, const FVector& aDir, const FVector& aPathEnd, TArray<FVector>& outPath);
+	// Same as above for several launch angles in one go, outPaths[i] is the path for aAngles[i]
+	void PredictPaths_Parabola(float aSpeed, TConstArrayView<float> aAngles, const FVector& aDir, const FVector& aPathEnd, TArrayView<TArray<FVector>> outPaths);
+	// The same arc as PredictPath_Parabola kept analytic, for following at a constant speed
+	bool PredictPath_Arc(float aSpeed, float aAngle, const FVector& aDir, const FVector& aPathEnd, struct FDeftParabolaPath& outPath);
 
 private:
 	TWeakObjectPtr<class ADeftPlayerCharacter> DeftCharacter;